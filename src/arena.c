@@ -0,0 +1,252 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Arena allocation
+ *
+ * Labels, comments, command names and xref entries live until the program
+ *  exits, so rather than a malloc() each they are carved from large blocks
+ *  by bumping a pointer, and never freed.  Label and name strings are also
+ *  interned, so that a name given in the command file and the label made
+ *  from it share one copy.
+ *
+ * The arena is not thread-safe and is only used from the main thread.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Data Types, Macros, Constants
+ *****************************************************************************/
+
+/* Size of each arena block, and the largest allocation carved from one;
+ * anything bigger gets a block to itself.
+ */
+#define ARENA_BLOCK         ( 64 * 1024 )
+#define ARENA_MAX_CARVE     ( ARENA_BLOCK / 4 )
+
+/* Every allocation is aligned to this */
+#define ARENA_ALIGN         ( 16 )
+
+/* Initial number of slots in the intern table (must be a power of 2) */
+#define INTERN_INIT_SIZE    ( 1024 )
+
+/*****************************************************************************
+ *        Private Data
+ *****************************************************************************/
+
+/* Free space left in the current block */
+static char   *arena_next  = NULL;
+static size_t  arena_left  = 0;
+
+/* Open-addressed hash table of interned strings.  The hash is kept with
+ * each string so that most probes need not look at the string itself.
+ */
+struct intern_slot {
+    char   *s;
+    size_t  hash;
+};
+
+static struct intern_slot *intern_tab = NULL;
+static size_t  intern_size = 0;
+static size_t  intern_used = 0;
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      intern_hash
+ *
+ * DESCRIPTION
+ *      Hashes a string (32-bit FNV-1a).
+ *
+ * RETURNS
+ *      hash of string
+ *
+ ************************************************************/
+
+static size_t intern_hash( const char *s )
+{
+    ULWORD h = 2166136261u;
+
+    while ( *s )
+        h = ( h ^ (UBYTE)*s++ ) * 16777619u;
+
+    return (size_t)h;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      intern_grow
+ *
+ * DESCRIPTION
+ *      Rebuilds the intern table with twice as many slots.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void intern_grow( void )
+{
+    struct intern_slot *old = intern_tab;
+    size_t oldsize = intern_size;
+    size_t i, j;
+
+    intern_size = oldsize ? oldsize * 2 : INTERN_INIT_SIZE;
+    intern_tab  = zalloc( intern_size * sizeof( struct intern_slot ) );
+
+    for ( i = 0; i < oldsize; i++ )
+    {
+        if ( !old[i].s )
+            continue;
+
+        for ( j = old[i].hash & ( intern_size - 1 );
+              intern_tab[j].s != NULL;
+              j = ( j + 1 ) & ( intern_size - 1 ) )
+            ;
+        intern_tab[j] = old[i];
+    }
+
+    free( old );
+}
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      arena_alloc
+ *
+ * DESCRIPTION
+ *      Allocates n bytes of zeroed memory from the arena.
+ *      The memory is never freed.
+ *
+ * RETURNS
+ *      Pointer to memory.
+ *
+ ************************************************************/
+
+void *arena_alloc( size_t n )
+{
+    void *p;
+
+    n = ( n + ARENA_ALIGN - 1 ) & ~(size_t)( ARENA_ALIGN - 1 );
+
+    if ( n > ARENA_MAX_CARVE )
+        return zalloc( n );
+
+    if ( n > arena_left )
+    {
+        arena_next = zalloc( ARENA_BLOCK );
+        arena_left = ARENA_BLOCK;
+    }
+
+    p = arena_next;
+    arena_next += n;
+    arena_left -= n;
+
+    return p;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      arena_strdup
+ *
+ * DESCRIPTION
+ *      Copies a string into the arena.
+ *
+ * RETURNS
+ *      Pointer to copy of string.
+ *
+ ************************************************************/
+
+char * arena_strdup( const char *s )
+{
+    size_t n = strlen( s ) + 1;
+    char *p = arena_alloc( n );
+
+    memcpy( p, s, n );
+    return p;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      arena_intern
+ *
+ * DESCRIPTION
+ *      Returns the one arena copy of the given string,
+ *       making it if this is the first time the string has
+ *       been seen.  The copy must not be modified.
+ *
+ * RETURNS
+ *      Pointer to interned string.
+ *
+ ************************************************************/
+
+char * arena_intern( const char *s )
+{
+    size_t i, hash = intern_hash( s );
+
+    if ( ( intern_used + 1 ) * 2 > intern_size )
+        intern_grow();
+
+    for ( i = hash & ( intern_size - 1 );
+          intern_tab[i].s != NULL;
+          i = ( i + 1 ) & ( intern_size - 1 ) )
+        if ( intern_tab[i].hash == hash && strcmp( intern_tab[i].s, s ) == 0 )
+            return intern_tab[i].s;
+
+    intern_tab[i].s    = arena_strdup( s );
+    intern_tab[i].hash = hash;
+    intern_used++;
+
+    return intern_tab[i].s;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
@@ -0,0 +1,417 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Command file reader
+ *
+ * The command file is mapped into memory and split into lines in place:
+ *  each newline is overwritten with a NUL, so the parser works directly on
+ *  the file text and there is no limit on the length of a line.  The
+ *  mapping is private, so the file itself is not changed.
+ *
+ * On hosts without mmap(), and for pipes, the file is read into a heap
+ *  buffer instead.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#define CMDFILE_NO_MMAP
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_read
+ *
+ * DESCRIPTION
+ *      Reads the whole of the named file into a heap buffer
+ *       with a spare byte at the end, so that a last line
+ *       without a newline can still be terminated in place.
+ *
+ * RETURNS
+ *      0 if successful, -1 if the file could not be read
+ *
+ ************************************************************/
+
+static int cmdfile_read( cmdfile_t *cf, const char *filename )
+{
+    FILE   *f;
+    size_t  size = 4096, n;
+
+    f = fopen( filename, "rb" );
+    if ( !f )
+        return -1;
+
+    cf->data   = zalloc( size );
+    cf->length = 0;
+
+    while ( ( n = fread( cf->data + cf->length, 1, size - cf->length - 1, f ) ) > 0 )
+    {
+        cf->length += n;
+        if ( cf->length + 1 == size )
+        {
+            size *= 2;
+            cf->data = realloc( cf->data, size );
+            if ( !cf->data )
+                error( "Out of memory for command file" );
+        }
+    }
+
+    fclose( f );
+    cf->mapped = 0;
+    return 0;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      isspc
+ *
+ * DESCRIPTION
+ *      Tests for whitespace, independent of the locale.
+ *
+ * RETURNS
+ *      non-zero if c is whitespace
+ *
+ ************************************************************/
+
+static int isspc( int c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_open
+ *
+ * DESCRIPTION
+ *      Maps the named command file, ready to be read one
+ *       line at a time with cmdfile_getline().
+ *
+ * RETURNS
+ *      0 if successful, -1 if the file could not be opened
+ *
+ ************************************************************/
+
+int cmdfile_open( cmdfile_t *cf, const char *filename )
+{
+    memset( cf, 0, sizeof( *cf ) );
+    cf->name = filename;
+
+#ifdef CMDFILE_NO_MMAP
+    return cmdfile_read( cf, filename );
+#else
+    {
+        int fd;
+        struct stat st;
+        void *p;
+
+        fd = open( filename, O_RDONLY );
+        if ( fd < 0 )
+            return -1;
+
+        if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) || st.st_size == 0 )
+        {
+            /* Pipes and empty files cannot be mapped */
+            close( fd );
+            return cmdfile_read( cf, filename );
+        }
+
+        p = mmap( NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+        close( fd );
+
+        if ( p == MAP_FAILED )
+            return cmdfile_read( cf, filename );
+
+        cf->data   = p;
+        cf->length = (size_t)st.st_size;
+        cf->mapped = 1;
+        return 0;
+    }
+#endif
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_getline
+ *
+ * DESCRIPTION
+ *      Returns the next line of the command file, with its
+ *       newline replaced by a NUL.  The line stays valid
+ *       until the file is closed.  cf->start is set to the
+ *       offset of the line in cf->data and cf->lineno to
+ *       its line number.
+ *
+ * RETURNS
+ *      pointer to line, or NULL at end of file
+ *
+ ************************************************************/
+
+char *cmdfile_getline( cmdfile_t *cf )
+{
+    char   *line, *nl;
+    size_t  left;
+
+    if ( cf->pos >= cf->length )
+        return NULL;
+
+    line = cf->data + cf->pos;
+    left = cf->length - cf->pos;
+
+    cf->start = cf->pos;
+    cf->lineno++;
+
+    nl = memchr( line, '\n', left );
+    if ( nl )
+    {
+        *nl = '\0';
+        cf->pos += (size_t)( nl - line ) + 1;
+        return line;
+    }
+
+    /* Last line has no newline.  A heap buffer has room for the NUL, the
+     * end of a mapping might not.
+     */
+    cf->pos = cf->length;
+    if ( !cf->mapped )
+    {
+        line[left] = '\0';
+        return line;
+    }
+
+    cf->tail = zalloc( left + 1 );
+    memcpy( cf->tail, line, left );
+    return cf->tail;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_close
+ *
+ * DESCRIPTION
+ *      Releases the command file.  Lines returned by
+ *       cmdfile_getline() are no longer valid.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void cmdfile_close( cmdfile_t *cf )
+{
+#ifndef CMDFILE_NO_MMAP
+    if ( cf->mapped )
+        munmap( cf->data, cf->length );
+    else
+#endif
+        free( cf->data );
+
+    free( cf->tail );
+    memset( cf, 0, sizeof( *cf ) );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_hash
+ *
+ * DESCRIPTION
+ *      Hashes the contents of the command file (64-bit
+ *       FNV-1a).  Must be called before any lines are read,
+ *       as reading changes the newlines in place.
+ *
+ * RETURNS
+ *      hash of file contents
+ *
+ ************************************************************/
+
+unsigned long long cmdfile_hash( const cmdfile_t *cf )
+{
+    unsigned long long h = 14695981039346656037ULL;
+    const UBYTE *p = (const UBYTE *)cf->data;
+    size_t i;
+
+    for ( i = 0; i < cf->length; i++ )
+        h = ( h ^ p[i] ) * 1099511628211ULL;
+
+    return h;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_hex
+ *
+ * DESCRIPTION
+ *      Scans a hexadecimal number, after any whitespace and
+ *       with an optional "0x" prefix, and moves *p past it.
+ *
+ * RETURNS
+ *      1 if a number was found, else 0 and *p is unchanged
+ *
+ ************************************************************/
+
+int cmdfile_hex( char **p, unsigned long *val )
+{
+    char *s = *p;
+    unsigned long v = 0;
+    int d;
+
+    while ( isspc( *s ) )
+        s++;
+
+    if ( s[0] == '0' && ( s[1] == 'x' || s[1] == 'X' ) && cmdfile_hexval( s[2] ) >= 0 )
+        s += 2;
+
+    if ( cmdfile_hexval( *s ) < 0 )
+        return 0;
+
+    while ( ( d = cmdfile_hexval( *s ) ) >= 0 )
+    {
+        v = ( v << 4 ) | (unsigned long)d;
+        s++;
+    }
+
+    *val = v;
+    *p   = s;
+    return 1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_dec
+ *
+ * DESCRIPTION
+ *      Scans a decimal number, after any whitespace and with
+ *       an optional sign, and moves *p past it.
+ *
+ * RETURNS
+ *      1 if a number was found, else 0 and *p is unchanged
+ *
+ ************************************************************/
+
+int cmdfile_dec( char **p, long *val )
+{
+    char *s = *p;
+    long v = 0;
+    int neg = 0;
+
+    while ( isspc( *s ) )
+        s++;
+
+    if ( *s == '-' || *s == '+' )
+        neg = ( *s++ == '-' );
+
+    if ( *s < '0' || *s > '9' )
+        return 0;
+
+    while ( *s >= '0' && *s <= '9' )
+        v = v * 10 + ( *s++ - '0' );
+
+    *val = neg ? -v : v;
+    *p   = s;
+    return 1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_hexval
+ *
+ * DESCRIPTION
+ *      Gives the value of a hexadecimal digit.
+ *
+ * RETURNS
+ *      0 to 15, or -1 if c is not a hex digit
+ *
+ ************************************************************/
+
+int cmdfile_hexval( int c )
+{
+    if ( c >= '0' && c <= '9' )
+        return c - '0';
+    if ( c >= 'a' && c <= 'f' )
+        return c - 'a' + 10;
+    if ( c >= 'A' && c <= 'F' )
+        return c - 'A' + 10;
+    return -1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmdfile_has_ext
+ *
+ * DESCRIPTION
+ *      Tests whether a file name ends in the given extension,
+ *       ignoring case.
+ *
+ * RETURNS
+ *      non-zero if it does
+ *
+ ************************************************************/
+
+int cmdfile_has_ext( const char *name, const char *ext )
+{
+    const char *dot = strrchr( name, '.' );
+
+    return dot && strcasecmp( dot, ext ) == 0;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
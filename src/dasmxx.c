@@ -52,6 +52,22 @@
  *      -a         - generate assembler source output
  *      -s         - generate stripped assembler output (forces -a)
  *      -o foo     - write output to file "foo" (default is stdout)
+ *      -j N       - render the listing with N threads
+ *      -d         - discover code from the entry points and write out
+ *                    a command list instead of the listing (with -j N
+ *                    the discovery runs on N threads)
+ *      -c foo     - cache the parsed command file in "foo", and use the
+ *                    cache instead of parsing while the command file and
+ *                    its includes are unchanged
+ *      -y foo     - import the symbols in "foo" as labels (see below);
+ *                    may be given more than once
+ *      -X fmt:foo - export the cross-references to "foo" ("-" for
+ *                    stdout) as fmt: jsonl, csv or bin
+ *      -q query   - decode without writing the listing and answer the
+ *                    cross-reference query (see xref_query()); may be
+ *                    given more than once
+ *      -T N       - benchmark the decoder: time N passes over the
+ *                    command list with and without text formatting
  *
  * The command list file contains a list of memory segment definitions, used during
  *  processing to tell the disassembler what the memory at a particular address
@@ -60,8 +76,16 @@
  * The commands are (where XXXX denotes hexadecimal field):
  *
  * File commands:
- *      fName       input file = `Name'
+ *      fName       input file = `Name' (flat binary, ELF, or Intel HEX
+ *                   or S-record by extension: see loader.c); the
+ *                   symbols and entry point of an ELF file are used
+ *      fName @XXXX[,L/N]  flat binary input file loaded at XXXX, or
+ *                   as byte lane L of an image interleaved across N
+ *                   files; there may be several of these
+ *      oXXXX-YYYY  banked address space, with CPU addresses XXXX to
+ *                   YYYY the banked window (see below)
  *      iName       include file `Name' in place of include command
+ *      yName       import labels from symbol file `Name'
  *      >XXXX       fast forward to offset XXXX from start of file
  *
  * Configuration commands:
@@ -75,9 +99,11 @@
  *      mXXXX       bitmap
  *      sXXXX       string dump
  *      uXXXX       string dump with 16-bit characters (utf-16)
- *      vXXXX       vector address dump
+ *      vXXXX       vector address dump (dasm_vector_bytes per vector)
  *      wXXXX       word dump
- *      zXXXX       skip (emits a SKIP with the number of bytes). Source must already be 0-filled.
+ *      zXXXX       skip (emits a SKIP with the number of bytes). Source must already be 0-filled
+ *                   or a gap in a HEX or S-record image.
+ *      xXXXX       omit everything up to the next command from the listing
  *
  * Code disassembly commands:
  *      cXXXX       code disassembly starts at XXXX
@@ -110,6 +136,34 @@
  *   will generate a name for you: "AL_nnnn" for labels, and "PROC_nnnn" for 
  *     procedures.
  *
+ *  In a banked address space (the 'o' command) any address in a command
+ *   may be given as BB:XXXX, for CPU address XXXX in bank BB.  Only the
+ *   banked window has more than one bank; common memory is bank 0, as is
+ *   an address given without a bank.  Each bank has its own labels and
+ *   xrefs, and a reference from a bank to the window is taken to be to
+ *   the same bank.  Jumps and calls from common memory into the window
+ *   are annotated, as their target depends on the bank mapped in.  For
+ *   example:
+ *
+ *       o4000-7fff
+ *       fcommon.bin @0000
+ *       fbank1.bin @01:4000
+ *       c0000
+ *       x4000
+ *       p01:4000  Bank1Entry
+ *
+ *   Each bank after bank 0 that has commands is ended by an 'x' at the end
+ *   of the window, added if there is not one, so the banks are rendered
+ *   (and split between threads by -j) one after the other, and discovery
+ *   (-d) works on each bank separately.
+ *
+ *  The 'y' command and -y option import labels in bulk from a GNU ld map
+ *   (.map), NoICE (.sym, .noi) or CSV (.csv, "name,value") file, or from
+ *   the symbol table of an ELF file.  Values are in the same units as
+ *   command file addresses.  Where a symbol file gives several names for
+ *   one address the first is used, and a label from the command file
+ *   always takes precedence over an imported one.
+ *
  *****************************************************************************/
 
 #include <stdio.h>
@@ -119,6 +173,9 @@
 #include <unistd.h> /* for getopt */
 #include <ctype.h>
 #include <stdint.h>
+#include <time.h>
+#include <setjmp.h>
+#include <pthread.h>
 
 #include "dasmxx.h"
 
@@ -126,11 +183,29 @@
  *        Data Types, Macros, Constants
  *****************************************************************************/
 
-/* Comment list type */
+/* Comment list type.  Comments are collected as they are read and sorted
+ * into address order by sortcomments() before rendering starts.
+ */
 struct comment {
-    int              ref;
+    ADDR             ref;
     char            *text;
-    struct comment  *next;
+};
+
+struct commentlist {
+    struct comment  *item;
+    size_t           n;
+    size_t           size;
+};
+
+/* Initial size of a comment list array */
+#define COMMENTS_INIT   ( 64 )
+
+/* Position in a comment list.  Rendering visits addresses in increasing
+ * order, so each lookup carries on from where the last one stopped.
+ */
+struct comment_cursor {
+    const struct commentlist *list;
+    size_t                    pos;
 };
 
 /* Dump format list type */
@@ -139,41 +214,209 @@ struct fmt {
     ADDR             addr;
     unsigned int     bpl; /* bytes per line */
     char            *name;
-    struct fmt      *n;
 };
 
+/* Initial size of the command list array */
+#define CMDLIST_INIT    ( 256 )
+
 struct params {
     const char * listfile;
-    const char * inputfile;
+    struct image_input *inputs; /* Input files, from f commands     */
+    size_t       ninputs;
+    size_t       inputs_size;
     const char * outputfile;
-    struct fmt * cmdlist;
+    const char * cachefile;
+    const char **symfiles;      /* Symbol files from -y             */
+    int          nsymfiles;
+    const char * xrefexport;    /* Export file from -X, or NULL     */
+    XREF_FORMAT  xrefformat;
+    const char **queries;       /* Xref queries from -q             */
+    int          nqueries;
+    int          bench_passes;  /* Decoder benchmark passes, from -T*/
+    struct fmt * cmdlist;       /* Commands, in address order once  */
+    size_t       ncmds;         /*  read in                         */
+    size_t       cmds_size;
+    int          has_entry;     /* Entry point of an ELF input file */
+    ADDR         entry;
     
     int want_xref;
     int want_asm_out;
     int want_stripped;
+    int want_discover;
+    int jobs;
+};
+
+/* Parallel rendering limits */
+#define ERRMSG_LEN      256
+#define CHUNKS_PER_JOB  4       /* Chunks per thread, for load balancing */
+
+/* Where rendering of the command list has got to.  cmd is the index of
+ * the next command boundary.  If at_top is clear the renderer has just
+ * moved on to a new command and renders from addr before looking at cmd
+ * again.
+ */
+struct render_state {
+    ADDR          addr;
+    int           mode;
+    unsigned int  bpl;
+    char         *name;
+    size_t        cmd;
+    int           at_top;
+};
+
+/* A cross reference recorded by a worker thread */
+struct xref_rec {
+    XREF_TYPE   type;
+    ADDR        addr;
+    ADDR        ref;
+};
+
+/* Part of the command list rendered by a worker thread */
+struct chunk {
+    struct render_state  start;     /* State assumed at start         */
+    struct render_state  end;       /* State at end                   */
+    size_t               stop;      /* Boundary that ends this chunk  */
+    int                  ctx_state; /* Decoder context state at end   */
+    int                  ctx_tos;
+    OPC                  ctx_opcstack[DASM_STACK_DEPTH];
+    out_capture_t        out;       /* Rendered text                  */
+    struct xref_rec     *xrefs;     /* Xrefs found, in order          */
+    size_t               nxrefs;
+    size_t               xrefs_size;
+    int                  failed;    /* Set if error() was called      */
+    char                 errmsg[ERRMSG_LEN];
+};
+
+/* Work shared by the worker threads */
+struct render_job {
+    struct params   *params;
+    struct chunk    *chunks;
+    int              nchunks;
+    int              next;          /* Next chunk to render           */
+    pthread_mutex_t  lock;
+};
+
+/* Set in worker threads so that error() returns the message to the
+ * renderer instead of exiting.
+ */
+struct error_trap {
+    jmp_buf     env;
+    char        msg[ERRMSG_LEN];
+};
+
+/* Command cache file.  Holds what readlist() made of a command file so
+ * that it can be used again without parsing while the command file and
+ * its includes are unchanged.  The header is followed by the arrays it
+ * counts, in order, then the string table.  All fields are ULWORDs in
+ * host byte order; strings are offsets into the string table.
+ */
+#define CACHE_MAGIC     "DASMXXC4"
+#define CACHE_NONE      ( 0xFFFFFFFFu )
+
+struct cache_header {
+    char    magic[8];
+    ULWORD  word_width;     /* dasm_word_width_bytes            */
+    ULWORD  dasm;           /* dasm_name                        */
+    ULWORD  nfiles;         /* Command file, then its includes  */
+    ULWORD  ncmds;
+    ULWORD  nlabels;        /* In the order they were added     */
+    ULWORD  nlinecmts;
+    ULWORD  nblockcmts;
+    ULWORD  ninputs;
+    ULWORD  terminator;
+    ULWORD  file_offset;
+    ULWORD  pagination;
+    ULWORD  page_title;
+    ULWORD  banked;         /* Banked window from o command     */
+    ULWORD  bank_lo;
+    ULWORD  bank_hi;
+    ULWORD  strings;        /* Size of string table             */
+};
+
+struct cache_file {
+    ULWORD  name;
+    ULWORD  length;
+    ULWORD  hash[2];        /* Low word first                   */
+};
+
+struct cache_input {
+    ULWORD  name;
+    ULWORD  placed;
+    ULWORD  addr;
+    ULWORD  lane;
+    ULWORD  lanes;
+};
+
+struct cache_cmd {
+    ULWORD  addr;
+    ULWORD  mode;
+    ULWORD  bpl;
+    ULWORD  name;
+};
+
+/* A label or a comment */
+struct cache_ref {
+    ULWORD  addr;
+    ULWORD  text;
+    ULWORD  flags;
+};
+
+#define CACHE_IMPORTED  ( 0x01 )    /* Label from a symbol file */
+
+/* Files read and labels added by readlist(), recorded for the cache */
+struct cache_rec {
+    char               *name;
+    ADDR                addr;
+    size_t              length;
+    unsigned long long  hash;
+    int                 imported;
+};
+
+struct cmdcache {
+    int                 recording;  /* Set while readlist() runs */
+    struct cache_rec   *files;
+    size_t              nfiles;
+    size_t              files_size;
+    struct cache_rec   *labels;
+    size_t              nlabels;
+    size_t              labels_size;
+    cmdfile_t           map;        /* Cache file, once loaded  */
+};
+
+/* String table being built for a cache file */
+struct strtab {
+    char   *buf;
+    size_t  len;
+    size_t  size;
 };
 
 /* Set various physical limits */
 #define BYTES_PER_LINE  16
-#define NOTE_BUF_INIT   4096
 #define COL_LINECOMMENT 60
 
-#define COMMENT_DELIM        ";"
-
 #define SWAP(a,b)   do { int t = a; a = b; b = t; } while(0)
 
 /*****************************************************************************
  *        Global Data
  *****************************************************************************/
 
-struct comment  *linecmt    = NULL;
-struct comment  *blockcmt   = NULL;
+static THREAD_LOCAL struct error_trap *error_trap = NULL;
+
+static struct commentlist linecmt;
+static struct commentlist blockcmt;
+
+static struct cmdcache cmdcache;
 
 int             string_terminator = '\0';
 unsigned int    file_offset = 0;
 
+/* Banked window from the o command, inclusive CPU addresses */
+static int      banked = 0;
+static ADDR     bank_lo = 0;
+static ADDR     bank_hi = 0;
+
 /* List of display modes.  Defines must match entry position. */
-static char datchars[] = "cbsewapvmuz";
+static char datchars[] = "cbsewapvmuzx";
 #define CODE            0
 #define BYTES           1
 #define STRINGS         2
@@ -185,10 +428,7 @@ static char datchars[] = "cbsewapvmuz";
 #define BITMAPS         8
 #define WSTRING         9
 #define SKIP            10
-
-/* Global instruction byte buffer */
-static UBYTE *insn_byte_buffer = NULL;
-static UBYTE  insn_byte_idx    = 0;
+#define OMIT            11
 
 /* Pagination Formatting */
 static int pagination   = 0;
@@ -201,167 +441,221 @@ static const char *page_title = NULL;
  *        Private Functions
  *****************************************************************************/
 
+/***********************************************************
+ *
+ * FUNCTION
+ *      mkvector
+ *
+ * DESCRIPTION
+ *      Makes a vector from its dasm_vector_bytes bytes, in the
+ *       order they are in memory, keeping only the bits that
+ *       fit the address space.
+ *
+ * RETURNS
+ *      the vector
+ *
+ ************************************************************/
+
+static ADDR mkvector( const UBYTE *b )
+{
+    ADDR v = 0;
+    int  k;
+
+    for ( k = 0; k < dasm_vector_bytes; k++ )
+        v |= (ADDR)b[k] << ( 8 * ( dasm_word_msb_first ? dasm_vector_bytes - 1 - k : k ) );
+
+    /* Bits above the address space (e.g. the top byte of a 68000
+     * pointer) are not part of the address.
+     */
+    if ( 4 * dasm_addr_digits < 8 * (int)sizeof( ADDR ) )
+        v &= ( 1u << ( 4 * dasm_addr_digits ) ) - 1;
+
+    return v;
+}
+
 /***********************************************************
  *
  * FUNCTION
  *      addcomment
  *
  * DESCRIPTION
- *      Adds a single-line comment to the given list.
+ *      Adds a comment to the end of the given list.
+ *      The list is put into address order by sortcomments()
+ *       once it has all been read.
  *
  * RETURNS
  *      void
  *
  ************************************************************/
 
-static void addcomment( struct comment **list, ADDR ref, char *text )
+static void addcomment( struct commentlist *list, ADDR ref, char *text )
 {
-    struct comment *p = *list;
-    struct comment *q = NULL;
+    struct comment *q;
 
-    /* Find entry in specified comment list */
-    while ( p != NULL && ref > p->ref )
+    if ( list->n == list->size )
     {
-        q = p;
-        p = p->next;
+        list->size = list->size ? list->size * 2 : COMMENTS_INIT;
+        list->item = realloc( list->item, list->size * sizeof( struct comment ) );
+        if ( !list->item )
+            error( "Out of memory for comment list" );
     }
 
-    if ( p != NULL && ref == p->ref)  /* new addr for ref */
-    {
-        if ( p->text )
-            error( "Multiple comments for same address ($%04X)", ref );
-
-        p->text = dupstr( text );
-    }
-    else /* insert */
-    {
-        if ( q == NULL )
-        {
-            q = zalloc( sizeof( struct comment ) );
-            *list = q;
-        }
-        else
-        {
-            q->next = zalloc( sizeof( struct comment ) );
-            q = q->next;
-        }
-        q->next  = p;
-        q->ref   = ref;
-        q->text  = dupstr( text );
-    }
+    q = &list->item[list->n++];
+    q->ref  = ref;
+    q->text = arena_strdup( text );
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      emit_page_header
+ *      cmpcomment
  *
  * DESCRIPTION
- *      Output page header, comprising a page number and an
- *      optional title.
- */
-static void emit_page_header( void )
+ *      qsort() comparison function for comments.
+ *
+ * RETURNS
+ *      <0, 0 or >0 as a is before, at or after b
+ *
+ ************************************************************/
+
+static int cmpcomment( const void *a, const void *b )
 {
-    static int page_no = 1;
+    ADDR ra = ((const struct comment *)a)->ref;
+    ADDR rb = ((const struct comment *)b)->ref;
 
-    if ( pagination )
-    {
-        printf( "%s Page %d", COMMENT_DELIM, page_no++ );
-        if ( page_title )
-            printf( " -- %s", page_title ); 
-        printf( "\n\n" );
-    }
+    return ( ra > rb ) - ( ra < rb );
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      newline
+ *      sortcomments
  *
  * DESCRIPTION
- *      Output a newline.  Also do pagination if required.
- */
-static void newline( void )
+ *      Sorts a comment list into address order, unless it
+ *       is already in order.  Only one comment is allowed
+ *       for each address.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void sortcomments( struct commentlist *list )
 {
-    static int n = 0;
+    size_t i;
+
+    for ( i = 1; i < list->n && list->item[i - 1].ref <= list->item[i].ref; i++ )
+        ;
+
+    if ( i < list->n )
+        qsort( list->item, list->n, sizeof( struct comment ), cmpcomment );
+
+    for ( i = 1; i < list->n; i++ )
+        if ( list->item[i - 1].ref == list->item[i].ref )
+            error( "Multiple comments for same address ($%s)",
+                   OUT_ADDRSTR( list->item[i].ref / dasm_word_width_bytes ) );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      comment_seek
+ *
+ * DESCRIPTION
+ *      Points a cursor at the first comment in the list at
+ *       or after the given address.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
 
-    putchar( '\n' ); n++;
+static void comment_seek( struct comment_cursor *cur,
+                          const struct commentlist *list, ADDR ref )
+{
+    size_t lo = 0, hi = list->n, mid;
 
-    if ( pagination && n >= pagination )
+    while ( lo < hi )
     {
-        n = 0;
-        printf( "\f" );
-        emit_page_header();
+        mid = lo + ( hi - lo ) / 2;
+        if ( list->item[mid].ref < ref )
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+
+    cur->list = list;
+    cur->pos  = lo;
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      printcomment
+ *      comment_find
  *
  * DESCRIPTION
- *      Searches the given comment list for an entry at
- *       the given address.  If found, prints it.
+ *      Moves the cursor forward to the given address and
+ *       returns the comment there, if any.  Going back to
+ *       an earlier address costs a fresh seek.
  *
  * RETURNS
- *      0 if no comment, else 1
+ *      comment text, or NULL if no comment
  *
  ************************************************************/
 
-static int printcomment( struct comment *list, ADDR ref, unsigned int padding )
+static const char *comment_find( struct comment_cursor *cur, ADDR ref )
 {
-    int i;
-    char *p;
-    struct comment *plist = list;
-    
-    for ( ; plist; plist = plist->next )
-    {
-        if ( plist->ref == ref )
-        {
-            printf( "%*s ", padding, COMMENT_DELIM );
-            for ( p = plist->text; *p; p++ )
-            {
-                if ( *p == '\n' )
-                {
-                    newline();
-                    printf( "%*s ", padding, COMMENT_DELIM );
-                }
-                else
-                    putchar( *p );
-            }
-            
-            if ( list == blockcmt )
-                newline();
+    const struct commentlist *list = cur->list;
 
-            return 1;
-        }
-    }    
+    if ( cur->pos > 0 && list->item[cur->pos - 1].ref >= ref )
+        comment_seek( cur, list, ref );
+
+    while ( cur->pos < list->n && list->item[cur->pos].ref < ref )
+        cur->pos++;
 
-    return 0;
+    if ( cur->pos < list->n && list->item[cur->pos].ref == ref )
+        return list->item[cur->pos].text;
+
+    return NULL;
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      commentexists
+ *      printcomment
  *
  * DESCRIPTION
- *      Searches the given comment list for an entry at
- *       the given address.  If found, returns 1, else 0.
+ *      Looks up the comment at the given address using the
+ *       cursor.  If found, prints it.
  *
  * RETURNS
  *      0 if no comment, else 1
  *
  ************************************************************/
 
-static int commentexists( struct comment *list, ADDR ref )
+static int printcomment( struct comment_cursor *cur, ADDR ref, unsigned int padding )
 {
-    for ( ; list; list = list->next )
-        if ( list->ref == ref )
-            return 1;
+    const char *p, *q;
 
-    return 0;
+    if ( ( p = comment_find( cur, ref ) ) == NULL )
+        return 0;
+
+    out_padstr( COMMENT_DELIM, (int)padding );
+    out_char( ' ' );
+    for ( ; ( q = strchr( p, '\n' ) ) != NULL; p = q + 1 )
+    {
+        out_strn( p, q - p );
+        out_newline();
+        out_padstr( COMMENT_DELIM, (int)padding );
+        out_char( ' ' );
+    }
+    out_str( p );
+
+    if ( cur->list == &blockcmt )
+        out_newline();
+
+    return 1;
 }
 
 /***********************************************************
@@ -382,16 +676,24 @@ static int emitaddr( ADDR addr, struct params *params )
 {
     char * label = xref_findaddrlabel( addr );
 
+    unsigned long start;
+
     if ( label )
     {
-        printf( "%s:", label );
-        newline();
+        out_str( label );
+        out_char( ':' );
+        out_newline();
     }
 
     if ( !params->want_stripped )
-        return printf( "%c   " FORMAT_ADDR ":    ", 
-            params->want_asm_out ? ';' : ' ',
-            addr / dasm_word_width_bytes);
+    {
+        start = out_count();
+        out_char( params->want_asm_out ? ';' : ' ' );
+        out_spaces( 3 );
+        out_addr( addr / dasm_word_width_bytes );
+        out_str( ":    " );
+        return (int)( out_count() - start );
+    }
     else
         return 0;
 }
@@ -402,380 +704,2062 @@ static int emitaddr( ADDR addr, struct params *params )
  *      addlist
  *
  * DESCRIPTION
- *      adds an item to the dump formating list
+ *      adds an item to the end of the dump formatting list.
+ *      The list is put into address order by sortlist() once
+ *       it has all been read.
+ *      name is kept as given, so must be interned.
  *
  * RETURNS
  *      void
  *
  ************************************************************/
 
-static void addlist( struct fmt **list, ADDR addr, int mode, unsigned int bytes_per_line, char *name )
+static void addlist( struct params *params, ADDR addr, int mode, unsigned int bytes_per_line, char *name )
 {
-    struct fmt *p = *list, *q = NULL;
-
-    /* scan through address-ordered list to find right place to insert */
-    while ( p != NULL && p->addr < addr )
-    {
-        q = p;
-        p = p->n;
-    }
+    struct fmt *q;
 
-    if ( q == NULL )
+    if ( params->ncmds == params->cmds_size )
     {
-        /* Insert at head of list */
-        q = zalloc( sizeof( struct fmt ) );
-        *list = q;
-    }
-    else
-    {
-        /* Insert within list */
-        q->n = zalloc( sizeof( struct fmt ) );
-        q = q->n;
+        params->cmds_size = params->cmds_size ? params->cmds_size * 2 : CMDLIST_INIT;
+        params->cmdlist   = realloc( params->cmdlist, params->cmds_size * sizeof( struct fmt ) );
+        if ( !params->cmdlist )
+            error( "Out of memory for command list" );
     }
 
     /* Fill in the blanks */
+    q = &params->cmdlist[params->ncmds++];
     q->addr = addr;
     q->mode = mode;
-    q->n    = p;
     q->bpl  = bytes_per_line;
-    if ( name != NULL )
-        q->name = dupstr( name );
-    else
-        q->name = NULL;
+    q->name = name;
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      readlist
+ *      addinput
  *
  * DESCRIPTION
- *      reads and parses the listfile
+ *      adds an input file to the end of the input list.
  *
  * RETURNS
- *      none
+ *      void
  *
  ************************************************************/
 
-#define LINE_BUF_LEN        ( 256 )
-#define SKIP_SPACE(M_p)    do {\
-                               while(*M_p && isspace((unsigned char)*M_p))\
-                                   M_p++;\
-                           } while(0)
+static void addinput( struct params *params, const struct image_input *in )
+{
+    if ( params->ninputs == params->inputs_size )
+    {
+        params->inputs_size = params->inputs_size ? params->inputs_size * 2 : 4;
+        params->inputs      = realloc( params->inputs, params->inputs_size * sizeof( struct image_input ) );
+        if ( !params->inputs )
+            error( "Out of memory for input list" );
+    }
 
-#define MAX_INCLUDE_DEPTH   16
+    params->inputs[params->ninputs++] = *in;
+}
 
-static void readlist( const char *listfile, struct params *params )
-{
-    static int include_depth = 0;
-    FILE *f;
-    char buf[LINE_BUF_LEN + 1], *pbuf, *q;
-    ADDR addr;
-    int cmd;
-    int n;
-    char *notebuf = NULL;
-    int notelength;
-    int notebufsize = 0;
-    unsigned int lineno = 0;
-   
-    enum {
-        LINE_CMD,
-        LINE_NOTE
-    } linemode = LINE_CMD;
-    
-    if ( !listfile )
-        error( "No listfile specifed" );
+/***********************************************************
+ *
+ * FUNCTION
+ *      sortlist
+ *
+ * DESCRIPTION
+ *      Sorts the dump formatting list into address order.
+ *      The sort is a stable merge sort, so commands for the
+ *       same address stay in the order they were read, and
+ *       a list that is already in order is left alone.
+ *      Of several commands for one address the last is kept,
+ *       with a warning.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
 
-    if ( ++include_depth > MAX_INCLUDE_DEPTH )
-        error( "Include nesting too deep (limit is %d)", MAX_INCLUDE_DEPTH );
+static void sortlist( struct params *params )
+{
+    struct fmt *a = params->cmdlist, *b, *t;
+    size_t n = params->ncmds;
+    size_t width, i, j, k, lo, mid, hi;
 
-    f = fopen( listfile, "r" );
-    if ( !f )
-        error( "Failed to open list command file \"%s\"", listfile );
+    for ( i = 1; i < n && a[i - 1].addr <= a[i].addr; i++ )
+        ;
 
-    /* Process each line of list file */
-    while ( lineno++, ( pbuf = fgets( buf, LINE_BUF_LEN, f ) ) != NULL )
+    if ( i < n )
     {
-        if ( linemode == LINE_CMD )
-        {
-            /* strip leading whitespace */
-            SKIP_SPACE(pbuf);
-            
-            /* Skip comment and blank lines */
-            if ( *pbuf == '#' || *pbuf == '\n' || *pbuf == '\r' )
-                continue;
-
-            /* Remove trailing newline/carriage-return chars (handle CRLF) */
-            if ( (q = strchr( pbuf, '\n' )) )
-                *q = '\0';
-            if ( (q = strchr( pbuf, '\r' )) )
-                *q = '\0';
+        b = zalloc( n * sizeof( struct fmt ) );
 
-            /* Peel off command code, then do something about it */
-            cmd = *pbuf++;
-            cmd = tolower( (unsigned char)cmd ); /* Be case-agnostic */
-            switch ( cmd )
+        for ( width = 1; width < n; width *= 2 )
+        {
+            for ( lo = 0; lo < n; lo += 2 * width )
             {
-            case 0: break; /* Catch blank line at end of file */
+                mid = MIN( lo + width, n );
+                hi  = MIN( lo + 2 * width, n );
 
-            case 'a': /* alphanumeric character dump */
-            case 'b': /* byte dump                   */
-            case 'c': /* start of code disassembly   */
-            case 'e': /* end of processing           */
-            case 'p': /* start of procedure          */
-            case 's': /* string dump                 */
-            case 'v': /* vector dump                 */
-            case 'w': /* word dump                   */
-            case 'm': /* bitmap dump                 */
-            case 'u': /* widechar string dump        */
-            case 'z': /* skip empty areas            */
+                for ( i = lo, j = mid, k = lo; k < hi; k++ )
                 {
-                    unsigned int cmd_idx = strchr( datchars, cmd ) - datchars;
-                    unsigned bytes_per_line = BYTES_PER_LINE;
-                    sscanf( pbuf, "%x%n", &addr, &n );
-                    addr *= dasm_word_width_bytes;
-                    pbuf += n;
-                    
-                    if ( *pbuf == ',' )
-                    {
-                        unsigned int count;
-                        
-                        if ( cmd != 'b' )
-                            error( "%s(%u) :: Byte count not supported for command '%c'", listfile, lineno, cmd );
-                        
-                        pbuf++;
-                        sscanf( pbuf, "%u%n", &count, &n );
-                        pbuf += n;
-                        
-                        if ( count > BYTES_PER_LINE )
-                            error( "%s(%u) :: Too many bytes per line (limit is %d)", listfile, lineno, BYTES_PER_LINE );
-                            
-                        bytes_per_line = count;
-                    }
-
-                    SKIP_SPACE(pbuf);
-                        
-                    /* If user has provided an optional name for this entity then
-                     * store it in the xref database.
-                     */
-                    if ( !*pbuf )
-                    {
-                        static struct {
-                            char *pfx;
-                            unsigned int num;
-                        } tbl[] = {
-                            { "CL",      1 },
-                            { "BDATA",   1 }, 
-                            { "STRING",  1 },
-                            { NULL,      0 }, /* END */
-                            { "WDATA",   1 },
-                            { "CDATA",   1 },
-                            { "PROC",    1 },
-                            { "VCTR",    1 },
-                            { "BMAP",    1 },
-                            { "WSTRING", 1 },
-                            { "SKIP",    1 }
-                        };
-
-                        if ( tbl[cmd_idx].pfx )
-                            snprintf( pbuf, buf + sizeof(buf) - pbuf, GEN_LABEL_PREFIX "%s_%04d", tbl[cmd_idx].pfx, tbl[cmd_idx].num++ );
-                    }
-                    
-                    /* Add a cross-ref entry for everything except an end entry */
-                    if ( cmd != 'e' )
-                        xref_addxreflabel( addr, pbuf );
-
-                    addlist( &(params->cmdlist), 
-                                addr, 
-                                cmd_idx, 
-                                bytes_per_line,
-                                pbuf );
+                    if ( i < mid && ( j >= hi || a[i].addr <= a[j].addr ) )
+                        b[k] = a[i++];
+                    else
+                        b[k] = a[j++];
                 }
-                break;
+            }
+            t = a; a = b; b = t;
+        }
 
-            case 'f':  /* inputfile */
-                if ( params->inputfile )
-                    error( "%s(%u) :: Multiple input files specified", listfile, lineno );
-                params->inputfile = (const char *)dupstr( pbuf );
-                break;
+        free( b );
+        params->cmdlist = a;
+    }
+
+    /* Drop all but the last of each run of commands for one address.  The
+     * names are not freed as they may be in the command cache mapping.
+     */
+    for ( i = 0, k = 0; i < n; i = j + 1 )
+    {
+        for ( j = i; j + 1 < n && a[j + 1].addr == a[i].addr; j++ )
+            ;
+        if ( j > i )
+            warning( "%u commands for address %s, using the last ('%c')",
+                     (unsigned int)( j - i + 1 ),
+                     OUT_ADDRSTR( a[i].addr / dasm_word_width_bytes ),
+                     datchars[a[j].mode] );
+        a[k++] = a[j];
+    }
+    params->ncmds = k;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cache_addfile
+ *
+ * DESCRIPTION
+ *      Records a command file read by readlist(), with the
+ *       hash of its contents, for the command cache.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void cache_addfile( const char *name, const cmdfile_t *cf )
+{
+    struct cache_rec *q;
+
+    if ( cmdcache.nfiles == cmdcache.files_size )
+    {
+        cmdcache.files_size = cmdcache.files_size ? cmdcache.files_size * 2 : 8;
+        cmdcache.files = realloc( cmdcache.files, cmdcache.files_size * sizeof( struct cache_rec ) );
+        if ( !cmdcache.files )
+            error( "Out of memory for command cache" );
+    }
+
+    q = &cmdcache.files[cmdcache.nfiles++];
+    q->name   = arena_strdup( name );
+    q->length = cf->length;
+    q->hash   = cmdfile_hash( cf );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cache_addlabel
+ *
+ * DESCRIPTION
+ *      Records a label added by readlist() for the command
+ *       cache, in order.  name must be interned.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void cache_addlabel( ADDR addr, char *name, int imported )
+{
+    struct cache_rec *q;
+
+    if ( cmdcache.nlabels == cmdcache.labels_size )
+    {
+        cmdcache.labels_size = cmdcache.labels_size ? cmdcache.labels_size * 2 : CMDLIST_INIT;
+        cmdcache.labels = realloc( cmdcache.labels, cmdcache.labels_size * sizeof( struct cache_rec ) );
+        if ( !cmdcache.labels )
+            error( "Out of memory for command cache" );
+    }
+
+    q = &cmdcache.labels[cmdcache.nlabels++];
+    q->addr     = addr;
+    q->name     = name;
+    q->imported = imported;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      addlabel
+ *
+ * DESCRIPTION
+ *      Adds a label from the command file to the xref
+ *       database.
+ *
+ * RETURNS
+ *      The interned copy of name.
+ *
+ ************************************************************/
+
+static char * addlabel( ADDR addr, char *name )
+{
+    name = xref_addxreflabel( addr, name );
+
+    if ( cmdcache.recording )
+        cache_addlabel( addr, name, 0 );
+
+    return name;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      importsymbols
+ *
+ * DESCRIPTION
+ *      Adds the symbols in a symbol file (see symbols.c) to
+ *       the xref database as one batch.  Symbol values are
+ *       taken in the same units as command file addresses.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void importsymbols( const char *filename )
+{
+    cmdfile_t     cf;
+    xref_label_t *labels;
+    size_t        n, i;
+
+    if ( cmdfile_open( &cf, filename ) != 0 )
+        error( "Failed to open symbol file \"%s\"", filename );
+
+    if ( cmdcache.recording )
+        cache_addfile( filename, &cf );
+
+    labels = sym_read( &cf, &n );
+    for ( i = 0; i < n; i++ )
+        labels[i].ref *= dasm_word_width_bytes;
+
+    if ( cmdcache.recording )
+        for ( i = 0; i < n; i++ )
+            cache_addlabel( labels[i].ref, arena_intern( labels[i].label ), 1 );
+
+    xref_addlabels( labels, n );
+
+    free( labels );
+    cmdfile_close( &cf );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      importinput
+ *
+ * DESCRIPTION
+ *      If the input file is ELF, adds its symbols to the xref
+ *       database as importsymbols() does and notes its entry
+ *       point for addentry().  ELF symbol values and entry
+ *       points are byte addresses, so are not scaled.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void importinput( const char *filename, struct params *params )
+{
+    cmdfile_t     cf;
+    xref_label_t *labels;
+    size_t        n, i;
+    ADDR          entry;
+
+    /* A missing input file is reported when it is loaded */
+    if ( !loader_is_elf( filename ) || cmdfile_open( &cf, filename ) != 0 )
+        return;
+
+    if ( loader_elf_entry( (const UBYTE *)cf.data, cf.length, &entry ) )
+    {
+        if ( cmdcache.recording )
+            cache_addfile( filename, &cf );
+
+        labels = sym_read_elf( &cf, &n );
+
+        if ( cmdcache.recording )
+            for ( i = 0; i < n; i++ )
+                cache_addlabel( labels[i].ref, arena_intern( labels[i].label ), 1 );
+
+        xref_addlabels( labels, n );
+        free( labels );
+
+        params->has_entry = 1;
+        params->entry     = entry;
+    }
+
+    cmdfile_close( &cf );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      addentry
+ *
+ * DESCRIPTION
+ *      Adds a procedure entry at the entry point of an ELF
+ *       input file, named by its symbol if it has one, unless
+ *       the command file has a command for that address.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void addentry( struct params *params )
+{
+    char  *name;
+    size_t i;
+
+    if ( !params->has_entry )
+        return;
+
+    for ( i = 0; i < params->ncmds; i++ )
+        if ( params->cmdlist[i].addr == params->entry )
+            return;
+
+    if ( ( name = xref_findaddrlabel( params->entry ) ) == NULL )
+        name = addlabel( params->entry, GEN_LABEL_PREFIX "ENTRY" );
+
+    addlist( params, params->entry, PROCS, BYTES_PER_LINE, name );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      addbankends
+ *
+ * DESCRIPTION
+ *      Ends each bank after bank 0 that has commands with an
+ *       omit command at the end of the banked window, unless
+ *       the command file has a command for that address, so
+ *       that rendering goes on to the next bank.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void addbankends( struct params *params )
+{
+    UBYTE  used[BANK_MAX + 1];
+    ADDR   end;
+    size_t i;
+    int    b;
+
+    if ( !banked )
+        return;
+
+    memset( used, 0, sizeof( used ) );
+    for ( i = 0; i < params->ncmds; i++ )
+        used[BANK_OF( params->cmdlist[i].addr )] = 1;
+
+    for ( b = 1; b <= BANK_MAX; b++ )
+    {
+        if ( !used[b] )
+            continue;
+
+        end = BANK_ADDR( b, bank_hi + 1 );
+        for ( i = 0; i < params->ncmds; i++ )
+            if ( params->cmdlist[i].addr == end )
+                break;
+
+        if ( i == params->ncmds )
+            addlist( params, end, OMIT, BYTES_PER_LINE, NULL );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      setbanks
+ *
+ * DESCRIPTION
+ *      Makes the address space banked, with the CPU addresses
+ *       lo to hi inclusive as the banked window.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void setbanks( ADDR lo, ADDR hi )
+{
+    banked  = 1;
+    bank_lo = lo;
+    bank_hi = hi;
+
+    xref_setbanks( lo, hi );
+    out_setbanked( 1 );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      bankaddr
+ *
+ * DESCRIPTION
+ *      Makes the address of CPU address addr in the given bank,
+ *       for readlist().  Only the banked window has banks other
+ *       than bank 0, though a bank may be ended by a command
+ *       just past the end of the window.
+ *
+ * RETURNS
+ *      the banked address
+ *
+ ************************************************************/
+
+static ADDR bankaddr( const char *listfile, unsigned int lineno,
+                      unsigned long bank, unsigned long addr )
+{
+    if ( !banked )
+        error( "%s(%u) :: Bank given without a banked window ('o' command)", listfile, lineno );
+
+    if ( bank > BANK_MAX || addr >= ( 1ul << BANK_SHIFT ) )
+        error( "%s(%u) :: Bad banked address %lX:%04lX", listfile, lineno, bank, addr );
+
+    /* The address just past the window ends a bank */
+    if ( bank && ( addr < bank_lo || addr > bank_hi + 1 ) )
+        error( "%s(%u) :: Address %04lX in bank %02lX is outside the banked window",
+               listfile, lineno, addr, bank );
+
+    return BANK_ADDR( bank, addr );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      readlist
+ *
+ * DESCRIPTION
+ *      reads and parses the listfile.  The file is mapped
+ *       and parsed in place (see cmdfile.c), so lines may
+ *       be of any length.
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+#define SKIP_SPACE(M_p)    do {\
+                               while(*M_p && isspace((unsigned char)*M_p))\
+                                   M_p++;\
+                           } while(0)
+
+/* Scan a number into M_v, complaining if there isn't one */
+#define SCAN_HEX(M_v, M_what) do {\
+                               if ( !cmdfile_hex( &pbuf, &val ) )\
+                                   error( "%s(%u) :: Missing %s for command '%c'", listfile, cf.lineno, M_what, cmd );\
+                               M_v = val;\
+                           } while(0)
+/* Scan an address, which may be banked (BB:XXXX), into M_v */
+#define SCAN_ADDR(M_v, M_what) do {\
+                               SCAN_HEX( M_v, M_what );\
+                               M_v *= dasm_word_width_bytes;\
+                               if ( *pbuf == ':' )\
+                               {\
+                                   unsigned long bank = val;\
+                                   pbuf++;\
+                                   SCAN_HEX( M_v, M_what );\
+                                   M_v = bankaddr( listfile, cf.lineno, bank, val );\
+                               }\
+                           } while(0)
+#define SCAN_DEC(M_v, M_what) do {\
+                               if ( !cmdfile_dec( &pbuf, &sval ) )\
+                                   error( "%s(%u) :: Missing %s for command '%c'", listfile, cf.lineno, M_what, cmd );\
+                               M_v = sval;\
+                           } while(0)
+
+#define MAX_INCLUDE_DEPTH   16
+
+static void readlist( const char *listfile, struct params *params )
+{
+    static int include_depth = 0;
+    cmdfile_t cf;
+    char *pbuf, *q;
+    char autoname[32];
+    unsigned long val;
+    long sval;
+    ADDR addr;
+    int cmd;
+    char *notefirst = NULL;
+    size_t notestart = 0;
+   
+    enum {
+        LINE_CMD,
+        LINE_NOTE
+    } linemode = LINE_CMD;
+    
+    if ( !listfile )
+        error( "No listfile specifed" );
+
+    if ( ++include_depth > MAX_INCLUDE_DEPTH )
+        error( "Include nesting too deep (limit is %d)", MAX_INCLUDE_DEPTH );
+
+    if ( cmdfile_open( &cf, listfile ) != 0 )
+        error( "Failed to open list command file \"%s\"", listfile );
+
+    if ( cmdcache.recording )
+        cache_addfile( listfile, &cf );
+
+    /* Process each line of list file */
+    while ( ( pbuf = cmdfile_getline( &cf ) ) != NULL )
+    {
+        if ( linemode == LINE_CMD )
+        {
+            /* strip leading whitespace */
+            SKIP_SPACE(pbuf);
+            
+            /* Skip comment lines */
+            if ( *pbuf == '#' )
+                continue;
+
+            /* Remove trailing carriage-return (handle CRLF) */
+            if ( (q = strchr( pbuf, '\r' )) )
+                *q = '\0';
+
+            /* Peel off command code, then do something about it */
+            cmd = *pbuf++;
+            cmd = tolower( (unsigned char)cmd ); /* Be case-agnostic */
+            switch ( cmd )
+            {
+            case 0: break; /* Blank line */
+
+            case 'a': /* alphanumeric character dump */
+            case 'b': /* byte dump                   */
+            case 'c': /* start of code disassembly   */
+            case 'e': /* end of processing           */
+            case 'p': /* start of procedure          */
+            case 's': /* string dump                 */
+            case 'v': /* vector dump                 */
+            case 'w': /* word dump                   */
+            case 'm': /* bitmap dump                 */
+            case 'u': /* widechar string dump        */
+            case 'z': /* skip empty areas            */
+            case 'x': /* omit from listing           */
+                {
+                    unsigned int cmd_idx = strchr( datchars, cmd ) - datchars;
+                    unsigned bytes_per_line = BYTES_PER_LINE;
+                    SCAN_ADDR( addr, "address" );
+                    
+                    if ( *pbuf == ',' )
+                    {
+                        unsigned int count;
+                        
+                        if ( cmd != 'b' )
+                            error( "%s(%u) :: Byte count not supported for command '%c'", listfile, cf.lineno, cmd );
+                        
+                        pbuf++;
+                        SCAN_DEC( count, "byte count" );
+                        
+                        if ( count > BYTES_PER_LINE )
+                            error( "%s(%u) :: Too many bytes per line (limit is %d)", listfile, cf.lineno, BYTES_PER_LINE );
+                            
+                        bytes_per_line = count;
+                    }
+
+                    SKIP_SPACE(pbuf);
+                        
+                    /* If user has provided an optional name for this entity then
+                     * store it in the xref database.
+                     */
+                    if ( !*pbuf )
+                    {
+                        static struct {
+                            char *pfx;
+                            unsigned int num;
+                        } tbl[] = {
+                            { "CL",      1 },
+                            { "BDATA",   1 }, 
+                            { "STRING",  1 },
+                            { NULL,      0 }, /* END */
+                            { "WDATA",   1 },
+                            { "CDATA",   1 },
+                            { "PROC",    1 },
+                            { "VCTR",    1 },
+                            { "BMAP",    1 },
+                            { "WSTRING", 1 },
+                            { "SKIP",    1 },
+                            { NULL,      0 }  /* OMIT */
+                        };
+
+                        if ( tbl[cmd_idx].pfx )
+                        {
+                            snprintf( autoname, sizeof(autoname), GEN_LABEL_PREFIX "%s_%04d", tbl[cmd_idx].pfx, tbl[cmd_idx].num++ );
+                            pbuf = autoname;
+                        }
+                    }
+                    
+                    /* Add a cross-ref entry for everything except an end or omit entry */
+                    if ( cmd != 'e' && cmd != 'x' )
+                        pbuf = addlabel( addr, pbuf );
+                    else
+                        pbuf = arena_intern( pbuf );
+
+                    addlist( params, 
+                                addr, 
+                                cmd_idx, 
+                                bytes_per_line,
+                                pbuf );
+                }
+                break;
+
+            case 'f':  /* inputfile */
+                {
+                    struct image_input in;
+                    char *at = strrchr( pbuf, '@' );
+
+                    memset( &in, 0, sizeof( in ) );
+
+                    /* Optional " @XXXX[,L/N]" load address and byte lane */
+                    if ( at && at > pbuf && isspace( (unsigned char)at[-1] ) )
+                    {
+                        for ( q = at; q > pbuf && isspace( (unsigned char)q[-1] ); q-- )
+                            ;
+                        *q = '\0';
+
+                        q    = pbuf;
+                        pbuf = at + 1;
+                        SCAN_ADDR( in.addr, "load address" );
+                        in.placed = 1;
+
+                        if ( *pbuf == ',' )
+                        {
+                            pbuf++;
+                            SCAN_DEC( in.lane, "byte lane" );
+                            if ( *pbuf++ != '/' )
+                                error( "%s(%u) :: Missing number of byte lanes for command '%c'", listfile, cf.lineno, cmd );
+                            SCAN_DEC( in.lanes, "number of byte lanes" );
+                            if ( in.lanes < 2 || in.lane >= in.lanes )
+                                error( "%s(%u) :: Bad byte lane for command '%c'", listfile, cf.lineno, cmd );
+                        }
+                        pbuf = q;
+                    }
+
+                    if ( params->ninputs && !( in.placed && params->inputs[0].placed ) )
+                        error( "%s(%u) :: Multiple input files specified without load addresses", listfile, cf.lineno );
+
+                    in.name = (const char *)arena_strdup( pbuf );
+                    addinput( params, &in );
+                    importinput( in.name, params );
+                }
+                break;
 
             case 'i':   /* include file */
                 readlist( pbuf, params );
                 break;
 
-            case '>':   /* fast forward */
-		sscanf( pbuf, "%x", &file_offset );
-		break;
+            case 'o':   /* Banked window */
+                {
+                    ADDR lo, hi;
+
+                    SCAN_HEX( lo, "window start" );
+                    if ( *pbuf++ != '-' )
+                        error( "%s(%u) :: Missing window end for command '%c'", listfile, cf.lineno, cmd );
+                    SCAN_HEX( hi, "window end" );
+
+                    if ( dasm_word_width_bytes != 1 )
+                        error( "%s(%u) :: Banked address spaces need byte addresses", listfile, cf.lineno );
+                    if ( hi < lo || hi >= ( 1u << BANK_SHIFT ) - 1 )
+                        error( "%s(%u) :: Bad banked window", listfile, cf.lineno );
+                    if ( banked && ( lo != bank_lo || hi != bank_hi ) )
+                        error( "%s(%u) :: Banked window already set", listfile, cf.lineno );
+
+                    setbanks( lo, hi );
+                }
+                break;
+
+            case 'y':   /* symbol file */
+                importsymbols( pbuf );
+                break;
+
+            case '>':   /* fast forward */
+                SCAN_HEX( file_offset, "offset" );
+                break;
+
+            case 'r':   /* Xref range */
+                {
+                    /* Deprecated */
+                }
+                break;
+
+            case 't':   /* String terminator byte */
+                SCAN_HEX( string_terminator, "terminator" );
+                break;
+
+           case 'l':   /* Define xref code label */
+           case 'd':   /* Define xref data label */
+                {
+                    SCAN_ADDR( addr, "address" );
+                    
+                    SKIP_SPACE(pbuf);
+                    
+                    if ( !*pbuf )
+                    {
+                        static unsigned int auto_label = 1;
+                   
+                        snprintf( autoname, sizeof(autoname), "AL_%04d", auto_label++ );
+                        pbuf = autoname;
+                    }
+                    
+                    addlabel( addr, pbuf );
+                }
+                break;
+
+            case 'k':   /* Single-line (k)comment */
+                {
+                    SCAN_ADDR( addr, "address" );
+                    
+                    SKIP_SPACE(pbuf);
+                    if ( *pbuf )
+                        addcomment( &linecmt, addr, pbuf );
+                }
+                break;
+
+            case 'n':   /* Multiple-line note */
+                {
+                    SCAN_ADDR( addr, "address" );
+
+                    /* The note is the rest of this line followed by the
+                     * lines up to the terminator, which are left where
+                     * they are until the terminator is found.
+                     */
+                    SKIP_SPACE(pbuf);
+                    notefirst = pbuf;
+                    notestart = cf.pos;
+                    linemode = LINE_NOTE;
+                }
+                break;
+
+            case 'q':   /* Pagination */
+                {
+                    pagination = DEFAULT_LINES_PER_PAGE;
+
+                    SKIP_SPACE(pbuf);
+                    if ( *pbuf == ',' )
+                    {
+                        pbuf++;
+                        SCAN_DEC( pagination, "page length" );
+                    }
+
+                    if ( pagination < MIN_LINES_PER_PAGE )
+                        error( "%s(%u) :: Must be at least %d lines per page\n", 
+                                listfile, cf.lineno, MIN_LINES_PER_PAGE );
+
+                    pagination -= PAGINATION_ALLOWANCE;
+
+                    SKIP_SPACE(pbuf);
+                    if ( *pbuf == '"' )
+                    {
+                        char *title = arena_strdup( pbuf + 1 );
+                        if ( strlen(title) > 0 )
+                            title[strlen(title)-1] = '\0';
+                        page_title = title;
+                    }
+                    else if ( params->ninputs )
+                    {
+                        page_title = params->inputs[0].name;
+                    }
+                }
+                break;
+
+            default: /* Unknown command */
+                {
+                    if ( isprint( (unsigned char)cmd ) )
+                        error( "%s(%u) :: Unknown command code '%d'\n", listfile, cf.lineno, cmd );
+                    else
+                        error( "%s :: Illegal character in command file - is this a binary file?\n", listfile );
+                }
+                break;
+            }   /* switch */
+        }
+        else    /* is LINE_NOTE */
+        {
+            /* Note mode is terminated by a line starting with '.' */
+            if ( *pbuf == '.' )
+            {
+                size_t firstlen = strlen( notefirst );
+                size_t bodylen  = cf.start - notestart;
+                char *note, *p;
+
+                /* Put back the newlines between the lines of the body */
+                note = zalloc( firstlen + bodylen + 1 );
+                memcpy( note, notefirst, firstlen );
+                memcpy( note + firstlen, cf.data + notestart, bodylen );
+                for ( p = note + firstlen; p < note + firstlen + bodylen; p++ )
+                    if ( *p == '\0' )
+                        *p = '\n';
+
+                linemode = LINE_CMD;
+                addcomment( &blockcmt, addr, note );
+                free( note );
+            }
+        }
+    }
+
+    cmdfile_close( &cf );
+    include_depth--;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      strtab_add
+ *
+ * DESCRIPTION
+ *      Adds a string to a cache string table.
+ *
+ * RETURNS
+ *      offset of string in table, or CACHE_NONE if s is NULL
+ *
+ ************************************************************/
+
+static ULWORD strtab_add( struct strtab *st, const char *s )
+{
+    size_t len, off;
+
+    if ( !s )
+        return CACHE_NONE;
+
+    len = strlen( s ) + 1;
+    while ( st->len + len > st->size )
+    {
+        st->size = st->size ? st->size * 2 : 4096;
+        st->buf  = realloc( st->buf, st->size );
+        if ( !st->buf )
+            error( "Out of memory for command cache" );
+    }
+
+    off = st->len;
+    memcpy( st->buf + off, s, len );
+    st->len += len;
+
+    return (ULWORD)off;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cache_write
+ *
+ * DESCRIPTION
+ *      Writes n bytes to the cache file.
+ *
+ * RETURNS
+ *      1 if successful, else 0
+ *
+ ************************************************************/
+
+static int cache_write( FILE *f, const void *p, size_t n )
+{
+    return n == 0 || fwrite( p, 1, n, f ) == n;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cache_save
+ *
+ * DESCRIPTION
+ *      Writes what readlist() made of the command file to
+ *       the cache file.  It is written to a temporary file
+ *       first and renamed into place, so that a reader
+ *       never sees half a cache.  A cache that cannot be
+ *       written is only worth a warning.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void cache_save( const struct params *params )
+{
+    struct cache_header  hdr;
+    struct cache_file   *files;
+    struct cache_input  *inputs;
+    struct cache_cmd    *cmds;
+    struct cache_ref    *labels, *lcmts, *bcmts;
+    struct strtab        st = { NULL, 0, 0 };
+    char                *tmpname;
+    FILE                *f;
+    size_t               i;
+    int                  ok;
+
+    memset( &hdr, 0, sizeof( hdr ) );
+    memcpy( hdr.magic, CACHE_MAGIC, sizeof( hdr.magic ) );
+    hdr.word_width  = dasm_word_width_bytes;
+    hdr.dasm        = strtab_add( &st, dasm_name );
+    hdr.nfiles      = cmdcache.nfiles;
+    hdr.ncmds       = params->ncmds;
+    hdr.nlabels     = cmdcache.nlabels;
+    hdr.nlinecmts   = linecmt.n;
+    hdr.nblockcmts  = blockcmt.n;
+    hdr.ninputs     = params->ninputs;
+    hdr.terminator  = string_terminator;
+    hdr.file_offset = file_offset;
+    hdr.pagination  = pagination;
+    hdr.page_title  = strtab_add( &st, page_title );
+    hdr.banked      = banked;
+    hdr.bank_lo     = bank_lo;
+    hdr.bank_hi     = bank_hi;
+
+    files  = zalloc( ( hdr.nfiles + 1 ) * sizeof( struct cache_file ) );
+    inputs = zalloc( ( hdr.ninputs + 1 ) * sizeof( struct cache_input ) );
+    cmds   = zalloc( ( hdr.ncmds + 1 ) * sizeof( struct cache_cmd ) );
+    labels = zalloc( ( hdr.nlabels + 1 ) * sizeof( struct cache_ref ) );
+    lcmts  = zalloc( ( hdr.nlinecmts + 1 ) * sizeof( struct cache_ref ) );
+    bcmts  = zalloc( ( hdr.nblockcmts + 1 ) * sizeof( struct cache_ref ) );
+
+    for ( i = 0; i < hdr.nfiles; i++ )
+    {
+        files[i].name    = strtab_add( &st, cmdcache.files[i].name );
+        files[i].length  = (ULWORD)cmdcache.files[i].length;
+        files[i].hash[0] = (ULWORD)cmdcache.files[i].hash;
+        files[i].hash[1] = (ULWORD)( cmdcache.files[i].hash >> 32 );
+    }
+    for ( i = 0; i < hdr.ninputs; i++ )
+    {
+        inputs[i].name   = strtab_add( &st, params->inputs[i].name );
+        inputs[i].placed = (ULWORD)params->inputs[i].placed;
+        inputs[i].addr   = params->inputs[i].addr;
+        inputs[i].lane   = params->inputs[i].lane;
+        inputs[i].lanes  = params->inputs[i].lanes;
+    }
+    for ( i = 0; i < hdr.ncmds; i++ )
+    {
+        cmds[i].addr = params->cmdlist[i].addr;
+        cmds[i].mode = params->cmdlist[i].mode;
+        cmds[i].bpl  = params->cmdlist[i].bpl;
+        cmds[i].name = strtab_add( &st, params->cmdlist[i].name );
+    }
+    for ( i = 0; i < hdr.nlabels; i++ )
+    {
+        labels[i].addr  = cmdcache.labels[i].addr;
+        labels[i].text  = strtab_add( &st, cmdcache.labels[i].name );
+        labels[i].flags = cmdcache.labels[i].imported ? CACHE_IMPORTED : 0;
+    }
+    for ( i = 0; i < hdr.nlinecmts; i++ )
+    {
+        lcmts[i].addr = linecmt.item[i].ref;
+        lcmts[i].text = strtab_add( &st, linecmt.item[i].text );
+    }
+    for ( i = 0; i < hdr.nblockcmts; i++ )
+    {
+        bcmts[i].addr = blockcmt.item[i].ref;
+        bcmts[i].text = strtab_add( &st, blockcmt.item[i].text );
+    }
+    hdr.strings = (ULWORD)st.len;
+
+    tmpname = zalloc( strlen( params->cachefile ) + 5 );
+    sprintf( tmpname, "%s.tmp", params->cachefile );
+
+    ok = ( f = fopen( tmpname, "wb" ) ) != NULL;
+    if ( ok )
+    {
+        ok = cache_write( f, &hdr, sizeof( hdr ) )
+          && cache_write( f, files, hdr.nfiles * sizeof( struct cache_file ) )
+          && cache_write( f, inputs, hdr.ninputs * sizeof( struct cache_input ) )
+          && cache_write( f, cmds, hdr.ncmds * sizeof( struct cache_cmd ) )
+          && cache_write( f, labels, hdr.nlabels * sizeof( struct cache_ref ) )
+          && cache_write( f, lcmts, hdr.nlinecmts * sizeof( struct cache_ref ) )
+          && cache_write( f, bcmts, hdr.nblockcmts * sizeof( struct cache_ref ) )
+          && cache_write( f, st.buf, st.len );
+        ok = ( fclose( f ) == 0 ) && ok;
+        ok = ok && rename( tmpname, params->cachefile ) == 0;
+        if ( !ok )
+            remove( tmpname );
+    }
+
+    if ( !ok )
+        warning( "Failed to write command cache \"%s\"", params->cachefile );
+
+    free( tmpname );
+    free( st.buf );
+    free( files );
+    free( inputs );
+    free( cmds );
+    free( labels );
+    free( lcmts );
+    free( bcmts );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cache_check
+ *
+ * DESCRIPTION
+ *      Checks that the mapped cache file is well formed,
+ *       was made by this disassembler from the same list
+ *       file, and that the list file and every file it
+ *       includes still have the contents they had then.
+ *
+ * RETURNS
+ *      1 if the cache can be used, else 0
+ *
+ ************************************************************/
+
+/* Test a string offset, and turn one into a pointer */
+#define CACHE_STR_OK(M_off)     ( (M_off) < hdr->strings )
+#define CACHE_STR(M_off)        ( (M_off) == CACHE_NONE ? NULL : (char *)strings + (M_off) )
+
+static int cache_check( const cmdfile_t *cf, const struct params *params )
+{
+    const struct cache_header *hdr = (const struct cache_header *)cf->data;
+    const struct cache_file   *files;
+    const struct cache_input  *inputs;
+    const struct cache_cmd    *cmds;
+    const struct cache_ref    *refs;
+    const char                *strings;
+    size_t                     size, nrefs, i;
+    unsigned long long         hash;
+    cmdfile_t                  incl;
+    int                        same;
+
+    if ( cf->length < sizeof( *hdr ) || memcmp( hdr->magic, CACHE_MAGIC, sizeof( hdr->magic ) ) )
+        return 0;
+
+    nrefs = (size_t)hdr->nlabels + hdr->nlinecmts + hdr->nblockcmts;
+    size  = sizeof( *hdr )
+          + hdr->nfiles * sizeof( struct cache_file )
+          + hdr->ninputs * sizeof( struct cache_input )
+          + hdr->ncmds * sizeof( struct cache_cmd )
+          + nrefs * sizeof( struct cache_ref )
+          + hdr->strings;
+    if ( size != cf->length || hdr->strings == 0 || cf->data[cf->length - 1] != '\0' )
+        return 0;
+
+    files   = (const struct cache_file *)( hdr + 1 );
+    inputs  = (const struct cache_input *)( files + hdr->nfiles );
+    cmds    = (const struct cache_cmd *)( inputs + hdr->ninputs );
+    refs    = (const struct cache_ref *)( cmds + hdr->ncmds );
+    strings = cf->data + cf->length - hdr->strings;
+
+    /* Every string must be in the table */
+    if ( !CACHE_STR_OK( hdr->dasm ) || hdr->nfiles == 0 )
+        return 0;
+    if ( hdr->page_title != CACHE_NONE && !CACHE_STR_OK( hdr->page_title ) )
+        return 0;
+    for ( i = 0; i < hdr->nfiles; i++ )
+        if ( !CACHE_STR_OK( files[i].name ) )
+            return 0;
+    for ( i = 0; i < hdr->ninputs; i++ )
+        if ( !CACHE_STR_OK( inputs[i].name ) )
+            return 0;
+    for ( i = 0; i < hdr->ncmds; i++ )
+        if ( cmds[i].mode >= strlen( datchars )
+             || ( cmds[i].name != CACHE_NONE && !CACHE_STR_OK( cmds[i].name ) ) )
+            return 0;
+    for ( i = 0; i < nrefs; i++ )
+        if ( !CACHE_STR_OK( refs[i].text ) )
+            return 0;
+
+    if ( hdr->word_width != (ULWORD)dasm_word_width_bytes
+         || strcmp( strings + hdr->dasm, dasm_name )
+         || strcmp( strings + files[0].name, params->listfile ) )
+        return 0;
+
+    /* Finally, the command files themselves */
+    for ( i = 0; i < hdr->nfiles; i++ )
+    {
+        if ( cmdfile_open( &incl, strings + files[i].name ) != 0 )
+            return 0;
+
+        hash = cmdfile_hash( &incl );
+        same = incl.length == files[i].length
+            && (ULWORD)hash == files[i].hash[0]
+            && (ULWORD)( hash >> 32 ) == files[i].hash[1];
+
+        cmdfile_close( &incl );
+        if ( !same )
+            return 0;
+    }
+
+    return 1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cache_load
+ *
+ * DESCRIPTION
+ *      Maps the cache file and, if it is still good, sets
+ *       up everything readlist() would have done from it.
+ *      Names, comments and file names are used straight
+ *       from the mapping, which is kept for the whole run.
+ *
+ * RETURNS
+ *      1 if the cache was loaded, else 0
+ *
+ ************************************************************/
+
+static int cache_load( struct params *params )
+{
+    cmdfile_t *cf = &cmdcache.map;
+    const struct cache_header *hdr;
+    const struct cache_file   *files;
+    const struct cache_input  *inputs;
+    const struct cache_cmd    *cmds;
+    const struct cache_ref    *refs;
+    const char                *strings;
+    xref_label_t              *batch;
+    size_t                     i, n;
+
+    if ( !params->listfile || cmdfile_open( cf, params->cachefile ) != 0 )
+        return 0;
+
+    if ( !cache_check( cf, params ) )
+    {
+        cmdfile_close( cf );
+        return 0;
+    }
+
+    hdr     = (const struct cache_header *)cf->data;
+    files   = (const struct cache_file *)( hdr + 1 );
+    inputs  = (const struct cache_input *)( files + hdr->nfiles );
+    cmds    = (const struct cache_cmd *)( inputs + hdr->ninputs );
+    refs    = (const struct cache_ref *)( cmds + hdr->ncmds );
+    strings = cf->data + cf->length - hdr->strings;
+
+    params->inputs      = zalloc( ( hdr->ninputs + 1 ) * sizeof( struct image_input ) );
+    params->ninputs     = hdr->ninputs;
+    params->inputs_size = hdr->ninputs + 1;
+    for ( i = 0; i < hdr->ninputs; i++ )
+    {
+        params->inputs[i].name   = CACHE_STR( inputs[i].name );
+        params->inputs[i].placed = (int)inputs[i].placed;
+        params->inputs[i].addr   = inputs[i].addr;
+        params->inputs[i].lane   = inputs[i].lane;
+        params->inputs[i].lanes  = inputs[i].lanes;
+    }
+
+    string_terminator = (int)hdr->terminator;
+    file_offset       = hdr->file_offset;
+    pagination        = (int)hdr->pagination;
+    page_title        = CACHE_STR( hdr->page_title );
+    if ( hdr->banked )
+        setbanks( hdr->bank_lo, hdr->bank_hi );
+
+    params->cmdlist   = zalloc( ( hdr->ncmds + 1 ) * sizeof( struct fmt ) );
+    params->ncmds     = hdr->ncmds;
+    params->cmds_size = hdr->ncmds + 1;
+    for ( i = 0; i < hdr->ncmds; i++ )
+    {
+        params->cmdlist[i].addr = cmds[i].addr;
+        params->cmdlist[i].mode = (int)cmds[i].mode;
+        params->cmdlist[i].bpl  = cmds[i].bpl;
+        params->cmdlist[i].name = CACHE_STR( cmds[i].name );
+    }
+
+    /* Labels go in in the order they were added, with each run of
+     * imported ones added as a batch as importsymbols() did.
+     */
+    batch = zalloc( ( hdr->nlabels + 1 ) * sizeof( xref_label_t ) );
+    for ( i = 0; i < hdr->nlabels; )
+    {
+        if ( !( refs[i].flags & CACHE_IMPORTED ) )
+        {
+            xref_addxreflabel( refs[i].addr, CACHE_STR( refs[i].text ) );
+            i++;
+            continue;
+        }
+
+        for ( n = 0; i < hdr->nlabels && ( refs[i].flags & CACHE_IMPORTED ); i++, n++ )
+        {
+            batch[n].ref   = refs[i].addr;
+            batch[n].label = CACHE_STR( refs[i].text );
+        }
+        xref_addlabels( batch, n );
+    }
+    free( batch );
+    refs += hdr->nlabels;
+
+    linecmt.item = zalloc( ( hdr->nlinecmts + 1 ) * sizeof( struct comment ) );
+    linecmt.n    = hdr->nlinecmts;
+    linecmt.size = hdr->nlinecmts + 1;
+    for ( i = 0; i < hdr->nlinecmts; i++, refs++ )
+    {
+        linecmt.item[i].ref  = refs->addr;
+        linecmt.item[i].text = CACHE_STR( refs->text );
+    }
+
+    blockcmt.item = zalloc( ( hdr->nblockcmts + 1 ) * sizeof( struct comment ) );
+    blockcmt.n    = hdr->nblockcmts;
+    blockcmt.size = hdr->nblockcmts + 1;
+    for ( i = 0; i < hdr->nblockcmts; i++, refs++ )
+    {
+        blockcmt.item[i].ref  = refs->addr;
+        blockcmt.item[i].text = CACHE_STR( refs->text );
+    }
+
+    return 1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      usage
+ *
+ * DESCRIPTION
+ *      prints out usage info for user.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void usage( void )
+{
+    printf( "%s -- %s Disassembler --\n"
+            "Usage:\n"
+            "  %s [options] listfile\n"
+            "\n"
+            "  options:\n"
+            "     -h        print helpful usage information\n"
+            "     -x        with cross-reference list\n"
+            "     -a        output in assembler format\n"
+            "     -s        stripped assembler output (forces -a)\n"
+            "     -o foo    write output to `foo' (stdout is default)\n"
+            "     -j N      render with N threads\n"
+            "     -d        discover code, write a command list\n"
+            "     -c foo    cache the parsed command file in `foo'\n"
+            "     -y foo    import symbols from `foo' (may be repeated)\n"
+            "     -X f:foo  export xrefs to `foo' as f (jsonl, csv or bin)\n"
+            "     -q query  answer xref query instead of listing (may be repeated)\n"
+            "     -T N      time N decoding passes with and without text\n",
+            dasm_name, dasm_description, dasm_name );
+    exit(EXIT_FAILURE);
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      render
+ *
+ * DESCRIPTION
+ *      Renders the command list from the given state until the
+ *       next command boundary is stop (NULL renders to the end).
+ *      The state is updated to where rendering stopped so that
+ *       it can be carried on from there.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+ 
+static void render( struct params *params, dasm_ctx_t *ctx,
+                    struct render_state *rs, size_t stop )
+{ 
+    const struct fmt *cmds = params->cmdlist;
+    ADDR          addr   = rs->addr;
+    int           mode   = rs->mode;
+    unsigned int  bpl    = rs->bpl;
+    char         *name   = rs->name;
+    size_t        cmd    = rs->cmd;
+    int           at_top = rs->at_top;
+    struct comment_cursor linecur, blockcur;
+
+    comment_seek( &linecur, &linecmt, addr );
+    comment_seek( &blockcur, &blockcmt, addr );
+
+    while ( cmd < stop )
+    {
+        if ( at_top && addr >= cmds[cmd].addr )
+        {
+            if ( mode != cmds[cmd].mode )
+                out_newline();
+            mode  = cmds[cmd].mode;
+            name  = cmds[cmd].name;
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+
+            if ( cmd == stop )
+            {
+                at_top = 0;
+                break;
+            }
+        }
+        at_top = 1;
+        
+        if ( cmd >= params->ncmds )
+            break;
+
+        if ( mode == CODE )
+        {
+            /*****************************************************************
+            *            c - CODE
+            *****************************************************************/
+            int column, i;
+            ADDR lineaddr;
+            char insnbuf[256];
+
+            printcomment( &blockcur, addr, 0 );
+
+            column = emitaddr( addr, params );
+            lineaddr = addr;
+            ctx->insn_len = 0;
+            ctx->xbank    = 0;
+
+            addr = dasm_insn( ctx, insnbuf, addr );
+
+            if ( !params->want_stripped )
+            {
+                for ( i = 0; i < ctx->insn_len && i < dasm_max_insn_length; i++ )
+                {
+                    out_hex( ctx->insn_bytes[i], 2 );
+                    out_char( ' ' );
+                }
+                out_spaces( 3 * ( dasm_max_insn_length - i ) );
+
+                if ( params->want_asm_out )
+                    out_char( '\n' );
+            }
+            
+            out_spaces( 3 );
+            out_str( insnbuf );
+            column += strlen( insnbuf );
+
+            if ( printcomment( &linecur, lineaddr, COL_LINECOMMENT - column ) )
+            {
+                if ( ctx->xbank )
+                    out_str( " (into banked window)" );
+            }
+            else if ( ctx->xbank )
+            {
+                out_padstr( COMMENT_DELIM, COL_LINECOMMENT - column );
+                out_str( " Into banked window" );
+            }
+            out_newline();
+        }
+        else if ( mode == BYTES )
+        {
+            /*****************************************************************
+            *            b - BYTES
+            *****************************************************************/
+
+            unsigned char buf[BYTES_PER_LINE];
+            int p, i = 0;
+
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
+
+            while ( addr < cmds[cmd].addr )
+            {
+                if ( i == 0 ) 
+                {
+                    emitaddr( addr, params );
+                    if ( params->want_asm_out )
+                        out_str( params->want_stripped ? "   " : "\n   " );
+                    out_str( "DB      " );
+                }
+
+                buf[i] = (unsigned char)next( ctx, &addr );
+                out_hex( buf[i], 2 );
+                i++;
+                if ( i == bpl )
+                {
+                    /* End of a full line */
+                    out_spaces( 6 );
+                    if ( params->want_asm_out )
+                        out_str( "; " );
+
+                    for ( p = 0; p < bpl; p++ )
+                        out_char( isprint( (unsigned char)buf[p] ) ? buf[p] : '.' );
+
+                    out_newline();
+                    i = 0;
+                }
+                else
+                    if ( addr < cmds[cmd].addr ) out_str( ", " );
+            }
+            if ( i < bpl )
+            {
+                /* Partial line, tricky */
+
+                out_spaces( 4 * ( bpl - i ) );
+
+                out_spaces( 6 );
+                if ( params->want_asm_out )
+                    out_str( "; " );
+
+                for ( p = 0; p < i; p++ )
+                    out_char( isprint( (unsigned char)buf[p] ) ? buf[p] : '.' );
+
+                out_newline();
+            }
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name;
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == STRINGS )
+        {
+            /*****************************************************************
+            *            s - STRING DATA
+            *****************************************************************/
+
+            int c;
+            
+            out_newline();            
+            printcomment( &blockcur, addr, 0 );
+
+            while ( addr < cmds[cmd].addr )
+            {
+                emitaddr( addr, params );
+                if ( params->want_asm_out )
+                    out_str( params->want_stripped ? "   " : "\n   " );
+                out_str( "DB      '" );
+
+                while ( addr < cmds[cmd].addr && ( c = next( ctx, &addr ) ) )
+                {
+                    if ( c == string_terminator )
+                        break;
+
+                    if ( isprint( (unsigned char)c ) )
+                        out_char( c );
+                    else
+                    {
+                        out_char( '\\' );
+                        out_hex( (unsigned char)c, 2 );
+                    }
+                }
+                out_char( '\'' );
+                out_newline();
+            }
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name;
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == WSTRING )
+        {
+            /*****************************************************************
+            *            u - WIDECHAR STRING DATA
+            *****************************************************************/
+
+            int c;
+
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
+
+            while ( addr < cmds[cmd].addr )
+            {
+                emitaddr( addr, params );
+                if ( params->want_asm_out )
+                    out_str( params->want_stripped ? "   " : "\n   " );
+
+                int in_quote = 0;
+                out_str( "DW      " );
+
+                while ( addr < cmds[cmd].addr && ( c = nextw( ctx, &addr ) ) )
+                {
+                    if ( c == string_terminator )
+                        break;
+
+                    if ( isprint( (unsigned char)c ) )
+                    {
+                        if ( !in_quote )
+                        {
+                            out_char( '\'' );
+                            in_quote = 1;
+                        }
+                        out_char( c );
+                    }
+                    else
+                    {
+                        if ( in_quote )
+                        {
+                            out_str( "', " );
+                            in_quote = 0;
+                        }
+                        else
+                        {
+                            out_str( ", " );
+                        }
+                        out_str( "0X" );
+                        out_hex( (uint16_t)c, 2 );
+                    }
+                }
+                if ( in_quote )
+                    out_char( '\'' );
+                out_newline();
+            }
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name;
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == WORDS )
+        {
+            /*****************************************************************
+            *            w - WORD DATA
+            *****************************************************************/
+
+            int w, b_1st, b_2nd, i = 0;
+            
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
 
-            case 'r':   /* Xref range */
+            while ( addr < cmds[cmd].addr )
+            {
+                if ( ( i & 7 ) == 0 ) 
                 {
-                    /* Deprecated */
+                    emitaddr( addr, params );
+                    if ( params->want_asm_out )
+                        out_str( params->want_stripped ? "   " : "\n   " );
+                    out_str( "DW      " );
                 }
-                break;
 
-            case 't':   /* String terminator byte */
-                sscanf( pbuf, "%x", &string_terminator );
-                break;
+                b_1st = (unsigned char)next( ctx, &addr );
+                b_2nd = (unsigned char)next( ctx, &addr );
 
-           case 'l':   /* Define xref code label */
-           case 'd':   /* Define xref data label */
-                {
-                    sscanf( pbuf, "%x%n", &addr, &n );
-                    addr *= dasm_word_width_bytes;
-                    pbuf += n;
-                    
-                    SKIP_SPACE(pbuf);
-                    
-                    if ( !*pbuf )
-                    {
-                        static unsigned int auto_label = 1;
-                   
-                        snprintf( pbuf, buf + sizeof(buf) - pbuf, "AL_%04d", auto_label++ );
-                    }
-                    
-                    xref_addxreflabel( addr, pbuf );
-                }
-                break;
+                if ( dasm_word_msb_first )
+                    SWAP( b_1st, b_2nd );
 
-            case 'k':   /* Single-line (k)comment */
-                {
-                    sscanf( pbuf, "%x%n", &addr, &n );
-                    addr *= dasm_word_width_bytes;
-                    pbuf += n;
-                    
-                    SKIP_SPACE(pbuf);
-                    if ( *pbuf )
-                        addcomment( &linecmt, addr, pbuf );
-                }
-                break;
+                w = b_1st | ( b_2nd << 8 );
 
-            case 'n':   /* Multiple-line note */
-                {
-                    sscanf( pbuf, "%x%n", &addr, &n );
-                    addr *= dasm_word_width_bytes;
-                    pbuf += n;
-
-                    /* Initialise the note buffer and switch to LINE_NOTE mode. */
-                    notelength = 0;
-                    notebufsize = NOTE_BUF_INIT;
-                    notebuf = realloc( notebuf, notebufsize );
-                    if ( !notebuf )
-                        error( "Out of memory for note buffer" );
-                    notebuf[0] = '\0';
-                    linemode = LINE_NOTE;
+                out_hex( w, 4 );
+                dasm_addxref( ctx, X_TABLE, addr - 2, w );
 
-                    SKIP_SPACE(pbuf);
-                    if ( *pbuf )
-                    {
-                        strcpy( notebuf, pbuf );
-                        notelength = strlen( pbuf );
-                    }
-                }
-                break;
+                if ( ( i & 7 ) == 7 )
+                    out_newline();
+                else
+                    if ( addr < cmds[cmd].addr ) out_str( ", " );
+                i++;                
+            }
+            if ( i & 7 ) 
+                out_newline();
 
-            case 'q':   /* Pagination */
-                {
-                    pagination = DEFAULT_LINES_PER_PAGE;
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name; 
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == SKIP )
+        {
+            /*****************************************************************
+            *            z - SKIP
+            *****************************************************************/
 
-                    SKIP_SPACE(pbuf);
-                    if ( *pbuf == ',' )
-                    {
-                        pbuf++;
-                        sscanf( pbuf, "%d%n", &pagination, &n );
-                        pbuf += n;
-                    }
+            int b, i = 0;
 
-                    if ( pagination < MIN_LINES_PER_PAGE )
-                        error( "%s(%u) :: Must be at least %d lines per page\n", 
-                                listfile, lineno, MIN_LINES_PER_PAGE );
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
 
-                    pagination -= PAGINATION_ALLOWANCE;
+            {
+                emitaddr( addr, params );
+                if ( params->want_asm_out )
+                    out_str( params->want_stripped ? "   " : "\n   " );
+            }
 
-                    SKIP_SPACE(pbuf);
-                    if ( *pbuf == '"' )
-                    {
-                        char title[LINE_BUF_LEN];
-                        strncpy( title, pbuf+1, sizeof(title) - 1 );
-                        title[sizeof(title) - 1] = '\0';
-                        if ( strlen(title) > 0 )
-                            title[strlen(title)-1] = '\0';
-                        page_title = strdup( title );
-                    }
-                    else if ( params->inputfile )
-                    {
-                        page_title = params->inputfile;
-                    }
+            while ( addr < cmds[cmd].addr )
+            {
+                /* Gaps in a sparse image are empty too */
+                int loaded = image_loaded( addr );
+
+                b = (unsigned char)next( ctx, &addr );
+                if (b != 0 && loaded)
+                    error( "Non-zero byte in skipped section %s at %s",
+                           OUT_ADDRSTR( addr / dasm_word_width_bytes ),
+                           OUT_ADDRSTR( cmds[cmd].addr / dasm_word_width_bytes ) );
+                i++;
+            }
+
+            out_printf( "SKIP    %04x", i );
+            out_newline();
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name;
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == VECTORS )
+        {
+            /*****************************************************************
+            *            v - VECTOR DATA
+            *****************************************************************/
+
+            UBYTE b[sizeof( ADDR )];
+            ADDR v;
+            int k;
+            char *label;
+            
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
+
+            while ( addr < cmds[cmd].addr )
+            {
+                emitaddr( addr, params );
+                if ( params->want_asm_out )
+                    out_str( params->want_stripped ? "   " : "\n   " );
+                out_str( dasm_vector_bytes > 2 ? "DD      " : "DW      " );
+
+                for ( k = 0; k < dasm_vector_bytes; k++ )
+                    b[k] = next( ctx, &addr );
+                v = mkvector( b );
+
+                label = xref_findaddrlabel( xref_bankref( addr - dasm_vector_bytes,
+                                                          v * dasm_word_width_bytes ) );
+                if ( label )
+                    out_str( label );
+                else
+                    out_printf( FORMAT_ADDR, ADDR_DIGITS, v );
+                out_newline();
+                dasm_addxref( ctx, X_TABLE, addr - dasm_vector_bytes, v );
+            }
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name; 
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == CHARS )
+        {
+            /*****************************************************************
+            *            a - CHARS (alphanums)
+            *****************************************************************/
+
+            int c, i = 0;
+            
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
+
+            while ( addr < cmds[cmd].addr )
+            {
+                if ( ( i & 7 ) == 0 )
+                {
+                    emitaddr( addr, params );
+                    if ( params->want_asm_out )
+                        out_str( params->want_stripped ? "   " : "\n   " );
+                    out_str( "DB      " );
                 }
-                break;
 
-            default: /* Unknown command */
+                c = next( ctx, &addr );
+
+                if ( isprint( (unsigned char)c ) )
                 {
-                    if ( isprint( (unsigned char)cmd ) )
-                        error( "%s(%u) :: Unknown command code '%d'\n", listfile, lineno, cmd );
-                    else
-                        error( "%s :: Illegal character in command file - is this a binary file?\n", listfile );
+                    out_char( '\'' );
+                    out_char( c );
+                    out_char( '\'' );
                 }
-                break;
-            }   /* switch */
+                else
+                    out_hex( (unsigned char)c, 2 );
+
+                if ( ( i & 7 ) == 7 ) 
+                    out_newline();
+                else
+                    if ( addr < cmds[cmd].addr ) out_str( ", " );
+                i++;
+            }
+            if ( i & 7 ) 
+                out_newline();
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name; 
+            bpl   = cmds[cmd].bpl;
+            cmd++;
         }
-        else    /* is LINE_NOTE */
+        else if ( mode == END )
         {
-            /* Note mode is terminated by a line starting with '.' */
-            if ( *pbuf == '.' )
+            /*****************************************************************
+            *            e - END
+            *****************************************************************/
+
+            cmd = params->ncmds;
+        }
+        else if ( mode == OMIT )
+        {
+            /*****************************************************************
+            *            x - OMIT
+            *****************************************************************/
+
+            addr = cmds[cmd].addr;
+            image_seek( ctx, addr );
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name;
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+        else if ( mode == PROCS )
+        {
+            /*****************************************************************
+            *            p - PROCS
+            *****************************************************************/
+
+            if ( !comment_find( &blockcur, addr ) )
             {
-                linemode = LINE_CMD;
-                addcomment( &blockcmt, addr, notebuf );
+                out_str( ";----------------------------------------------------------------" );
+                out_newline();
+                out_str( ";        Function: " );
+                out_str( ( name ) ? name : "" );
+                out_newline(); out_newline();
             }
-            else
+
+            /* As for a c entry, decode at least one insn */
+            mode   = CODE;
+            at_top = 0;
+        }
+        else if ( mode == BITMAPS )
+        {
+            /*****************************************************************
+            *            m - BITMAPS
+            *****************************************************************/
+            
+            out_newline();
+            printcomment( &blockcur, addr, 0 );
+
+            while ( addr < cmds[cmd].addr )
             {
-                size_t linelen = strlen( pbuf );
+                UBYTE bitmap;
+                UBYTE mask = 0x80;
+                
+                emitaddr( addr, params );
+                if ( params->want_asm_out )
+                    out_str( params->want_stripped ? "   " : "\n   " );
+                out_str( "DB      " );
+
+                bitmap = (UBYTE)next( ctx, &addr );
+                out_hex( bitmap, 2 );
+                
+                out_spaces( 4 );
+                if ( params->want_asm_out )
+                    out_char( ';' );
+                    
+                out_str( " [" );
+                for ( ; mask; mask >>= 1 )
+                    out_char( bitmap & mask ? '#' : '.' );
+                out_char( ']' ); out_newline();
+            }
+
+            mode = cmds[cmd].mode;
+            if ( mode == CODE || mode == PROCS )
+                out_newline();
+            name  = cmds[cmd].name; 
+            bpl   = cmds[cmd].bpl;
+            cmd++;
+        }
+    } /* while() */
+
+    rs->addr   = addr;
+    rs->mode   = mode;
+    rs->bpl    = bpl;
+    rs->name   = name;
+    rs->cmd    = cmd;
+    rs->at_top = at_top;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      chunk_addxref
+ *
+ * DESCRIPTION
+ *      Xref sink for a chunk rendered on a worker thread.
+ *       The xrefs are kept in order and added to the global
+ *       store when the chunk is merged.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void chunk_addxref( void *arg, XREF_TYPE type, ADDR addr, ADDR ref )
+{
+    struct chunk *ch = arg;
+
+    if ( ch->nxrefs == ch->xrefs_size )
+    {
+        ch->xrefs_size = ch->xrefs_size ? 2 * ch->xrefs_size : 1024;
+        ch->xrefs = realloc( ch->xrefs, ch->xrefs_size * sizeof( *ch->xrefs ) );
+        if ( !ch->xrefs )
+            error( "Out of memory" );
+    }
+
+    ch->xrefs[ch->nxrefs].type = type;
+    ch->xrefs[ch->nxrefs].addr = addr;
+    ch->xrefs[ch->nxrefs].ref  = ref;
+    ch->nxrefs++;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      render_chunk
+ *
+ * DESCRIPTION
+ *      Renders one chunk of the command list on a worker
+ *       thread, capturing its output, xrefs, and any error.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void render_chunk( struct render_job *job, struct chunk *ch )
+{
+    struct error_trap trap;
+    dasm_ctx_t ctx;
+
+    dasm_ctx_init( &ctx );
+    image_seek( &ctx, ch->start.addr );
+    ctx.xref     = chunk_addxref;
+    ctx.xref_arg = ch;
+
+    out_capture_begin( &ch->out );
+
+    error_trap = &trap;
+    if ( setjmp( trap.env ) == 0 )
+    {
+        ch->end = ch->start;
+        render( job->params, &ctx, &ch->end, ch->stop );
+
+        ch->ctx_state = ctx.state;
+        ch->ctx_tos   = ctx.tos;
+        memcpy( ch->ctx_opcstack, ctx.opcstack, sizeof( ctx.opcstack ) );
+    }
+    else
+    {
+        ch->failed = 1;
+        strcpy( ch->errmsg, trap.msg );
+    }
+    error_trap = NULL;
+
+    out_capture_end();
+    dasm_ctx_free( &ctx );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      render_worker
+ *
+ * DESCRIPTION
+ *      Worker thread: takes chunks from the job until there
+ *       are none left.
+ *
+ * RETURNS
+ *      NULL
+ *
+ ************************************************************/
+
+static void *render_worker( void *arg )
+{
+    struct render_job *job = arg;
+
+    for ( ;; )
+    {
+        int k;
+
+        pthread_mutex_lock( &job->lock );
+        k = job->next++;
+        pthread_mutex_unlock( &job->lock );
+
+        if ( k >= job->nchunks )
+            break;
+
+        render_chunk( job, &job->chunks[k] );
+    }
+
+    return NULL;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      plan_chunks
+ *
+ * DESCRIPTION
+ *      Splits the command list into roughly equal sized chunks
+ *       at command boundaries, up to the first end command.
+ *      Each chunk after the first starts from the state the
+ *       renderer would be in if the previous region ended
+ *       exactly at its boundary.
+ *
+ * RETURNS
+ *      number of chunks
+ *
+ ************************************************************/
 
-                /* Grow buffer if needed */
-                while ( notelength + linelen + 1 > notebufsize )
-                {
-                    notebufsize *= 2;
-                    notebuf = realloc( notebuf, notebufsize );
-                    if ( !notebuf )
-                        error( "Out of memory for note buffer" );
-                }
-                memcpy( notebuf + notelength, pbuf, linelen + 1 );
-                notelength += linelen;
-            }
-        }
+static int plan_chunks( struct render_job *job, const struct render_state *rs,
+                        int max_chunks )
+{
+    const struct fmt *cmds = job->params->cmdlist;
+    size_t ncmds = job->params->ncmds;
+    size_t last, i;
+    ADDR total, size, next_cut;
+    int n = 0;
+
+    /* Nothing is rendered past the first end command */
+    for ( last = 0; last + 1 < ncmds && cmds[last].mode != END; last++ )
+        ;
+    total = cmds[last].addr - cmds[0].addr;
+    size  = MAX( total / max_chunks, 1 );
+
+    job->chunks = zalloc( max_chunks * sizeof( struct chunk ) );
+    job->chunks[n++].start = *rs;
+
+    next_cut = cmds[0].addr + size;
+    for ( i = 1; i < last && n < max_chunks; i++ )
+    {
+        struct render_state *st;
+
+        if ( cmds[i].addr < next_cut || i + 1 >= ncmds )
+            continue;
+
+        job->chunks[n - 1].stop = i + 1;
+
+        st = &job->chunks[n++].start;
+        st->addr   = cmds[i].addr;
+        st->mode   = cmds[i].mode;
+        st->bpl    = cmds[i].bpl;
+        st->name   = cmds[i].name;
+        st->cmd    = i + 1;
+        st->at_top = !( cmds[i - 1].mode == CODE || cmds[i - 1].mode == PROCS );
+
+        next_cut = cmds[i].addr + size;
     }
 
-    free( notebuf );
-    fclose( f );
-    include_depth--;
+    job->chunks[n - 1].stop = ncmds;
+
+    return n;
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      usage
+ *      same_state
  *
  * DESCRIPTION
- *      prints out usage info for user.
+ *      Compares two renderer states.
+ *
+ * RETURNS
+ *      1 if the same, else 0
+ *
+ ************************************************************/
+
+static int same_state( const struct render_state *a, const struct render_state *b )
+{
+    return a->addr   == b->addr
+        && a->mode   == b->mode
+        && a->bpl    == b->bpl
+        && a->name   == b->name
+        && a->cmd    == b->cmd
+        && a->at_top == b->at_top;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      render_parallel
+ *
+ * DESCRIPTION
+ *      Renders the command list on a pool of worker threads
+ *       and writes the results out in address order.
+ *      Chunks are rendered speculatively: if the previous chunk
+ *       did not end in the state a chunk assumed (e.g. code ran
+ *       on past a command boundary) that chunk is rendered
+ *       again here, so the listing and xrefs are exactly as a
+ *       serial run would produce.
  *
  * RETURNS
  *      nothing
  *
  ************************************************************/
 
-static void usage( void )
+static void render_parallel( struct params *params, dasm_ctx_t *ctx,
+                             struct render_state *rs )
 {
-    printf( "%s -- %s Disassembler --\n"
-            "Usage:\n"
-            "  %s [options] listfile\n"
-            "\n"
-            "  options:\n"
-            "     -h        print helpful usage information\n"
-            "     -x        with cross-reference list\n"
-            "     -a        output in assembler format\n"
-            "     -s        stripped assembler output (forces -a)\n"
-            "     -o foo    write output to `foo' (stdout is default)\n",
-            dasm_name, dasm_description, dasm_name );
-    exit(EXIT_FAILURE);
+    struct render_job job;
+    pthread_t *threads;
+    int i, k, nthreads;
+
+    memset( &job, 0, sizeof( job ) );
+    job.params  = params;
+    job.nchunks = plan_chunks( &job, rs, params->jobs * CHUNKS_PER_JOB );
+    pthread_mutex_init( &job.lock, NULL );
+
+    nthreads = MIN( params->jobs, job.nchunks );
+    threads  = zalloc( nthreads * sizeof( pthread_t ) );
+    for ( i = 0; i < nthreads; i++ )
+        if ( pthread_create( &threads[i], NULL, render_worker, &job ) )
+            error( "Failed to start worker thread" );
+
+    for ( i = 0; i < nthreads; i++ )
+        pthread_join( threads[i], NULL );
+
+    for ( k = 0; k < job.nchunks; k++ )
+    {
+        struct chunk *ch = &job.chunks[k];
+        size_t x;
+
+        if ( k > 0 && ( !same_state( rs, &ch->start )
+                        || ctx->state != 0 || ctx->tos != -1 ) )
+        {
+            /* Speculation failed: render this chunk again from where
+             * the previous one really ended.
+             */
+            image_seek( ctx, rs->addr );
+            render( params, ctx, rs, ch->stop );
+        }
+        else
+        {
+            out_capture_write( &ch->out );
+            for ( x = 0; x < ch->nxrefs; x++ )
+                xref_addxref( ch->xrefs[x].type, ch->xrefs[x].addr, ch->xrefs[x].ref );
+
+            if ( ch->failed )
+                error( "%s", ch->errmsg );
+
+            *rs = ch->end;
+            ctx->state = ch->ctx_state;
+            ctx->tos   = ch->ctx_tos;
+            memcpy( ctx->opcstack, ch->ctx_opcstack, sizeof( ctx->opcstack ) );
+        }
+
+        out_capture_free( &ch->out );
+        free( ch->xrefs );
+    }
+
+    pthread_mutex_destroy( &job.lock );
+    free( threads );
+    free( job.chunks );
 }
 
 /***********************************************************
@@ -793,490 +2777,517 @@ static void usage( void )
  
 static void run_disasm( struct params params )
 { 
-    const char *inputfile = params.inputfile;
-    struct fmt *clist     = params.cmdlist;
-    FILE *f;
-    long  filelength;
-    ADDR  addr;
-    int   mode;
-    unsigned int bpl;
-    char *name;
+    struct fmt *cmds      = params.cmdlist;
+    dasm_ctx_t ctx;
+    struct render_state rs;
+    size_t i;
     
-    f = fopen( inputfile, "rb" );
-    if ( !f )
-        error( "Failed to open input file" );
-        
-    fseek( f, 0, SEEK_END );
-    filelength = ftell( f );
-    fseek( f, file_offset, SEEK_SET );
+    image_open( params.inputs, params.ninputs, file_offset, cmds[0].addr );
+    dasm_ctx_init( &ctx );
     
-    addr  = clist->addr;
-    mode  = clist->mode;
-    name  = clist->name;
-    bpl   = clist->bpl;
-    clist = clist->n;
+    rs.addr   = cmds[0].addr;
+    rs.mode   = cmds[0].mode;
+    rs.name   = cmds[0].name;
+    rs.bpl    = cmds[0].bpl;
+    rs.cmd    = 1;
+    rs.at_top = 1;
     
-    printf( "%s   Processing \"%s\" (%ld bytes)", COMMENT_DELIM, inputfile, filelength ); newline();
-    if ( file_offset )
+    for ( i = 0; i < params.ninputs; i++ )
     {
-         printf( "%s   File offset: 0x%04X", COMMENT_DELIM, file_offset ); newline();
+        const struct image_input *in = &params.inputs[i];
+
+        out_printf( "%s   Processing \"%s\" (%ld bytes)", COMMENT_DELIM, in->name, (long)in->length );
+        if ( in->placed && banked )
+            out_printf( " at 0x%04X in bank %02X", BANK_CPU( in->addr ), BANK_OF( in->addr ) );
+        else if ( in->placed )
+            out_printf( " at 0x" FORMAT_ADDR, ADDR_DIGITS, in->addr / dasm_word_width_bytes );
+        if ( in->lanes )
+            out_printf( ", byte lane %u of %u", in->lane, in->lanes );
+        out_newline();
     }
-    printf( "%s   Disassembly start address: 0x%04X", COMMENT_DELIM, addr );              newline();
-    printf( "%s   String terminator: 0x%02x", COMMENT_DELIM, string_terminator );         newline();
-    newline();
-
-    while ( !feof( f ) && clist )
+    if ( file_offset )
     {
-        if ( addr >= clist->addr )
-        {
-            if ( mode != clist->mode )
-                newline();
-            mode  = clist->mode;
-            name  = clist->name;
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        
-        if ( !clist )
-            break;
+         out_printf( "%s   File offset: 0x%04X", COMMENT_DELIM, file_offset ); out_newline();
+    }
+    if ( banked )
+        out_printf( "%s   Disassembly start address: 0x%04X in bank %02X", COMMENT_DELIM,
+                    BANK_CPU( rs.addr ), BANK_OF( rs.addr ) );
+    else
+        out_printf( "%s   Disassembly start address: 0x" FORMAT_ADDR, COMMENT_DELIM,
+                    ADDR_DIGITS, rs.addr / dasm_word_width_bytes );
+    out_newline();
+    out_printf( "%s   String terminator: 0x%02x", COMMENT_DELIM, string_terminator );         out_newline();
+    out_newline();
+
+    if ( params.jobs > 1 )
+        render_parallel( &params, &ctx, &rs );
+    else
+        render( &params, &ctx, &rs, params.ncmds );
+     
+    dasm_ctx_free( &ctx );
+    image_close();
+}
 
-        if ( mode == CODE )
-        {
-            /*****************************************************************
-            *            c - CODE
-            *****************************************************************/
-            int column, i;
-            ADDR lineaddr;
-            char insnbuf[256];
+/***********************************************************
+ *
+ * FUNCTION
+ *      decode_cmdlist
+ *
+ * DESCRIPTION
+ *      Decodes the code and reads the vector and word tables
+ *       in the command list, as render() does, recording
+ *       their xrefs, but writes no listing.  With a NULL
+ *       insnbuf the decoder writes no text either.
+ *
+ * RETURNS
+ *      number of instructions decoded
+ *
+ ************************************************************/
 
-            printcomment( blockcmt, addr, 0 );
+static unsigned long decode_cmdlist( struct params *params, dasm_ctx_t *ctx, char *insnbuf )
+{
+    const struct fmt *cmds = params->cmdlist;
+    ADDR          addr = cmds[0].addr, to;
+    unsigned long ninsns = 0;
+    size_t        i;
+    int           b_1st, b_2nd, k;
+    UBYTE         b[sizeof( ADDR )];
 
-            column = emitaddr( addr, &params );
-            lineaddr = addr;
-            insn_byte_idx = 0;
+    image_seek( ctx, addr );
 
-            addr = dasm_insn( f, insnbuf, addr );
+    for ( i = 0; i + 1 < params->ncmds && cmds[i].mode != END; i++ )
+    {
+        to = cmds[i + 1].addr;
 
-            if ( !params.want_stripped )
+        switch ( cmds[i].mode )
+        {
+        case CODE:
+        case PROCS:
+            /* As in render(), a code entry decodes at least one insn */
+            do
             {
-                for ( i = 0; i < dasm_max_insn_length; i++ )
-                    if ( i < insn_byte_idx )
-                        printf( "%02X ", insn_byte_buffer[i] );
-                    else
-                        printf( "   " );
-
-                if ( params.want_asm_out )
-                    printf( "\n" );
-            }
-            
-            i = printf( "   %s", insnbuf );
-            column += i - 3;
+                addr = dasm_insn( ctx, insnbuf, addr );
+                ninsns++;
+            } while ( addr < to );
+            break;
 
-            printcomment( linecmt, lineaddr, COL_LINECOMMENT - column );
-            newline();
-        }
-        else if ( mode == BYTES )
-        {
-            /*****************************************************************
-            *            b - BYTES
-            *****************************************************************/
+        case WORDS:
+            while ( addr < to )
+            {
+                b_1st = (unsigned char)next( ctx, &addr );
+                b_2nd = (unsigned char)next( ctx, &addr );
 
-            unsigned char buf[BYTES_PER_LINE];
-            int p, i = 0;
+                if ( dasm_word_msb_first )
+                    SWAP( b_1st, b_2nd );
 
-            newline();
-            printcomment( blockcmt, addr, 0 );
+                dasm_addxref( ctx, X_TABLE, addr - 2, b_1st | ( b_2nd << 8 ) );
+            }
+            break;
 
-            while ( addr < clist->addr )
+        case VECTORS:
+            while ( addr < to )
             {
-                if ( i == 0 ) 
-                {
-                    emitaddr( addr, &params );
-                    if ( params.want_asm_out )
-                        printf( params.want_stripped ? "   " : "\n   " );
-                    printf( "DB      " );
-                }
+                for ( k = 0; k < dasm_vector_bytes; k++ )
+                    b[k] = next( ctx, &addr );
 
-                buf[i] = (unsigned char)next( f, &addr );
-                printf( "%02X", (unsigned char)buf[i] );
-                i++;
-                if ( i == bpl )
-                {
-                    /* End of a full line */
-                    printf( "      " );
-                    if ( params.want_asm_out )
-                        printf( "; " );
+                dasm_addxref( ctx, X_TABLE, addr - dasm_vector_bytes, mkvector( b ) );
+            }
+            break;
 
-                    for ( p = 0; p < bpl; p++ )
-                        if ( isprint( (unsigned char)buf[p] ) )
-                            putchar( buf[p] );
-                        else
-                            putchar( '.' );
+        case WSTRING:
+            while ( addr < to )
+                nextw( ctx, &addr );
+            break;
 
-                    newline();
-                    i = 0;
-                }
-                else
-                    if ( addr < clist->addr ) printf( ", " );
-            }
-            if ( i < bpl )
-            {
-                /* Partial line, tricky */
+        case OMIT:
+            addr = to;
+            image_seek( ctx, addr );
+            break;
 
-                for ( p = i; p < bpl; p++ )
-                    printf( "    " );
+        default:
+            while ( addr < to )
+                next( ctx, &addr );
+            break;
+        }
+    }
 
-                printf( "      " );
-                if ( params.want_asm_out )
-                    printf( "; " );
+    return ninsns;
+}
 
-                for ( p = 0; p < i; p++ )
-                    if ( isprint( (unsigned char)buf[p] ) )
-                        putchar( buf[p] );
-                    else
-                        putchar( '.' );
+/***********************************************************
+ *
+ * FUNCTION
+ *      run_query
+ *
+ * DESCRIPTION
+ *      Fills in the xref database by decoding the command
+ *       list without text, then answers each -q query.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
 
-                newline();
-            }
+static void run_query( struct params params )
+{
+    dasm_ctx_t ctx;
+    int        i;
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name;
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == STRINGS )
-        {
-            /*****************************************************************
-            *            s - STRING DATA
-            *****************************************************************/
+    image_open( params.inputs, params.ninputs, file_offset, params.cmdlist[0].addr );
+    dasm_ctx_init( &ctx );
 
-            int c;
-            
-            newline();            
-            printcomment( blockcmt, addr, 0 );
+    decode_cmdlist( &params, &ctx, NULL );
 
-            while ( addr < clist->addr )
-            {
-                emitaddr( addr, &params );
-                if ( params.want_asm_out )
-                    printf( params.want_stripped ? "   " : "\n   " );
-                printf( "DB      '" );
+    dasm_ctx_free( &ctx );
+    image_close();
 
-                while ( addr < clist->addr && ( c = next( f, &addr ) ) )
-                {
-                    if ( c == string_terminator )
-                        break;
+    for ( i = 0; i < params.nqueries; i++ )
+        xref_query( params.queries[i] );
+}
 
-                    if ( isprint( (unsigned char)c ) )
-                        putchar( c );
-                    else
-                        printf ("\\%02X", (unsigned char) c );
-                }
-                printf( "'" );
-                newline();
-            }
+/***********************************************************
+ *
+ * FUNCTION
+ *      discard_xref
+ *
+ * DESCRIPTION
+ *      Xref sink for run_bench(), which keeps nothing.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name;
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == WSTRING )
-        {
-            /*****************************************************************
-            *            u - WIDECHAR STRING DATA
-            *****************************************************************/
+static void discard_xref( void *arg, XREF_TYPE type, ADDR addr, ADDR ref )
+{
+    ( *(unsigned long *)arg )++;
+}
 
-            int c;
+/***********************************************************
+ *
+ * FUNCTION
+ *      bench_now
+ *
+ * DESCRIPTION
+ *      Reads the monotonic clock.
+ *
+ * RETURNS
+ *      time in seconds
+ *
+ ************************************************************/
 
-            newline();
-            printcomment( blockcmt, addr, 0 );
+static double bench_now( void )
+{
+    struct timespec ts;
 
-            while ( addr < clist->addr )
-            {
-                emitaddr( addr, &params );
-                if ( params.want_asm_out )
-                    printf( params.want_stripped ? "   " : "\n   " );
+    clock_gettime( CLOCK_MONOTONIC, &ts );
 
-                int in_quote = 0;
-                printf( "DW      " );
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
 
-                while ( addr < clist->addr && ( c = nextw( f, &addr ) ) )
-                {
-                    if ( c == string_terminator )
-                        break;
+/***********************************************************
+ *
+ * FUNCTION
+ *      run_bench
+ *
+ * DESCRIPTION
+ *      Times a number of passes of decode_cmdlist() with the
+ *       decoders writing their text and then without, and
+ *       reports the rates.  Xrefs are counted but not kept.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
 
-                    if ( isprint( (unsigned char)c ) )
-                    {
-                        if ( !in_quote )
-                        {
-                            putchar( '\'' );
-                            in_quote = 1;
-                        }
-                        putchar( c );
-                    }
-                    else
-                    {
-                        if ( in_quote )
-                        {
-                            printf( "', " );
-                            in_quote = 0;
-                        }
-                        else
-                        {
-                            printf( ", " );
-                        }
-                        printf ("%#04X", (uint16_t) c );
-                    }
-                }
-                if ( in_quote )
-                    printf( "'" );
-                newline();
-            }
+static void run_bench( struct params params )
+{
+    static const char * const what[] = { "text", "decode only" };
+    dasm_ctx_t    ctx;
+    char          insnbuf[256];
+    unsigned long ninsns = 0, nxrefs = 0;
+    double        t[2];
+    int           i, pass;
+
+    image_open( params.inputs, params.ninputs, file_offset, params.cmdlist[0].addr );
+    dasm_ctx_init( &ctx );
+    ctx.xref     = discard_xref;
+    ctx.xref_arg = &nxrefs;
+
+    /* A ratio of two empty loops means nothing */
+    if ( decode_cmdlist( &params, &ctx, NULL ) == 0 )
+        error( "No instructions decoded, nothing to time" );
+    nxrefs = 0;
+
+    for ( i = 0; i < 2; i++ )
+    {
+        t[i] = bench_now();
+        for ( pass = 0; pass < params.bench_passes; pass++ )
+            ninsns = decode_cmdlist( &params, &ctx, i == 0 ? insnbuf : NULL );
+        t[i] = bench_now() - t[i];
+
+        out_printf( "%-12s %d x %lu insns in %.3f s, %.2f M insns/s",
+                    what[i], params.bench_passes, ninsns, t[i],
+                    t[i] > 0 ? params.bench_passes * ninsns / t[i] / 1e6 : 0.0 );
+        out_newline();
+    }
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name;
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == WORDS )
-        {
-            /*****************************************************************
-            *            w - WORD DATA
-            *****************************************************************/
+    out_printf( "%-12s %lu per pass", "xrefs", nxrefs / ( 2 * params.bench_passes ) );
+    out_newline();
+    if ( t[1] > 0 )
+    {
+        out_printf( "%-12s %.2fx", "speedup", t[0] / t[1] );
+        out_newline();
+    }
 
-            int w, b_1st, b_2nd, i = 0;
-            
-            newline();
-            printcomment( blockcmt, addr, 0 );
+    dasm_ctx_free( &ctx );
+    image_close();
+}
 
-            while ( addr < clist->addr )
-            {
-                if ( ( i & 7 ) == 0 ) 
-                {
-                    emitaddr( addr, &params );
-                    if ( params.want_asm_out )
-                        printf( params.want_stripped ? "   " : "\n   " );
-                    printf( "DW      " );
-                }
+/***********************************************************
+ *
+ * FUNCTION
+ *      user_name
+ *
+ * DESCRIPTION
+ *      Filters out empty names and those generated by
+ *       readlist, which are generated afresh when a command
+ *       list is read back.
+ *
+ * RETURNS
+ *      the name, or NULL
+ *
+ ************************************************************/
 
-                b_1st = (unsigned char)next( f, &addr );
-                b_2nd = (unsigned char)next( f, &addr );
+static const char *user_name( const char *name )
+{
+    if ( !name || !*name
+         || strncmp( name, GEN_LABEL_PREFIX, strlen( GEN_LABEL_PREFIX ) ) == 0 )
+        return NULL;
 
-                if ( dasm_word_msb_first )
-                    SWAP( b_1st, b_2nd );
+    return name;
+}
 
-                w = b_1st | ( b_2nd << 8 );
+/***********************************************************
+ *
+ * FUNCTION
+ *      emit_command
+ *
+ * DESCRIPTION
+ *      Writes one dump or code command of a generated
+ *       command list.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
 
-                printf( "%04X", w );
-                xref_addxref( X_TABLE, addr - 2, w );
+static void emit_command( int mode, ADDR addr, unsigned int bpl, const char *name )
+{
+    out_char( datchars[mode] );
+    out_addr( addr / dasm_word_width_bytes );
+    if ( mode == BYTES && bpl != BYTES_PER_LINE )
+        out_printf( ",%u", bpl );
+    if ( name )
+    {
+        out_char( ' ' );
+        out_str( name );
+    }
+    out_newline();
+}
 
-                if ( ( i & 7 ) == 7 )
-                    newline();
-                else
-                    if ( addr < clist->addr ) printf( ", " );
-                i++;                
-            }
-            if ( i & 7 ) 
-                newline();
+/***********************************************************
+ *
+ * FUNCTION
+ *      discover_slice
+ *
+ * DESCRIPTION
+ *      Discovers the code in the length bytes from base, for
+ *       the commands first to last (exclusive), and writes
+ *       them out with the discovered code in place of byte
+ *       dumps.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name; 
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == SKIP )
-        {
-            /*****************************************************************
-            *            z - SKIP
-            *****************************************************************/
+static void discover_slice( const struct params *params, size_t first, size_t last,
+                            ADDR base, size_t length )
+{
+    const struct fmt *cmds = params->cmdlist, *here;
+    ADDR          a;
+    size_t        i;
+    unsigned long nroots = 0;
+    int           umode = BYTES, prev = -1;
+    unsigned int  ubpl  = BYTES_PER_LINE;
+    flow_t        flow;
+
+    flow_init( &flow, base, length );
+
+    /* Mark the data that must not be decoded */
+    for ( i = first; i < last; i++ )
+    {
+        ADDR to = ( i + 1 < params->ncmds ) ? cmds[i + 1].addr : base + length;
 
-            int b, i = 0;
+        if ( cmds[i].mode != CODE && cmds[i].mode != PROCS && cmds[i].mode != BYTES )
+            for ( a = cmds[i].addr; a < to && (size_t)( a - base ) < length; a++ )
+                flow.map[a - base] |= FLOW_DATA;
+    }
 
-            newline();
-            printcomment( blockcmt, addr, 0 );
+    /* Queue the code entries and the vectors */
+    for ( i = first; i < last; i++ )
+    {
+        ADDR to = ( i + 1 < params->ncmds ) ? cmds[i + 1].addr : base + length;
 
+        if ( cmds[i].mode == CODE || cmds[i].mode == PROCS )
+        {
+            flow_add_root( &flow, cmds[i].addr );
+            nroots++;
+        }
+        else if ( cmds[i].mode == VECTORS )
+        {
+            for ( a = cmds[i].addr;
+                  a + dasm_vector_bytes <= to && (size_t)( a + dasm_vector_bytes - base ) <= length;
+                  a += dasm_vector_bytes )
             {
-                emitaddr( addr, &params );
-                if ( params.want_asm_out )
-                    printf( params.want_stripped ? "   " : "\n   " );
+                UBYTE b[sizeof( ADDR )];
+                ADDR v;
+                int k;
+
+                for ( k = 0; k < dasm_vector_bytes; k++ )
+                    b[k] = (UBYTE)image_byte( a + k );
+
+                v = xref_bankref( a, mkvector( b ) );
+                if ( v >= base && (size_t)( v - base ) < length )
+                    flow.map[v - base] |= FLOW_CALL;
+                flow_add_root( &flow, v );
+                nroots++;
             }
+        }
+    }
 
-            while ( addr < clist->addr )
-            {
-                b = (unsigned char)next( f, &addr );
-                if (b != 0)
-                    error("Non-zero byte in skipped section %04x at %04x", addr, clist->addr);
-                i++;
-            }
+    flow_run( &flow, params->jobs );
 
-            printf( "SKIP    %04x", i );
-            newline();
+    out_printf( "# %lu instructions found from %lu entry points",
+                (unsigned long)flow.ninsns, nroots );
+    if ( banked )
+        out_printf( " in bank %02X", BANK_OF( base ) );
+    out_newline();
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name;
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == VECTORS )
+    /* Merge the discovered code into the command list */
+    i = first;
+    for ( a = base; (size_t)( a - base ) < length; a++ )
+    {
+        UBYTE f = FLOW_FLAGS( &flow.map[a - base] );
+        const char *name;
+        unsigned int bpl = BYTES_PER_LINE;
+        int mode;
+
+        /* Entries inside an instruction are absorbed by it */
+        here = NULL;
+        while ( i < last && cmds[i].addr <= a )
         {
-            /*****************************************************************
-            *            v - VECTOR DATA
-            *****************************************************************/
-
-            int v, b_1st, b_2nd, i = 0;
-            
-            newline();
-            printcomment( blockcmt, addr, 0 );
+            here  = ( cmds[i].addr == a ) ? &cmds[i] : NULL;
+            umode = cmds[i].mode;
+            ubpl  = cmds[i].bpl;
+            i++;
+        }
 
-            while ( addr < clist->addr )
-            {
-                emitaddr( addr, &params );
-                if ( params.want_asm_out )
-                    printf( params.want_stripped ? "   " : "\n   " );
-                printf( "DW      " );
+        if ( ( f & FLOW_CODE ) && !( f & FLOW_DATA ) )
+        {
+            if ( !( f & FLOW_INSN ) )
+                continue;
 
-                b_1st = (unsigned char)next( f, &addr );
-                b_2nd = (unsigned char)next( f, &addr );
+            if ( ( f & FLOW_CALL ) || ( here && here->mode == PROCS ) )
+                mode = PROCS;
+            else if ( prev != CODE || here )
+                mode = CODE;
+            else
+                continue;
+        }
+        else
+        {
+            mode = ( umode == CODE || umode == PROCS ) ? BYTES : umode;
+            if ( mode == prev && !here )
+                continue;
+            if ( umode == BYTES )
+                bpl = ubpl;
+        }
 
-                if ( dasm_word_msb_first )
-                    SWAP( b_1st, b_2nd );
+        name = user_name( here ? here->name : NULL );
+        if ( !name )
+            name = user_name( xref_findaddrlabel( a ) );
 
-                v = b_1st | ( b_2nd << 8 );
+        emit_command( mode, a, bpl, name );
+        prev = ( mode == PROCS ) ? CODE : mode;
+    }
 
-                printf( "%s", xref_genwordaddr( NULL, "%04X", v ) ); newline();
-                xref_addxref( X_TABLE, addr - 2, v );
+    flow_free( &flow );
+}
 
-                i++;
-            }
+/***********************************************************
+ *
+ * FUNCTION
+ *      run_discover
+ *
+ * DESCRIPTION
+ *      Discovers the code reachable from the code and
+ *       procedure entries and from the vectors in vector
+ *       tables, then writes out the command list with the
+ *       discovered code in place of byte dumps.
+ *      Call targets become procedures.  Bytes of code and
+ *       procedure regions that could not be reached become
+ *       byte dumps.  All other dumps are kept as they are
+ *       and are not decoded.
+ *      Each run of commands ended by an omit command is
+ *       discovered on its own, so each bank of a banked
+ *       address space is.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name; 
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == CHARS )
-        {
-            /*****************************************************************
-            *            a - CHARS (alphanums)
-            *****************************************************************/
+static void run_discover( struct params params )
+{
+    const struct fmt *cmds = params.cmdlist;
+    ADDR          base, end;
+    size_t        length, i, k;
 
-            int c, i = 0;
-            
-            newline();
-            printcomment( blockcmt, addr, 0 );
+    image_open( params.inputs, params.ninputs, file_offset, params.cmdlist[0].addr );
 
-            while ( addr < clist->addr )
-            {
-                if ( ( i & 7 ) == 0 )
-                {
-                    emitaddr( addr, &params );
-                    if ( params.want_asm_out )
-                        printf( params.want_stripped ? "   " : "\n   " );
-                    printf( "DB      " );
-                }
+    out_printf( "# Generated by %s code discovery", dasm_name );
+    out_newline();
 
-                c = next( f, &addr );
+    for ( i = 0; i < params.ncmds; i = k + 1 )
+    {
+        for ( k = i; k < params.ncmds && cmds[k].mode != END && cmds[k].mode != OMIT; k++ )
+            ;
 
-                if ( isprint( (unsigned char)c ) )
-                    printf( "'%c'", c );
-                else
-                    printf( "%02X", (unsigned char)c );
+        /* Discovery stops at the end or omit entry or the end of the input */
+        base   = cmds[i].addr;
+        end    = ( k < params.ncmds && cmds[k].addr < image.end ) ? cmds[k].addr : image.end;
+        length = end > base ? (size_t)( end - base ) : 0;
 
-                if ( ( i & 7 ) == 7 ) 
-                    newline();
-                else
-                    if ( addr < clist->addr ) printf( ", " );
-                i++;
-            }
-            if ( i & 7 ) 
-                newline();
+        if ( banked && length && BANK_OF( base ) != BANK_OF( end - 1 ) )
+            error( "Bank %02X is not ended by an 'x' or 'e' command", BANK_OF( base ) );
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name; 
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-        else if ( mode == END )
-        {
-            /*****************************************************************
-            *            e - END
-            *****************************************************************/
+        if ( k > i )
+            discover_slice( &params, i, k, base, length );
 
-            clist = NULL;
-        }
-        else if ( mode == PROCS )
+        if ( k < params.ncmds && cmds[k].mode == OMIT )
         {
-            /*****************************************************************
-            *            p - PROCS
-            *****************************************************************/
-
-            if ( !commentexists( blockcmt, addr ) )
-            {
-                printf( ";----------------------------------------------------------------" );
-                newline();
-                printf( ";        Function: %s", ( name ) ? name : "" );
-                newline(); newline();
-            }
-
-            mode = CODE;
+            emit_command( OMIT, cmds[k].addr, 0, NULL );
+            continue;
         }
-        else if ( mode == BITMAPS )
-        {
-            /*****************************************************************
-            *            m - BITMAPS
-            *****************************************************************/
-            
-            newline();
-            printcomment( blockcmt, addr, 0 );
-
-            while ( addr < clist->addr )
-            {
-                UBYTE bitmap;
-                UBYTE mask = 0x80;
-                
-                emitaddr( addr, &params );
-                if ( params.want_asm_out )
-                    printf( params.want_stripped ? "   " : "\n   " );
-                printf( "DB      " );
 
-                bitmap = (UBYTE)next( f, &addr );
-                printf( "%02X", bitmap );
-                
-                printf( "    " );
-                if ( params.want_asm_out )
-                    printf( ";" );
-                    
-                printf( " [" );
-                for ( ; mask; mask >>= 1 )
-                    putchar( bitmap & mask ? '#' : '.' );
-                printf( "]" ); newline();
-            }
+        emit_command( END, base + length, 0,
+                      user_name( k < params.ncmds ? cmds[k].name : NULL ) );
+        break;
+    }
 
-            mode = clist->mode;
-            if ( mode == CODE || mode == PROCS )
-                newline();
-            name  = clist->name; 
-            bpl   = clist->bpl;
-            clist = clist->n;
-        }
-    } /* while() */
-     
-    fclose( f );
+    image_close();
 }
 
 /***********************************************************
@@ -1293,7 +3304,7 @@ static void run_disasm( struct params params )
  *
  ************************************************************/
 
-#define OPTSTRING        "asxho:"
+#define OPTSTRING        "asxdho:j:c:y:X:q:T:"
 
 static struct params process_args( int argc, char **argv )
 {
@@ -1317,10 +3328,64 @@ static struct params process_args( int argc, char **argv )
             params.want_xref = 1;
             break;
          
+        case 'd':
+            params.want_discover = 1;
+            break;
+         
         case 'o':
             params.outputfile = (const char*)dupstr(optarg);
             break;
          
+        case 'c':
+            params.cachefile = (const char*)dupstr(optarg);
+            break;
+         
+        case 'y':
+            params.symfiles = realloc( params.symfiles, ( params.nsymfiles + 1 ) * sizeof( char * ) );
+            if ( !params.symfiles )
+                error( "Out of memory for symbol files" );
+            params.symfiles[params.nsymfiles++] = (const char*)dupstr(optarg);
+            break;
+         
+        case 'X':
+            {
+                char *sep = strchr( optarg, ':' );
+
+                if ( !sep || !sep[1] )
+                    error( "Missing file name for -X, use `-X fmt:file'" );
+
+                if ( strncmp( optarg, "jsonl:", 6 ) == 0 )
+                    params.xrefformat = XREF_JSONL;
+                else if ( strncmp( optarg, "csv:", 4 ) == 0 )
+                    params.xrefformat = XREF_CSV;
+                else if ( strncmp( optarg, "bin:", 4 ) == 0 )
+                    params.xrefformat = XREF_BIN;
+                else
+                    error( "Unknown xref export format in `-X %s'", optarg );
+
+                params.xrefexport = (const char*)dupstr( sep + 1 );
+            }
+            break;
+         
+        case 'q':
+            params.queries = realloc( params.queries, ( params.nqueries + 1 ) * sizeof( char * ) );
+            if ( !params.queries )
+                error( "Out of memory for queries" );
+            params.queries[params.nqueries++] = (const char*)dupstr(optarg);
+            break;
+         
+        case 'T':
+            params.bench_passes = atoi( optarg );
+            if ( params.bench_passes < 1 )
+                error( "Number of benchmark passes must be at least 1" );
+            break;
+         
+        case 'j':
+            params.jobs = atoi( optarg );
+            if ( params.jobs < 1 )
+                error( "Number of jobs must be at least 1" );
+            break;
+         
         case 'h':
             usage();
             break;
@@ -1354,10 +3419,11 @@ static void display_banner( struct params params )
 {
     char *prefix = params.outputfile ? COMMENT_DELIM : "";
     
-    printf( "%s   %s -- %s Disassembler --", prefix, dasm_name, dasm_description ); newline();
-    printf( "%s" SPACER, prefix ); 
-    newline();
-    newline();
+    out_printf( "%s   %s -- %s Disassembler --", prefix, dasm_name, dasm_description ); out_newline();
+    out_str( prefix );
+    out_str( SPACER );
+    out_newline();
+    out_newline();
 }
 
 /*****************************************************************************
@@ -1382,6 +3448,13 @@ void error( char *fmt, ... )
     va_list ap;
 
     va_start( ap, fmt );
+
+    if ( error_trap )
+    {
+        vsnprintf( error_trap->msg, sizeof( error_trap->msg ), fmt, ap );
+        va_end( ap );
+        longjmp( error_trap->env, 1 );
+    }
     
     fprintf ( stderr, "%s :: Error :: ", dasm_name );
     vfprintf( stderr, fmt, ap );
@@ -1389,6 +3462,9 @@ void error( char *fmt, ... )
 
     va_end( ap );
 
+    /* Keep whatever listing was produced before the error */
+    out_flush();
+
     exit(EXIT_FAILURE);
 }
 
@@ -1463,35 +3539,117 @@ char * dupstr( const char *s )
     return p;
 }
 
+/***********************************************************
+ *
+ * FUNCTION
+ *      dasm_ctx_init
+ *
+ * DESCRIPTION
+ *      Prepares a decoder context to read from the input image
+ *       at its current cursor.  Xrefs go to the global xref
+ *       store until ctx->xref is set.
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+void dasm_ctx_init( dasm_ctx_t *ctx )
+{
+    memset( ctx, 0, sizeof( *ctx ) );
+
+    image_seek( ctx, image.origin );
+    ctx->insn_bytes = zalloc( dasm_max_insn_length );
+    ctx->tos        = -1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      dasm_ctx_free
+ *
+ * DESCRIPTION
+ *      Releases the memory held by a decoder context.
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+void dasm_ctx_free( dasm_ctx_t *ctx )
+{
+    free( ctx->insn_bytes );
+    ctx->insn_bytes = NULL;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      dasm_addxref
+ *
+ * DESCRIPTION
+ *      Records a cross reference found while decoding, either
+ *       in the global xref store or through the context's
+ *       xref sink.  In a banked address space the reference
+ *       is qualified with its bank (see xref_bankref()).
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+void dasm_addxref( dasm_ctx_t *ctx, XREF_TYPE type, ADDR addr, ADDR ref )
+{
+    if ( banked )
+    {
+        if ( ( type == X_JMP || type == X_CALL ) && xref_crossbank( addr, ref ) )
+            ctx->xbank = 1;
+        ref = xref_bankref( addr, ref );
+    }
+
+    if ( ctx->xref )
+        ctx->xref( ctx->xref_arg, type, addr, ref );
+    else
+        xref_addxref( type, addr, ref );
+}
+
 /***********************************************************
  *
  * FUNCTION
  *      next
  *
  * DESCRIPTION
- *      Reads the next byte from the file stream, stores it in
- *      the instruction buffer, and returns it.
- *      If EOF then abort.
+ *      Reads the next byte from the context's input, stores it
+ *      in the instruction buffer, and returns it.
+ *      If EOF then abort, or with soft_eof set flag it in
+ *       the context and return 0.
  *
  * RETURNS
- *      next byte in file stream
+ *      next byte in input image
  *      addr incremented
  *
  ************************************************************/
 
-UBYTE next( FILE* fp, ADDR *addr )
+UBYTE next( dasm_ctx_t *ctx, ADDR *addr )
 {
-    int c;
+    UBYTE c;
     
-    c = fgetc( fp );
-    if ( c == EOF )
-        error( "Ran past end of input file" );
+    if ( ctx->cur >= ctx->end && !image_refill( ctx ) )
+    {
+        if ( !ctx->soft_eof )
+            error( "Ran past end of input file" );
+        ctx->eof = 1;
+        (*addr)++;
+        return 0;
+    }
         
-    if ( insn_byte_idx < dasm_max_insn_length )
-        insn_byte_buffer[insn_byte_idx++] = (UBYTE)c;
+    c = *ctx->cur++;
+    
+    if ( ctx->insn_len < dasm_max_insn_length )
+        ctx->insn_bytes[ctx->insn_len++] = c;
     
     (*addr)++;
-    return (UBYTE)c;
+    return c;
 }
 
 /***********************************************************
@@ -1500,35 +3658,50 @@ UBYTE next( FILE* fp, ADDR *addr )
  *      nextw
  *
  * DESCRIPTION
- *      Gets the next word from the file stream.  
+ *      Gets the next word from the context's input.  
  *      If EOF then abort.
  *      Need to swap the order that bytes are put in the 
  *      byte buffer so that they appear in the right order
  *      in the listing.
  *
  * RETURNS
- *      next word in fp
+ *      next word in image
  *
  ************************************************************/
 
-UWORD nextw( FILE* fp, ADDR *addr )
+UWORD nextw( dasm_ctx_t *ctx, ADDR *addr )
 {
     int lo, hi;
     UWORD w = 0;
     
-    lo = fgetc( fp );
-    if ( lo == EOF )
-        error( "Ran past end of input file" );
-        
-    hi = fgetc( fp );
-    if ( hi == EOF )
-        error( "Ran past end of input file" );    
+    if ( ctx->end - ctx->cur >= 2 )
+    {
+        lo = ctx->cur[0];
+        hi = ctx->cur[1];
+        ctx->cur += 2;
+    }
+    else
+    {
+        /* The word runs into the next segment, or off the end */
+        lo = ( ctx->cur < ctx->end || image_refill( ctx ) ) ? *ctx->cur++ : -1;
+        hi = ( lo >= 0 && ( ctx->cur < ctx->end || image_refill( ctx ) ) ) ? *ctx->cur++ : -1;
+
+        if ( hi < 0 )
+        {
+            if ( !ctx->soft_eof )
+                error( "Ran past end of input file" );
+            ctx->eof = 1;
+            ctx->cur = ctx->end;
+            (*addr) += 2;
+            return 0;
+        }
+    }
         
-    if ( insn_byte_idx < dasm_max_insn_length )
-        insn_byte_buffer[insn_byte_idx++] = (UBYTE)hi;
+    if ( ctx->insn_len < dasm_max_insn_length )
+        ctx->insn_bytes[ctx->insn_len++] = (UBYTE)hi;
         
-    if ( insn_byte_idx < dasm_max_insn_length )
-        insn_byte_buffer[insn_byte_idx++] = (UBYTE)lo;
+    if ( ctx->insn_len < dasm_max_insn_length )
+        ctx->insn_bytes[ctx->insn_len++] = (UBYTE)lo;
     
     (*addr)++;
     (*addr)++;
@@ -1547,27 +3720,25 @@ UWORD nextw( FILE* fp, ADDR *addr )
  *      peek
  *
  * DESCRIPTION
- *      Gets the next byte from the file stream but does not
- *       increment the stream pointer.  If EOF then abort.
+ *      Gets the next byte from the context's input but does
+ *       not advance the read cursor.  If EOF then abort.
  *
  * RETURNS
- *      next byte in fp
+ *      next byte in image
  *
  ************************************************************/
 
-UBYTE peek( FILE *fp )
+UBYTE peek( dasm_ctx_t *ctx )
 {
-    int c;
-    
-    c = fgetc( fp );
-    if ( c == EOF )
-        error( "Ran past end of input file" );
-        
-    c = ungetc( c, fp );
-    if ( c == EOF )
-        error( "Unable to peek at input file" );
+    if ( ctx->cur >= ctx->end && !image_refill( ctx ) )
+    {
+        if ( !ctx->soft_eof )
+            error( "Ran past end of input file" );
+        ctx->eof = 1;
+        return 0;
+    }
     
-    return (UBYTE)c;
+    return *ctx->cur;
 }
 
 /***********************************************************
@@ -1586,27 +3757,65 @@ UBYTE peek( FILE *fp )
 int main(int argc, char **argv)
 {
     struct params params;
+    int i;
     
     params = process_args( argc, argv );
 
     /* Process first arg: listfile */
-    readlist( params.listfile, &params );
+    if ( !params.cachefile || !cache_load( &params ) )
+    {
+        cmdcache.recording = params.cachefile != NULL;
+        readlist( params.listfile, &params );
+        addentry( &params );
+        addbankends( &params );
+        cmdcache.recording = 0;
+        if ( params.cachefile )
+            cache_save( &params );
+    }
+
+    /* Symbol files given on the command line come after the command file,
+     * so its labels take precedence.
+     */
+    for ( i = 0; i < params.nsymfiles; i++ )
+        importsymbols( params.symfiles[i] );
 
     /* Check things are set up ready to run */
-    if ( !params.cmdlist )
+    if ( !params.ncmds )
         error( "Empty list file" );
 
-    if ( !params.inputfile )
+    sortlist( &params );
+    sortcomments( &linecmt );
+    sortcomments( &blockcmt );
+
+    if ( !params.ninputs )
         error( "No input file specified" );
-        
-    /* Prepare then instruction byte buffer */
-    insn_byte_buffer = zalloc( dasm_max_insn_length );
-    insn_byte_idx = 0;
     
     if ( params.outputfile && !freopen( params.outputfile, "w", stdout ) )
         error( "Failed to open output file \"%s\"", params.outputfile );
 
-    emit_page_header();
+    if ( params.bench_passes )
+    {
+        run_bench( params );
+        out_flush();
+        return EXIT_SUCCESS;
+    }
+
+    if ( params.nqueries )
+    {
+        run_query( params );
+        out_flush();
+        return EXIT_SUCCESS;
+    }
+
+    if ( params.want_discover )
+    {
+        run_discover( params );
+        out_flush();
+        return EXIT_SUCCESS;
+    }
+
+    out_paginate( pagination, page_title );
+    out_page_header();
     display_banner( params );
 
     run_disasm( params );
@@ -1614,6 +3823,11 @@ int main(int argc, char **argv)
     if ( params.want_xref )
         xref_dump();
 
+    if ( params.xrefexport )
+        xref_export( params.xrefformat, params.xrefexport );
+
+    out_flush();
+
     return EXIT_SUCCESS;
 }
 
@@ -40,6 +40,9 @@
 #define MIN(a,b)        ((a)<(b)?(a):(b))
 #define MAX(a,b)        ((a)>(b)?(a):(b))
 
+/* Per-thread storage class */
+#define THREAD_LOCAL    __thread
+
 /*****************************************************************************/
 /*                              Machine Types                                */
 /*****************************************************************************/
@@ -56,8 +59,22 @@ typedef unsigned int       ULWORD;
 /* Derived types */
 typedef UWORD              OPC;
 
-/* Universal address format */
-#define FORMAT_ADDR		"%04X"
+/* Universal address format.  Takes the number of digits, then the address:
+ *  printf( FORMAT_ADDR, ADDR_DIGITS, addr )
+ */
+#define FORMAT_ADDR		"%0*X"
+#define ADDR_DIGITS		dasm_addr_digits
+
+/* Banked addresses.  In a banked address space the bank number is held
+ * above the CPU address, so each bank's copy of the banked window has its
+ * own addresses, and so its own labels and xrefs.  Bank 0 also holds the
+ * common (unbanked) memory.
+ */
+#define BANK_SHIFT          ( 24 )
+#define BANK_MAX            ( 0xFF )
+#define BANK_OF(M_a)        ( (ADDR)(M_a) >> BANK_SHIFT )
+#define BANK_CPU(M_a)       ( (ADDR)(M_a) & ( ( 1u << BANK_SHIFT ) - 1 ) )
+#define BANK_ADDR(M_b, M_a) ( ( (ADDR)(M_b) << BANK_SHIFT ) | (ADDR)(M_a) )
 
 /* Prefix for generated labels */
 #define GEN_LABEL_PREFIX    "___"
@@ -69,11 +86,159 @@ typedef UWORD              OPC;
 extern void error( char *fmt, ... );
 extern void warning( char *fmt, ... );
 extern void *zalloc( size_t n );
-extern UBYTE next( FILE* fp, ADDR *addr );
-extern UWORD nextw( FILE *fp, ADDR *addr );
-extern UBYTE peek( FILE *fp );
 extern char * dupstr( const char *s );
 
+/*****************************************************************************/
+/*                              Arena Allocation                             */
+/*****************************************************************************/
+
+extern void *arena_alloc( size_t n );
+extern char * arena_strdup( const char *s );
+extern char * arena_intern( const char *s );
+
+/*****************************************************************************/
+/*                              Input Image                                  */
+/*****************************************************************************/
+
+/* A run of input bytes at a load address */
+struct image_seg {
+    ADDR         base;      /* Address of first byte                */
+    size_t       length;    /* Number of bytes                      */
+    const UBYTE *data;      /* The bytes                            */
+    UBYTE       *heap;      /* Allocation owned by the image, or NULL */
+    size_t       size;      /* Size of heap allocation              */
+    unsigned int lanes;     /* Interleave of a byte lane segment    */
+};
+
+/* The input, as segments in address order.  Disassembly starts at
+ * image.origin; each decoder context has its own read cursor.  The
+ * page table gives, for each page of the address range, the first
+ * segment that ends beyond the start of the page.
+ */
+struct image {
+    struct image_seg *segs;
+    size_t       nsegs;
+    size_t       segs_size;
+    size_t       length;    /* Total bytes loaded                   */
+    ADDR         start;     /* Address of first byte loaded         */
+    ADDR         end;       /* One past address of last byte loaded */
+    ADDR         origin;    /* Where disassembly starts             */
+    ULWORD      *pages;     /* Page table                           */
+    size_t       npages;
+    unsigned int page_bits; /* log2 of page size                    */
+};
+
+/* An input file and where to load it, from an f command */
+struct image_input {
+    const char  *name;
+    int          placed;    /* Set if addr was given                */
+    ADDR         addr;      /* Load address                         */
+    unsigned int lane;      /* Byte lane of an interleaved image    */
+    unsigned int lanes;     /*  of this many lanes, or 0            */
+    size_t       length;    /* Bytes loaded, set by image_open()    */
+};
+
+extern struct image image;
+
+typedef struct dasm_ctx_s dasm_ctx_t;
+
+extern void image_open( struct image_input *inputs, size_t n, unsigned int offset, ADDR base );
+extern void image_close( void );
+extern const UBYTE * image_file( const char *filename, size_t *length );
+extern void image_add_segment( ADDR base, const UBYTE *data, size_t length, UBYTE *heap );
+extern void image_add_bytes( ADDR addr, const UBYTE *data, size_t n );
+extern void image_add_lane( ADDR base, const UBYTE *data, size_t length,
+                            unsigned int lane, unsigned int lanes );
+extern void image_seek( dasm_ctx_t *ctx, ADDR addr );
+extern int image_refill( dasm_ctx_t *ctx );
+extern int image_byte( ADDR addr );
+extern int image_loaded( ADDR addr );
+
+/*****************************************************************************/
+/*                              Image Loaders                                */
+/*****************************************************************************/
+
+/* ELF identification (also used by symbols.c) */
+#define EI_CLASS        4
+#define EI_DATA         5
+#define ELFCLASS32      1
+#define ELFCLASS64      2
+#define ELFDATA2MSB     2
+
+extern int loader_load( const char *filename );
+extern int loader_is_elf( const char *filename );
+extern int loader_elf_entry( const UBYTE *data, size_t length, ADDR *entry );
+extern unsigned long long elf_get( const UBYTE *p, int n, int msb );
+
+/*****************************************************************************/
+/*                              Command File                                 */
+/*****************************************************************************/
+
+/* A command file, mapped into memory and split into lines in place */
+typedef struct cmdfile_s {
+    const char   *name;     /* File name, for diagnostics           */
+    char         *data;     /* File contents                        */
+    size_t        length;   /* Length of file (bytes)               */
+    size_t        pos;      /* Offset of next line                  */
+    size_t        start;    /* Offset of current line               */
+    unsigned int  lineno;   /* Number of current line               */
+    char         *tail;     /* Copy of a last line with no newline  */
+    int           mapped;   /* Set if data is a mapping             */
+} cmdfile_t;
+
+extern int cmdfile_open( cmdfile_t *cf, const char *filename );
+extern char * cmdfile_getline( cmdfile_t *cf );
+extern void cmdfile_close( cmdfile_t *cf );
+extern unsigned long long cmdfile_hash( const cmdfile_t *cf );
+extern int cmdfile_hex( char **p, unsigned long *val );
+extern int cmdfile_dec( char **p, long *val );
+extern int cmdfile_hexval( int c );
+extern int cmdfile_has_ext( const char *name, const char *ext );
+
+/*****************************************************************************/
+/*                              Listing Output                               */
+/*****************************************************************************/
+
+#define COMMENT_DELIM        ";"
+
+/* Output captured in memory by one thread for writing out later */
+typedef struct out_capture_s {
+    char   *text;           /* Captured text                        */
+    size_t  len;            /* Length of text                       */
+    size_t *lines;          /* Offset just past each counted newline*/
+    size_t  nlines;
+    size_t  lines_size;
+} out_capture_t;
+
+/* Size of buffer for out_addrstr() */
+#define OUT_ADDR_SIZE       ( 16 )
+
+/* out_addrstr() into a buffer that lasts until the end of the
+ * enclosing block, so may be used more than once in an expression.
+ */
+#define OUT_ADDRSTR(M_addr) \
+    out_addrstr( (char[OUT_ADDR_SIZE]){ 0 }, OUT_ADDR_SIZE, M_addr )
+
+extern void out_flush( void );
+extern unsigned long out_count( void );
+extern void out_char( int c );
+extern void out_strn( const char *s, size_t n );
+extern void out_str( const char *s );
+extern void out_spaces( int n );
+extern void out_padstr( const char *s, int width );
+extern void out_hex( unsigned long v, int digits );
+extern void out_addr( ADDR addr );
+extern char *out_addrstr( char *buf, size_t size, ADDR addr );
+extern void out_setbanked( int banked );
+extern void out_printf( const char *fmt, ... );
+extern void out_paginate( int lines, const char *title );
+extern void out_page_header( void );
+extern void out_newline( void );
+extern void out_capture_begin( out_capture_t *cap );
+extern void out_capture_end( void );
+extern void out_capture_write( const out_capture_t *cap );
+extern void out_capture_free( out_capture_t *cap );
+
 /*****************************************************************************/
 /*                              Cross Referencing                            */
 /*****************************************************************************/
@@ -91,17 +256,100 @@ typedef enum {
    X_IO     = 8
 } XREF_TYPE;
 
+/* Formats for xref_export() */
+typedef enum {
+   XREF_JSONL,
+   XREF_CSV,
+   XREF_BIN
+} XREF_FORMAT;
+
+typedef void (*XREF_SINK)( void *arg, XREF_TYPE type, ADDR addr, ADDR ref );
+
+/* Size of buffer for xref_genwordaddr() */
+#define XREF_ADDR_SIZE      ( 64 )
+
+/* xref_genwordaddr() into a buffer that lasts until the end of the
+ * enclosing block, so may be used more than once in an expression.
+ * For use in operand functions: the reference is from the instruction
+ * being decoded.
+ */
+#define XREF_WORDADDR(M_format, M_addr) \
+    xref_genwordaddr( (char[XREF_ADDR_SIZE]){ 0 }, XREF_ADDR_SIZE, M_format, M_addr, ctx->insn_addr )
+
+/* A label for xref_addlabels() */
+typedef struct xref_label_s {
+    ADDR    ref;
+    char   *label;
+} xref_label_t;
+
 extern void xref_addxref( XREF_TYPE type, ADDR addr, ADDR ref );
-extern void xref_addxreflabel( ADDR ref, char *label );
+extern char * xref_addxreflabel( ADDR ref, char *label );
+extern void xref_addlabels( xref_label_t *labels, size_t n );
 extern char * xref_findaddrlabel( ADDR addr );
-extern char * xref_genwordaddr( char * buf, const char * format, ADDR addr );
+extern char * xref_genwordaddr( char * buf, size_t size, const char * format, ADDR addr, ADDR from );
+extern void xref_setbanks( ADDR lo, ADDR hi );
+extern int xref_banked( void );
+extern ADDR xref_bankref( ADDR from, ADDR ref );
+extern int xref_crossbank( ADDR from, ADDR ref );
 extern void xref_dump( void );
+extern void xref_export( XREF_FORMAT format, const char *filename );
+extern void xref_query( const char *spec );
+
+/*****************************************************************************/
+/*                              Symbol Import                                */
+/*****************************************************************************/
+
+extern xref_label_t * sym_read( cmdfile_t *cf, size_t *n );
+extern xref_label_t * sym_read_elf( cmdfile_t *cf, size_t *n );
 
 /*****************************************************************************/
 /*                              Disassembler                                 */
 /*****************************************************************************/
 
-extern ADDR dasm_insn( FILE *f, char * outbuf, ADDR addr );
+/* Depth of the opcode stack used by PUSHTBL */
+#define DASM_STACK_DEPTH    ( 16 )
+
+/* Decoder context.  Holds all of the state needed to decode a stream of
+ * instructions so that independent streams can be decoded concurrently.
+ */
+struct dasm_ctx_s {
+    const UBYTE * cur;          /* Read cursor into input image     */
+    const UBYTE * end;          /* One past last readable byte      */
+    ADDR          end_addr;     /* Address of the byte at end       */
+    char        * outbuf;       /* Decoded text is written here,    */
+                                /*  NULL to decode only             */
+    ADDR          insn_addr;    /* Start address of current insn    */
+    UBYTE       * insn_bytes;   /* Bytes read for current insn      */
+    int           insn_len;     /* Number of bytes in insn_bytes    */
+    OPC           opcstack[DASM_STACK_DEPTH]; /* PUSHTBL opcodes    */
+    int           tos;          /* Top of opcstack, -1 if empty     */
+    int           state;        /* Decoder-private state            */
+    XREF_SINK     xref;         /* Where xrefs go, NULL for global  */
+    void        * xref_arg;     /* Passed to xref sink              */
+    int           soft_eof;     /* Reading past end sets eof rather */
+    int           eof;          /*  than calling error()            */
+    int           undefined;    /* Set if the opcode is not known   */
+    int           flow_stop;    /* Set if execution does not carry  */
+                                /*  on to the next insn             */
+    int           xbank;        /* Set if a jump or call goes into  */
+                                /*  the banked window from outside  */
+};
+
+extern void dasm_ctx_init( dasm_ctx_t *ctx );
+extern void dasm_ctx_free( dasm_ctx_t *ctx );
+extern UBYTE next( dasm_ctx_t *ctx, ADDR *addr );
+extern UWORD nextw( dasm_ctx_t *ctx, ADDR *addr );
+extern UBYTE peek( dasm_ctx_t *ctx );
+extern void dasm_addxref( dasm_ctx_t *ctx, XREF_TYPE type, ADDR addr, ADDR ref );
+
+/* Decoders write their operand text with operand().  When decoding only
+ * (no output buffer) it does nothing, and its arguments, which must not
+ * have side effects, are not evaluated.
+ */
+#define operand( M_ctx, ... ) \
+    do { if ( (M_ctx)->outbuf ) operand_text( M_ctx, __VA_ARGS__ ); } while ( 0 )
+
+extern ADDR dasm_insn( dasm_ctx_t *ctx, char * outbuf, ADDR addr );
 extern const char * dasm_name;
 extern const char * dasm_description;
 extern const int    dasm_max_insn_length;
@@ -109,15 +357,55 @@ extern const int    dasm_max_opcode_width;
 extern const int    dasm_word_msb_first;
 extern const int    dasm_insn_width_bytes;
 extern const int    dasm_word_width_bytes;
+extern const int    dasm_addr_digits;
+extern const int    dasm_vector_bytes;
 
-#define DASM_PROFILE(name,desc,insnlen,opwid,msb,iwid,wwid) \
+/* iwid is the size of an opcode fetch in bytes; wwid is the number of
+ * bytes in each address unit of the command file and the listing; adig
+ * is the number of hex digits in an address (in those units), enough for
+ * the whole address space; vwid is the size of a vector ('v' command) in
+ * bytes.
+ */
+#define DASM_PROFILE(name,desc,insnlen,opwid,msb,iwid,wwid,adig,vwid) \
     const char * dasm_name = name;                /* Name of assembler     */ \
     const char * dasm_description = desc;         /* Target description    */ \
     const int    dasm_max_insn_length = insnlen;  /* Max bytes per insn    */ \
     const int    dasm_max_opcode_width = opwid;   /* Max chars insn name   */ \
     const int    dasm_word_msb_first = msb;       /* 1 if word is MSB first*/ \
     const int    dasm_insn_width_bytes = iwid;    /* Num bytes per opcode  */ \
-    const int    dasm_word_width_bytes = iwid;    /* Num bytes per word    */
+    const int    dasm_word_width_bytes = wwid;    /* Num bytes per word    */ \
+    const int    dasm_addr_digits = adig;         /* Hex digits per addr   */ \
+    const int    dasm_vector_bytes = vwid;        /* Num bytes per vector  */
+
+/*****************************************************************************/
+/*                              Code Discovery                               */
+/*****************************************************************************/
+
+/* Per-byte flags in the discovery map */
+#define FLOW_DATA       ( 0x01 )    /* Must not be decoded as code      */
+#define FLOW_CODE       ( 0x02 )    /* Part of a decoded instruction    */
+#define FLOW_INSN       ( 0x04 )    /* First byte of an instruction     */
+#define FLOW_CALL       ( 0x08 )    /* Target of a call                 */
+
+/* Reads a map byte that the discovery threads may be updating */
+#define FLOW_FLAGS(M_p) __atomic_load_n( (M_p), __ATOMIC_RELAXED )
+
+/* Code discovery state.  map[] covers the input image from base. */
+typedef struct flow_s {
+    ADDR     base;          /* Address of first byte in map         */
+    size_t   length;        /* Number of bytes in map               */
+    UBYTE  * map;           /* FLOW_xxx flags for each byte         */
+    unsigned long * visited; /* Bit set for each address visited   */
+    ADDR   * work;          /* Addresses still to be explored       */
+    size_t   nwork;
+    size_t   work_size;
+    size_t   ninsns;        /* Number of instructions found         */
+} flow_t;
+
+extern void flow_init( flow_t *flow, ADDR base, size_t length );
+extern void flow_free( flow_t *flow );
+extern void flow_add_root( flow_t *flow, ADDR addr );
+extern void flow_run( flow_t *flow, int jobs );
 
 /*****************************************************************************/
 
@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm02", "MOS Technology 6502", 3, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm02", "MOS Technology 6502", 3, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -84,9 +84,9 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -95,10 +95,10 @@ OPERAND_FUNC(imm8)
 
 OPERAND_FUNC(zeropage)
 {
-    UBYTE zp = next( f, addr );
+    UBYTE zp = next( ctx, addr );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_8BIT, (ADDR)zp ) );
-    xref_addxref( xtype, g_insn_addr, zp );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_8BIT, (ADDR)zp ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, zp );
 }
 
 /***********************************************************
@@ -107,9 +107,9 @@ OPERAND_FUNC(zeropage)
 
 OPERAND_FUNC(zeropage_X)
 {
-    operand_zeropage( f, addr, opc, xtype );
+    operand_zeropage( ctx, addr, opc, xtype );
     COMMA;
-    operand( "X" );
+    operand( ctx, "X" );
 }
 
 /***********************************************************
@@ -118,9 +118,9 @@ OPERAND_FUNC(zeropage_X)
 
 OPERAND_FUNC(zeropage_Y)
 {
-    operand_zeropage( f, addr, opc, xtype );
+    operand_zeropage( ctx, addr, opc, xtype );
     COMMA;
-    operand( "Y" );
+    operand( ctx, "Y" );
 }
 
 /***********************************************************
@@ -129,12 +129,12 @@ OPERAND_FUNC(zeropage_Y)
 
 OPERAND_FUNC(abs16)
 {
-    UBYTE low_addr  = next( f, addr );
-    UBYTE high_addr = next( f, addr );
+    UBYTE low_addr  = next( ctx, addr );
+    UBYTE high_addr = next( ctx, addr );
     UWORD addr16    = MK_WORD( low_addr, high_addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -143,15 +143,15 @@ OPERAND_FUNC(abs16)
 
 OPERAND_FUNC(abs16_X)
 {
-    UBYTE low_addr  = next( f, addr );
-    UBYTE high_addr = next( f, addr );
+    UBYTE low_addr  = next( ctx, addr );
+    UBYTE high_addr = next( ctx, addr );
     UWORD addr16    = MK_WORD( low_addr, high_addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
     COMMA;
-    operand( "X" );
+    operand( ctx, "X" );
     
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -160,15 +160,15 @@ OPERAND_FUNC(abs16_X)
 
 OPERAND_FUNC(abs16_Y)
 {
-    UBYTE low_addr  = next( f, addr );
-    UBYTE high_addr = next( f, addr );
+    UBYTE low_addr  = next( ctx, addr );
+    UBYTE high_addr = next( ctx, addr );
     UWORD addr16    = MK_WORD( low_addr, high_addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
     COMMA;
-    operand( "Y" );
+    operand( ctx, "Y" );
     
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -177,10 +177,10 @@ OPERAND_FUNC(abs16_Y)
 
 OPERAND_FUNC(ind8_X)
 {
-    operand( "(" );
-    operand_zeropage( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_zeropage( ctx, addr, opc, xtype );
     COMMA;
-    operand( "X)" );
+    operand( ctx, "X)" );
 }
 
 /***********************************************************
@@ -189,11 +189,11 @@ OPERAND_FUNC(ind8_X)
 
 OPERAND_FUNC(ind8_Y)
 {
-    operand( "(" );
-    operand_zeropage( f, addr, opc, xtype );
-    operand( ")" );
+    operand( ctx, "(" );
+    operand_zeropage( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
     COMMA;
-    operand( "Y" );
+    operand( ctx, "Y" );
 }
 
 /***********************************************************
@@ -202,13 +202,13 @@ OPERAND_FUNC(ind8_Y)
 
 OPERAND_FUNC(ind16)
 {
-    UBYTE low_addr  = next( f, addr );
-    UBYTE high_addr = next( f, addr );
+    UBYTE low_addr  = next( ctx, addr );
+    UBYTE high_addr = next( ctx, addr );
     UWORD addr16    = MK_WORD( low_addr, high_addr );
 
-    operand( "(%s)", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
+    operand( ctx, "(%s)", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
     
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -217,11 +217,11 @@ OPERAND_FUNC(ind16)
 
 OPERAND_FUNC(rel8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /******************************************************************************/
@@ -364,10 +364,10 @@ optab_t base_optab[] = {
   Jumps and Calls
   ----------------------------------------------------------------------------*/
   
-    INSN ( "jmp", abs16,      0x4C, X_JMP  )
-    INSN ( "jmp", ind16,      0x6C, X_PTR  )
+    INSN_STOP ( "jmp", abs16,      0x4C, X_JMP  )
+    INSN_STOP ( "jmp", ind16,      0x6C, X_PTR  )
     INSN ( "jsr", abs16,      0x20, X_CALL )
-    INSN ( "rts", none,       0x60, X_NONE )
+    INSN_STOP ( "rts", none,       0x60, X_NONE )
     
 /*----------------------------------------------------------------------------
   Conditional Branch
@@ -400,7 +400,7 @@ optab_t base_optab[] = {
     
     INSN ( "brk",     none, 0x00, X_NONE )
     INSN ( "nop",     none, 0xEA, X_NONE )
-    INSN ( "rti",     none, 0x40, X_NONE )
+    INSN_STOP ( "rti",     none, 0x40, X_NONE )
 
     END
 };
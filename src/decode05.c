@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm05", "Motorola 6805", 3, 9, 1, 1, 1 )
+DASM_PROFILE( "dasm05", "Motorola 6805", 3, 9, 1, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -80,75 +80,75 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 
 OPERAND_FUNC(direct)
 {
-    UBYTE a = next( f, addr );
+    UBYTE a = next( ctx, addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_8BIT, (ADDR)a ));
-    xref_addxref( xtype, g_insn_addr, a);
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_8BIT, (ADDR)a ));
+    dasm_addxref( ctx, xtype, ctx->insn_addr, a);
 }
 
 OPERAND_FUNC(rel8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 OPERAND_FUNC(extended)
 {
-    UBYTE msb    = next( f, addr );
-    UBYTE lsb    = next( f, addr );
+    UBYTE msb    = next( ctx, addr );
+    UBYTE lsb    = next( ctx, addr );
     UWORD addr16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 OPERAND_FUNC(bitmanip)
 {
-    operand( "%1d", (opc >> 1) & 0x7 );
+    operand( ctx, "%1d", (opc >> 1) & 0x7 );
 }
 
 OPERAND_FUNC(btb)
 {
-    operand_bitmanip( f, addr, opc, xtype );
+    operand_bitmanip( ctx, addr, opc, xtype );
     COMMA;
-    operand_direct( f, addr, opc, X_DIRECT );
+    operand_direct( ctx, addr, opc, X_DIRECT );
     COMMA;
-    operand_rel8( f, addr, opc, xtype );
+    operand_rel8( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(bsc)
 {
-    operand_bitmanip( f, addr, opc, xtype );
+    operand_bitmanip( ctx, addr, opc, xtype );
     COMMA;
-    operand_direct( f, addr, opc, xtype );
+    operand_direct( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(ix)
 {
-    operand( ",x" );
+    operand( ctx, ",x" );
 }
 
 OPERAND_FUNC(ix1)
 {
-    operand_direct( f, addr, opc, xtype );
-    operand_ix( f, addr, opc, xtype );
+    operand_direct( ctx, addr, opc, xtype );
+    operand_ix( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(ix2)
 {
-    operand_extended( f, addr, opc, xtype );
-    operand_ix( f, addr, opc, xtype );
+    operand_extended( ctx, addr, opc, xtype );
+    operand_ix( ctx, addr, opc, xtype );
 }
 
 /******************************************************************************/
@@ -174,7 +174,7 @@ optab_t base_optab[] = {
     /*
     * Branches
     */
-    INSN ( "bra",  rel8, 0x20, X_JMP )
+    INSN_STOP ( "bra",  rel8, 0x20, X_JMP )
     INSN ( "brn",  rel8, 0x21, X_JMP )
     INSN ( "bhi",  rel8, 0x22, X_JMP )
     INSN ( "bls",  rel8, 0x23, X_JMP )
@@ -225,6 +225,14 @@ optab_t base_optab[] = {
         INSN ( M_name, ix1,      (0xE0 | M_base), X_PTR ) \
         INSN ( M_name, ix,       (0xF0 | M_base), X_PTR)
 
+#define REGMEM_OP_STOP(M_name, M_base) \
+        INSN_STOP ( M_name, imm8,     (0xA0 | M_base), X_NONE ) \
+        INSN_STOP ( M_name, direct,   (0xB0 | M_base), X_DIRECT ) \
+        INSN_STOP ( M_name, extended, (0xC0 | M_base), X_PTR ) \
+        INSN_STOP ( M_name, ix2,      (0xD0 | M_base), X_PTR ) \
+        INSN_STOP ( M_name, ix1,      (0xE0 | M_base), X_PTR ) \
+        INSN_STOP ( M_name, ix,       (0xF0 | M_base), X_PTR)
+
 
     UNDEF( 0xA7 )
     UNDEF( 0xAC )
@@ -244,7 +252,7 @@ optab_t base_optab[] = {
     REGMEM_OP( "adc", 0x09 )
     REGMEM_OP( "ora", 0x0A )
     REGMEM_OP( "add", 0x0B )
-    REGMEM_OP( "jmp", 0x0C )
+    REGMEM_OP_STOP( "jmp", 0x0C )
     REGMEM_OP( "jsr", 0x0D )
     REGMEM_OP( "ldx", 0x0E )
     REGMEM_OP( "stx", 0x0F )
@@ -252,8 +260,8 @@ optab_t base_optab[] = {
     /*
     * Control
     */
-    INSN ( "rti",  none, 0x80, X_NONE )
-    INSN ( "rts",  none, 0x81, X_NONE )
+    INSN_STOP ( "rti",  none, 0x80, X_NONE )
+    INSN_STOP ( "rts",  none, 0x81, X_NONE )
     INSN ( "swi",  none, 0x83, X_NONE )
     INSN ( "stop", none, 0x8E, X_NONE )
     INSN ( "wait", none, 0x8F, X_NONE )
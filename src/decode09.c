@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm09", "Motorola 6809", 4, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm09", "Motorola 6809", 4, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -84,9 +84,9 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -95,12 +95,12 @@ OPERAND_FUNC(imm8)
 
 OPERAND_FUNC(imm16)
 {
-    UBYTE msb   = next( f, addr );
-    UBYTE lsb   = next( f, addr );
+    UBYTE msb   = next( ctx, addr );
+    UBYTE lsb   = next( ctx, addr );
     UWORD imm16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, imm16 ) );
-    xref_addxref( xtype, g_insn_addr, imm16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, imm16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, imm16 );
 }
 
 /***********************************************************
@@ -109,10 +109,10 @@ OPERAND_FUNC(imm16)
 
 OPERAND_FUNC(direct)
 {
-    UBYTE a = next( f, addr );
+    UBYTE a = next( ctx, addr );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, (ADDR)a ) );
-    xref_addxref( xtype, g_insn_addr, a );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, (ADDR)a ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, a );
 }
 
 /***********************************************************
@@ -139,7 +139,7 @@ enum {
 
 OPERAND_FUNC(indexed)
 {
-    UBYTE postbyte = next( f, addr );
+    UBYTE postbyte = next( ctx, addr );
     UBYTE rr = ( postbyte >> 5 ) & 0x03;
     static const char * rrtab[] = { "X", "Y", "U", "S" };
     
@@ -147,7 +147,7 @@ OPERAND_FUNC(indexed)
     {
         BYTE offset = ((BYTE)( ( postbyte & 0x1F ) << 3 )) >> 3;
         
-        operand( "%d, %s", offset, rrtab[rr] );    
+        operand( ctx, "%d, %s", offset, rrtab[rr] );    
     }
     else
     {
@@ -155,90 +155,90 @@ OPERAND_FUNC(indexed)
         int   ind  = postbyte & 0x10;
         
         if ( ind )
-            operand("[");
+            operand(ctx, "[");
             
         switch ( mode )
         {
         case MODE_AUTO_INC:
-            operand( ",%s+", rrtab[rr] );
+            operand( ctx, ",%s+", rrtab[rr] );
             break;
             
         case MODE_AUTO_INC2:
-            operand( ",%s++", rrtab[rr] );
+            operand( ctx, ",%s++", rrtab[rr] );
             break;
             
         case MODE_AUTO_DEC:
-            operand( ",-%s", rrtab[rr] );
+            operand( ctx, ",-%s", rrtab[rr] );
             break;
             
         case MODE_AUTO_DEC2:
-            operand( ",--%s", rrtab[rr] );
+            operand( ctx, ",--%s", rrtab[rr] );
             break;
             
         case MODE_REG_ONLY:
-            operand( ",%s", rrtab[rr] );
+            operand( ctx, ",%s", rrtab[rr] );
             break;
             
         case MODE_REG_ACCB:
-            operand( "B, %s", rrtab[rr] );
+            operand( ctx, "B, %s", rrtab[rr] );
             break;
             
         case MODE_REG_ACCA:
-            operand( "A, %s", rrtab[rr] );
+            operand( ctx, "A, %s", rrtab[rr] );
             break;
             
         case MODE_REG_D:
-            operand( "D, %s", rrtab[rr] );
+            operand( ctx, "D, %s", rrtab[rr] );
             break;
             
         case MODE_REG_8OFF:
             {
-                BYTE offset = (BYTE)next( f, addr );
-                operand( "%d, %s", offset, rrtab[rr] );
+                BYTE offset = (BYTE)next( ctx, addr );
+                operand( ctx, "%d, %s", offset, rrtab[rr] );
             }
             break;
             
         case MODE_REG_16OFF:
             {
-                UBYTE msb    = next( f, addr );
-                UBYTE lsb    = next( f, addr );
+                UBYTE msb    = next( ctx, addr );
+                UBYTE lsb    = next( ctx, addr );
                 WORD  offset = MK_WORD( lsb, msb );
-                operand( "%d, %s", offset, rrtab[rr] );
+                operand( ctx, "%d, %s", offset, rrtab[rr] );
             }
             break;
             
         case MODE_PCR_8OFF:
             {
-                BYTE offset = (BYTE)next( f, addr );
-                operand( "%d, PCR", offset );
+                BYTE offset = (BYTE)next( ctx, addr );
+                operand( ctx, "%d, PCR", offset );
             }
             break;
             
         case MODE_PCR_16OFF:
             {
-                UBYTE msb    = next( f, addr );
-                UBYTE lsb    = next( f, addr );
+                UBYTE msb    = next( ctx, addr );
+                UBYTE lsb    = next( ctx, addr );
                 WORD  offset = MK_WORD( lsb, msb );
-                operand( "%d, PCR", offset );
+                operand( ctx, "%d, PCR", offset );
             }
             break;
             
         case MODE_EXT_IND:
             {
-                UBYTE msb = next( f, addr );
-                UBYTE lsb = next( f, addr );
+                UBYTE msb = next( ctx, addr );
+                UBYTE lsb = next( ctx, addr );
                 WORD  ea  = MK_WORD( lsb, msb );
-                operand( "%d", ea );
+                operand( ctx, "%d", ea );
             }
             break;
             
         default:
-            operand( "???" );
+            operand( ctx, "???" );
             break;
         }
         
         if ( ind )
-            operand("]");
+            operand(ctx, "]");
     }
 }
 
@@ -248,12 +248,12 @@ OPERAND_FUNC(indexed)
  
 OPERAND_FUNC(extended)
 {
-    UBYTE msb    = next( f, addr );
-    UBYTE lsb    = next( f, addr );
+    UBYTE msb    = next( ctx, addr );
+    UBYTE lsb    = next( ctx, addr );
     UWORD addr16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -262,11 +262,11 @@ OPERAND_FUNC(extended)
 
 OPERAND_FUNC(rel8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -275,13 +275,13 @@ OPERAND_FUNC(rel8)
 
 OPERAND_FUNC(rel16)
 {
-    UBYTE msb = next( f, addr );
-    UBYTE lsb = next( f, addr );
+    UBYTE msb = next( ctx, addr );
+    UBYTE lsb = next( ctx, addr );
     WORD disp = MK_WORD( lsb, msb );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -290,7 +290,7 @@ OPERAND_FUNC(rel16)
 
 OPERAND_FUNC(r1_r2)
 {
-    UBYTE postbyte = next( f, addr );
+    UBYTE postbyte = next( ctx, addr );
     int   src = ( postbyte >> 4 ) & 0x0F;
     int   dst =   postbyte        & 0x0F;
     
@@ -308,9 +308,9 @@ OPERAND_FUNC(r1_r2)
         "DPR"
     };
     
-    operand( "%s", rtab[dst] );
+    operand( ctx, "%s", rtab[dst] );
     COMMA;
-    operand( "%s", rtab[src] );
+    operand( ctx, "%s", rtab[src] );
 }
 
 /******************************************************************************/
@@ -417,6 +417,11 @@ static optab_t page3[] = {
         INSN(M_name, indexed,  (0x60 | M_base), X_NONE) \
         INSN(M_name, extended, (0x70 | M_base), X_NONE)
         
+#define SINGLE_OP_STOP(M_name, M_base) \
+        INSN_STOP(M_name, direct,   (0x00 | M_base), X_NONE) \
+        INSN_STOP(M_name, indexed,  (0x60 | M_base), X_NONE) \
+        INSN_STOP(M_name, extended, (0x70 | M_base), X_NONE)
+        
 #define ACC_ARGS_OP_NOIMM(M_name, M_base, M_xref)    \
         INSN(M_name, direct,   (0x90 | M_base), M_xref) \
         INSN(M_name, indexed,  (0xA0 | M_base), M_xref) \
@@ -475,7 +480,7 @@ optab_t base_optab[] = {
     INSN ( "ABX",  none, 0x3A, X_NONE )
     INSN ( "DAA",  none, 0x19, X_NONE )
     INSN ( "MUL",  none, 0x3D, X_NONE )
-    INSN ( "LBRA", rel16, 0x16, X_JMP )
+    INSN_STOP ( "LBRA", rel16, 0x16, X_JMP )
     INSN ( "LBSR", rel16, 0x17, X_JMP )
     
 /*----------------------------------------------------------------------------
@@ -540,7 +545,7 @@ optab_t base_optab[] = {
     INSN ( "BLE", rel8, 0x2F, X_JMP )
   
     INSN ( "BSR", rel8, 0x8D, X_JMP )
-    INSN ( "BRA", rel8, 0x20, X_JMP )
+    INSN_STOP ( "BRA", rel8, 0x20, X_JMP )
     INSN ( "BRN", rel8, 0x21, X_JMP )
     
 /*----------------------------------------------------------------------------
@@ -551,12 +556,12 @@ optab_t base_optab[] = {
     INSN ( "CWAI",  imm8, 0x3C, X_NONE )
     INSN ( "NOP",   none, 0x12, X_NONE )
     INSN ( "ORCC",  imm8, 0x1A, X_NONE )
-    INSN ( "RTI",   none, 0x3B, X_NONE )
-    INSN ( "RTS",   none, 0x39, X_NONE )
+    INSN_STOP ( "RTI",   none, 0x3B, X_NONE )
+    INSN_STOP ( "RTS",   none, 0x39, X_NONE )
     INSN ( "SWI",   none, 0x3F, X_NONE )
     INSN ( "SYNC",  none, 0x13, X_NONE )
 
-    SINGLE_OP( "JMP", 0x0E )
+    SINGLE_OP_STOP( "JMP", 0x0E )
     ACC_ARGS_OP_NOIMM( "JSR", 0x0D, X_CALL )
     
 /*----------------------------------------------------------------------------
@@ -48,7 +48,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm1802", "RCA CDP1802", 3, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm1802", "RCA CDP1802", 3, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -79,6 +79,15 @@ OPERAND_FUNC(none)
     /* empty */
 }
 
+/***********************************************************
+ * Opcode with no instruction (the 1805 extension prefix).
+ ************************************************************/
+
+OPERAND_FUNC(undef)
+{
+    ctx->undefined = 1;
+}
+
 /******************************************************************************/
 /**                            Single Operands                               **/
 /******************************************************************************/
@@ -90,9 +99,9 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( FORMAT_NUM_8BIT, byte );
+    operand( ctx, FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -104,7 +113,7 @@ OPERAND_FUNC(reg)
 {
     int reg = opc & 0x0F;
     
-    operand( FORMAT_REG, reg );    
+    operand( ctx, FORMAT_REG, reg );    
 }
 
 /***********************************************************
@@ -113,11 +122,11 @@ OPERAND_FUNC(reg)
 
 OPERAND_FUNC(page8)
 {
-    UBYTE aa = next( f, addr );
+    UBYTE aa = next( ctx, addr );
     ADDR dest = ( *addr & 0xFF00 ) | aa;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -128,7 +137,7 @@ OPERAND_FUNC(io)
 {
     int ionum = ( opc & 0x07 );
     
-    operand( FORMAT_REG, ionum );
+    operand( ctx, FORMAT_REG, ionum );
 }
 
 /***********************************************************
@@ -137,12 +146,12 @@ OPERAND_FUNC(io)
 
 OPERAND_FUNC(addr16)
 {
-    UBYTE low_addr  = next( f, addr );
-    UBYTE high_addr = next( f, addr );
+    UBYTE low_addr  = next( ctx, addr );
+    UBYTE high_addr = next( ctx, addr );
     UWORD addr16    = MK_WORD( low_addr, high_addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /******************************************************************************/
@@ -163,7 +172,7 @@ optab_t base_optab[] = {
     MASK ( "DEC",   reg, 0xF0, 0x20, X_NONE )
     
     /* 3X */
-    INSN ( "BR",    page8, 0x30, X_JMP )
+    INSN_STOP ( "BR",    page8, 0x30, X_JMP )
     INSN ( "BQ",    page8, 0x31, X_JMP )
     INSN ( "BZ",    page8, 0x32, X_JMP )
     INSN ( "BDF",   page8, 0x33, X_JMP )
@@ -189,12 +198,12 @@ optab_t base_optab[] = {
     /* 6X */
     INSN ( "IRX",   none, 0x60, X_NONE )
     RANGE( "OUT",   io, 0x61, 0x67, X_IO )
-    INSN ( "?????", none, 0x68, X_NONE )
+    INSN ( "?????", undef, 0x68, X_NONE )
     RANGE( "INP",   io, 0x69, 0x6F, X_IO )
     
     /* 7X */
-    INSN ( "RET",   none, 0x70, X_NONE )
-    INSN ( "DIS",   none, 0x71, X_NONE )
+    INSN_STOP ( "RET",   none, 0x70, X_NONE )
+    INSN_STOP ( "DIS",   none, 0x71, X_NONE )
     INSN ( "LDXA",  none, 0x72, X_NONE )
     INSN ( "STXD",  none, 0x73, X_NONE )
     INSN ( "ADC",   none, 0x74, X_NONE )
@@ -224,7 +233,7 @@ optab_t base_optab[] = {
     MASK ( "PHI",   reg, 0xF0, 0xB0, X_NONE )
     
     /* CX */
-    INSN ( "LBR",   addr16, 0xC0, X_JMP )
+    INSN_STOP ( "LBR",   addr16, 0xC0, X_JMP )
     INSN ( "LBQ",   addr16, 0xC1, X_JMP )
     INSN ( "LBZ",   addr16, 0xC2, X_JMP )
     INSN ( "LBDF",  addr16, 0xC3, X_JMP )
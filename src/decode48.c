@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm48", "Intel MCS-48 (8035, 8048, 8049)", 4, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm48", "Intel MCS-48 (8035, 8048, 8049)", 4, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -84,87 +84,87 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(A)
 {
-   operand( "A" );
+   operand( ctx, "A" );
 }
 
 OPERAND_FUNC(indA)
 {
-   operand( "@A" );
+   operand( ctx, "@A" );
 }
 
 OPERAND_FUNC(I)
 {
-   operand( "I" );
+   operand( ctx, "I" );
 }
 
 OPERAND_FUNC(C)
 {
-   operand( "C" );
+   operand( ctx, "C" );
 }
 
 OPERAND_FUNC(T)
 {
-   operand( "T" );
+   operand( ctx, "T" );
 }
 
 OPERAND_FUNC(PSW)
 {
-   operand( "PSW" );
+   operand( ctx, "PSW" );
 }
 
 OPERAND_FUNC(BUS)
 {
-   operand( "BUS" );
+   operand( ctx, "BUS" );
 }
 
 OPERAND_FUNC(CLK)
 {
-   operand( "CLK" );
+   operand( ctx, "CLK" );
 }
 
 OPERAND_FUNC(CNT)
 {
-   operand( "CNT" );
+   operand( ctx, "CNT" );
 }
 
 OPERAND_FUNC(TCNT)
 {
-   operand( "TCNT" );
+   operand( ctx, "TCNT" );
 }
 
 OPERAND_FUNC(TCNTI)
 {
-   operand( "TCNTI" );
+   operand( ctx, "TCNTI" );
 }
 
 OPERAND_FUNC(F0)
 {
-   operand( "F0" );
+   operand( ctx, "F0" );
 }
 
 OPERAND_FUNC(F1)
 {
-   operand( "F1" );
+   operand( ctx, "F1" );
 }
 
 OPERAND_FUNC(RB0)
 {
-   operand( "RB0" );
+   operand( ctx, "RB0" );
 }
 
 OPERAND_FUNC(RB1)
 {
-   operand( "RB1" );
+   operand( ctx, "RB1" );
 }
 
 OPERAND_FUNC(MB0)
 {
-   operand( "MB0" );
+   operand( ctx, "MB0" );
 }
 
 OPERAND_FUNC(MB1)
 {
-   operand( "MB1" );
+   operand( ctx, "MB1" );
 }
 
 /***********************************************************
@@ -176,7 +176,7 @@ OPERAND_FUNC(reg)
 {
    UBYTE reg = opc & 0x07;
    
-   operand( FORMAT_REG, reg );
+   operand( ctx, FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -188,7 +188,7 @@ OPERAND_FUNC(port)
 {
    UBYTE port = opc & 0x03;
    
-   operand( FORMAT_PORT, port );
+   operand( ctx, FORMAT_PORT, port );
 }
 
 /***********************************************************
@@ -200,7 +200,7 @@ OPERAND_FUNC(portH)
 {
    UBYTE port = ( opc & 0x03 ) + 4;
    
-   operand( FORMAT_PORT, port );
+   operand( ctx, FORMAT_PORT, port );
 }
 
 /***********************************************************
@@ -212,7 +212,7 @@ OPERAND_FUNC(indreg)
 {
    UBYTE reg = opc & 0x01;
    
-   operand( "@" FORMAT_REG, reg );
+   operand( ctx, "@" FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -222,9 +222,9 @@ OPERAND_FUNC(indreg)
 
 OPERAND_FUNC(imm8)
 {
-   UBYTE imm8 = next( f, addr );
+   UBYTE imm8 = next( ctx, addr );
    
-   operand( "#" FORMAT_NUM_8BIT, imm8 );
+   operand( ctx, "#" FORMAT_NUM_8BIT, imm8 );
 }
 
 /***********************************************************
@@ -236,7 +236,7 @@ OPERAND_FUNC(addrbit)
 {
    UBYTE bit = ( opc >> 5 ) & 0x07;
 
-   operand( "%d", bit );
+   operand( ctx, "%d", bit );
 }
 
 /***********************************************************
@@ -246,10 +246,10 @@ OPERAND_FUNC(addrbit)
 
 OPERAND_FUNC(addr8)
 {
-   UBYTE addr8 = (UBYTE)next( f, addr );
+   UBYTE addr8 = (UBYTE)next( ctx, addr );
    
-   operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr8 ) );
-   xref_addxref( xtype, g_insn_addr, addr8 );
+   operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr8 ) );
+   dasm_addxref( ctx, xtype, ctx->insn_addr, addr8 );
 }
 
 /***********************************************************
@@ -260,11 +260,11 @@ OPERAND_FUNC(addr8)
 OPERAND_FUNC(addr11)
 {
    UBYTE msb_addr  = ( opc >> 5) & 0x07;
-   UBYTE lsb_addr  = next( f, addr );
+   UBYTE lsb_addr  = next( ctx, addr );
    UWORD addr11    = MK_WORD( lsb_addr, msb_addr );
 
-   operand( "%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr11 ) );
-   xref_addxref( xtype, g_insn_addr, addr11 );
+   operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr11 ) );
+   dasm_addxref( ctx, xtype, ctx->insn_addr, addr11 );
 }
 
 /******************************************************************************/
@@ -369,13 +369,13 @@ optab_t base_optab[] = {
   Jump, Call and Return
   ----------------------------------------------------------------------------*/
 
-    MASK( "JMP",   addr11,   0x1F, 0x04, X_JMP )
-    INSN( "JMPP",  indA,     0xB3, X_NONE )
+    MASK_STOP( "JMP",   addr11,   0x1F, 0x04, X_JMP )
+    INSN_STOP( "JMPP",  indA,     0xB3, X_NONE )
 
     MASK( "CALL",  addr11,   0x1F, 0x14, X_CALL )
 
-    INSN( "RET",   none,     0x83, X_NONE )
-    INSN( "RETR",  none,     0x93, X_NONE )
+    INSN_STOP( "RET",   none,     0x83, X_NONE )
+    INSN_STOP( "RETR",  none,     0x93, X_NONE )
 
 /*----------------------------------------------------------------------------
   Conditional Jumps
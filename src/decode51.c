@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm51", "Intel 8051", 4, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm51", "Intel 8051", 4, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -83,32 +83,32 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(A)
 {
-   operand( "A" );
+   operand( ctx, "A" );
 }
 
 OPERAND_FUNC(B)
 {
-   operand( "B" );
+   operand( ctx, "B" );
 }
 
 OPERAND_FUNC(C)
 {
-   operand( "C" );
+   operand( ctx, "C" );
 }
 
 OPERAND_FUNC(AB)
 {
-   operand( "AB" );
+   operand( ctx, "AB" );
 }
 
 OPERAND_FUNC(PC)
 {
-   operand( "PC" );
+   operand( ctx, "PC" );
 }
 
 OPERAND_FUNC(dptr)
 {
-   operand( "DPTR" );
+   operand( ctx, "DPTR" );
 }
 
 /***********************************************************
@@ -120,7 +120,7 @@ OPERAND_FUNC(reg)
 {
    UBYTE reg = opc & 0x07;
    
-   operand( FORMAT_REG, reg );
+   operand( ctx, FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -132,7 +132,7 @@ OPERAND_FUNC(indreg)
 {
    UBYTE reg = opc & 0x01;
    
-   operand( "@" FORMAT_REG, reg );
+   operand( ctx, "@" FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -142,9 +142,9 @@ OPERAND_FUNC(indreg)
 
 OPERAND_FUNC(imm8)
 {
-   UBYTE imm8 = next( f, addr );
+   UBYTE imm8 = next( ctx, addr );
    
-   operand( "#" FORMAT_NUM_8BIT, imm8 );
+   operand( ctx, "#" FORMAT_NUM_8BIT, imm8 );
 }
 
 /***********************************************************
@@ -154,11 +154,11 @@ OPERAND_FUNC(imm8)
  
 OPERAND_FUNC(imm16)
 {
-   UBYTE msb   = next( f, addr );
-   UBYTE lsb   = next( f, addr );
+   UBYTE msb   = next( ctx, addr );
+   UBYTE lsb   = next( ctx, addr );
    UWORD imm16 = MK_WORD( lsb, msb );
 
-   operand( "#" FORMAT_NUM_16BIT, imm16 );
+   operand( ctx, "#" FORMAT_NUM_16BIT, imm16 );
 }
 
 /***********************************************************
@@ -168,17 +168,17 @@ OPERAND_FUNC(imm16)
 
 OPERAND_FUNC(addrbit)
 {
-   UBYTE bit      = next( f, addr );
+   UBYTE bit      = next( ctx, addr );
    int bitnum     = bit % 8;
    int bytenum    = bit & 0xF8;
    const char * s = xref_findaddrlabel( bytenum );
 
    if ( s )
-      operand( "%s", s );
+      operand( ctx, "%s", s );
    else
-      operand( FORMAT_NUM_8BIT, bytenum );
+      operand( ctx, FORMAT_NUM_8BIT, bytenum );
 
-   operand( ".%d", bitnum );
+   operand( ctx, ".%d", bitnum );
 }
 
 /***********************************************************
@@ -188,13 +188,13 @@ OPERAND_FUNC(addrbit)
 
 OPERAND_FUNC(iram)
 {
-   UBYTE iaddr = next( f, addr );
+   UBYTE iaddr = next( ctx, addr );
    const char * s;
    
    if ( ( s = xref_findaddrlabel( iaddr ) ) )
-      operand( "%s", s );
+      operand( ctx, "%s", s );
    else
-      operand( FORMAT_NUM_8BIT, iaddr );
+      operand( ctx, FORMAT_NUM_8BIT, iaddr );
 }
 
 /***********************************************************
@@ -205,13 +205,13 @@ OPERAND_FUNC(iram)
 OPERAND_FUNC(addr11)
 {
    UBYTE msb_addr  = ( opc >> 5) & 0x07;
-   UBYTE lsb_addr  = next( f, addr );
+   UBYTE lsb_addr  = next( ctx, addr );
    UWORD addr11    = MK_WORD( lsb_addr, msb_addr );
    UWORD addr16    = (UWORD)*addr;
    addr16 = ( addr16 & 0xF800 ) | addr11;
 
-   operand( "%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-   xref_addxref( xtype, g_insn_addr, addr16 );
+   operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+   dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -221,12 +221,12 @@ OPERAND_FUNC(addr11)
  
 OPERAND_FUNC(addr16)
 {
-   UBYTE msb_addr  = next( f, addr );
-   UBYTE lsb_addr  = next( f, addr );
+   UBYTE msb_addr  = next( ctx, addr );
+   UBYTE lsb_addr  = next( ctx, addr );
    UWORD addr16    = MK_WORD( lsb_addr, msb_addr );
 
-   operand( "%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-   xref_addxref( xtype, g_insn_addr, addr16 );
+   operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+   dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -235,11 +235,11 @@ OPERAND_FUNC(addr16)
 
 OPERAND_FUNC(rel8)
 {
-   BYTE ofst = (BYTE)next( f, addr );
+   BYTE ofst = (BYTE)next( ctx, addr );
    ADDR dest = (*addr + ofst) & 0xFFFF;
    
-   operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-   xref_addxref( xtype, g_insn_addr, dest );
+   operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+   dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /******************************************************************************/
@@ -265,34 +265,34 @@ TWO_OPERAND_PAIR(iram, indreg)
 
 OPERAND_FUNC(C_n_addrbit)
 {
-    operand_C( f, addr, opc, xtype );
+    operand_C( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_addrbit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_addrbit( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(A_plus_dptr)
 {
-    operand( "@" );
-    operand_A( f, addr, opc, xtype );
-    operand( "+" );
-    operand_dptr( f, addr, opc, xtype );
+    operand( ctx, "@" );
+    operand_A( ctx, addr, opc, xtype );
+    operand( ctx, "+" );
+    operand_dptr( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(A_dptr)
 {
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
     COMMA;
-    operand( "@" );
-    operand_dptr( f, addr, opc, xtype );
+    operand( ctx, "@" );
+    operand_dptr( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(dptr_A)
 {
-    operand( "@" );
-    operand_dptr( f, addr, opc, xtype );
+    operand( ctx, "@" );
+    operand_dptr( ctx, addr, opc, xtype );
     COMMA;
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
 }
 
 /******************************************************************************/
@@ -306,22 +306,22 @@ THREE_OPERAND(reg, imm8, rel8)
 
 OPERAND_FUNC(A_A_dptr)
 {
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
     COMMA;
-    operand( "@" );
-    operand_A( f, addr, opc, xtype );
-    operand( "+" );
-    operand_dptr( f, addr, opc, xtype );
+    operand( ctx, "@" );
+    operand_A( ctx, addr, opc, xtype );
+    operand( ctx, "+" );
+    operand_dptr( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(A_A_PC)
 {
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
     COMMA;
-    operand( "@" );
-    operand_A( f, addr, opc, xtype );
-    operand( "+" );
-    operand_PC( f, addr, opc, xtype );
+    operand( ctx, "@" );
+    operand_A( ctx, addr, opc, xtype );
+    operand( ctx, "+" );
+    operand_PC( ctx, addr, opc, xtype );
 }
 
 /******************************************************************************/
@@ -425,18 +425,18 @@ optab_t base_optab[] = {
   Jump, Call and Return
   ----------------------------------------------------------------------------*/
 
-    INSN( "JMP",   A_plus_dptr, 0x73, X_NONE )
+    INSN_STOP( "JMP",   A_plus_dptr, 0x73, X_NONE )
 
-    INSN( "SJMP",  rel8, 0x80, X_JMP )
+    INSN_STOP( "SJMP",  rel8, 0x80, X_JMP )
 
-    MASK( "AJMP",  addr11, 0x1F, 0x01, X_JMP )
-    INSN( "LJMP",  addr16, 0x02, X_JMP )
+    MASK_STOP( "AJMP",  addr11, 0x1F, 0x01, X_JMP )
+    INSN_STOP( "LJMP",  addr16, 0x02, X_JMP )
 
     MASK( "ACALL", addr11, 0x1F, 0x11, X_CALL )
     INSN( "LCALL", addr16, 0x12, X_CALL )
 
-    INSN( "RET",   none,   0x22, X_NONE )
-    INSN( "RETI",  none,   0x32, X_NONE )
+    INSN_STOP( "RET",   none,   0x22, X_NONE )
+    INSN_STOP( "RETI",  none,   0x32, X_NONE )
 
 /*----------------------------------------------------------------------------
   Conditional Jumps
@@ -48,7 +48,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm68k", "Motorola 68000", 22, 9, 1, 2, 1 )
+DASM_PROFILE( "dasm68k", "Motorola 68000", 22, 9, 1, 2, 2, 6, 4 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -96,7 +96,7 @@ OPERAND_FUNC(areg0)
 {
     int reg = opc & 0x07;
     
-    operand( FORMAT_AREG, reg );
+    operand( ctx, FORMAT_AREG, reg );
 }
 
 /***********************************************************
@@ -107,7 +107,7 @@ OPERAND_FUNC(areg9)
 {
     int reg = ( opc >> 9 ) & 0x07;
     
-    operand( FORMAT_AREG, reg );
+    operand( ctx, FORMAT_AREG, reg );
 }
 
 /***********************************************************
@@ -118,7 +118,7 @@ OPERAND_FUNC(dreg0)
 {
     int reg = opc & 0x07;
     
-    operand( FORMAT_DREG, reg );
+    operand( ctx, FORMAT_DREG, reg );
 }
 
 /***********************************************************
@@ -129,7 +129,7 @@ OPERAND_FUNC(dreg9)
 {
     int reg = ( opc >> 9 ) & 0x07;
     
-    operand( FORMAT_DREG, reg );
+    operand( ctx, FORMAT_DREG, reg );
 }
 
 /***********************************************************
@@ -140,7 +140,7 @@ OPERAND_FUNC(vector3)
 {
     int vector = opc & 0x07;
     
-    operand( FORMAT_VECTOR, vector );
+    operand( ctx, FORMAT_VECTOR, vector );
 }
 
 /***********************************************************
@@ -151,7 +151,7 @@ OPERAND_FUNC(vector4)
 {
     int vector = opc & 0x0F;
     
-    operand( FORMAT_VECTOR, vector );
+    operand( ctx, FORMAT_VECTOR, vector );
 }
 
 /***********************************************************
@@ -159,9 +159,9 @@ OPERAND_FUNC(vector4)
  ************************************************************/
 OPERAND_FUNC(imm16)
 {
-    UWORD imm16 = (UWORD)nextw( f, addr );
+    UWORD imm16 = (UWORD)nextw( ctx, addr );
 
-    operand( "#" FORMAT_IMM16, imm16 );
+    operand( ctx, "#" FORMAT_IMM16, imm16 );
 }
 
 /***********************************************************
@@ -174,7 +174,7 @@ OPERAND_FUNC(simm8)
     if ( imm > 0x7F )
         imm -= 0x100;
     
-    operand( "%s#" FORMAT_IMM8, imm < 0 ? "-" : "", abs(imm) );
+    operand( ctx, "%s#" FORMAT_IMM8, imm < 0 ? "-" : "", abs(imm) );
 }
 
 /***********************************************************
@@ -182,9 +182,9 @@ OPERAND_FUNC(simm8)
  ************************************************************/
 OPERAND_FUNC(simm16)
 {
-    WORD imm = (WORD)nextw( f, addr );
+    WORD imm = (WORD)nextw( ctx, addr );
     
-    operand( "%s#" FORMAT_IMM16, imm < 0 ? "-" : "", abs(imm) );
+    operand( ctx, "%s#" FORMAT_IMM16, imm < 0 ? "-" : "", abs(imm) );
 }
 
 /***********************************************************
@@ -192,34 +192,38 @@ OPERAND_FUNC(simm16)
  ************************************************************/
 OPERAND_FUNC(simm32)
 {
-    WORD imm = (WORD)nextw( f, addr );
-    imm = ( imm << 16 ) | (UWORD)nextw( f, addr );
+    WORD imm = (WORD)nextw( ctx, addr );
+    imm = ( imm << 16 ) | (UWORD)nextw( ctx, addr );
     
-    operand( "%s#" FORMAT_IMM32, imm < 0 ? "-" : "", abs(imm) );
+    operand( ctx, "%s#" FORMAT_IMM32, imm < 0 ? "-" : "", abs(imm) );
 }
 
 /************************************************************
- * Process variable-length relative address
+ * Process variable-length relative address.  The displacement
+ * is from the word after the opcode, and the target is shown
+ * as a word address, like the listing.
  ************************************************************/
 OPERAND_FUNC(relX)
 {
-    BYTE disp8 = (BYTE)(opc & 0xFF);
-    WORD dest = (ADDR)disp8;
+    BYTE  disp8 = (BYTE)(opc & 0xFF);
+    ADDR  pc    = *addr;
+    LWORD disp  = disp8;
+    ADDR  dest;
 
     if ( disp8 == -1 || disp8 == 0 ) /* extended displacement */
     {
-        dest = (WORD)nextw( f, addr );
+        disp = (WORD)nextw( ctx, addr );
         if ( disp8 == -1 ) /* 32-bit displacement */
         {
-            UWORD lo = (UWORD)nextw( f, addr );
-            dest = MK_LONG(dest, lo);
+            UWORD lo = (UWORD)nextw( ctx, addr );
+            disp = (LWORD)MK_LONG(disp, lo);
         }
     }
     
-    dest += *addr;
+    dest = ( pc + disp ) & 0xFFFFFF;
     
-    operand( xref_genwordaddr( NULL, FORMAT_IMM32, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest ); 
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_IMM32, dest / dasm_word_width_bytes ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest ); 
 }
 
 /************************************************************
@@ -250,29 +254,29 @@ OPERAND_FUNC(ea)
     switch( mode )
     {
     case EAMODE_DATA_DIRECT:                        /* 2.2.1 */
-        operand( FORMAT_DREG, reg );
+        operand( ctx, FORMAT_DREG, reg );
         break;
         
     case EAMODE_ADDR_DIRECT:                        /* 2.2.2 */
-        operand( FORMAT_AREG, reg );
+        operand( ctx, FORMAT_AREG, reg );
         break;
         
     case EAMODE_ADDR_INDIR:                         /* 2.2.3 */
-        operand( "(" FORMAT_ADDR ")", reg );
+        operand( ctx, "(" FORMAT_AREG ")", reg );
         break;
         
     case EAMODE_ADDR_POST_INC:                      /* 2.2.4 */
-        operand( "(" FORMAT_ADDR ")+", reg );
+        operand( ctx, "(" FORMAT_AREG ")+", reg );
         break;
         
     case EAMODE_ADDR_PRE_DEC:                       /* 2.2.5 */
-        operand( "-(" FORMAT_ADDR ")", reg );
+        operand( ctx, "-(" FORMAT_AREG ")", reg );
         break;
         
     case EAMODE_ADDR_IND_DISP:                      /* 2.2.6 */
     {
-        WORD disp = (WORD)nextw( f, addr );
-        operand( "(" "%s#" FORMAT_IMM16 "," FORMAT_ADDR ")", 
+        WORD disp = (WORD)nextw( ctx, addr );
+        operand( ctx, "(" "%s#" FORMAT_IMM16 "," FORMAT_AREG ")", 
                 disp < 0 ? "-" : "", abs(disp), 
                 reg );
         break;
@@ -280,7 +284,7 @@ OPERAND_FUNC(ea)
     
     case EAMODE_ADDR_IND_IDX:                       /* 2.2.7 - 2.2.10 */
     {
-        UWORD extn = nextw( f, addr );
+        UWORD extn = nextw( ctx, addr );
         int da     = extn & (1 << 15);
         int ireg   = ( extn >> 12 ) & 0x07;
         int wl     = extn & (1 << 11);
@@ -301,43 +305,43 @@ OPERAND_FUNC(ea)
             /* Gather base displacement from insn stream */
             if ( bd_size == 0x02 || bd_size == 0x03 )
             {
-                bd = (LWORD)nextw( f, addr );
+                bd = (LWORD)nextw( ctx, addr );
                 if ( bd_size == 0x03 )
-                    bd = bd + ((LWORD)nextw( f, addr ) << 16);
+                    bd = bd + ((LWORD)nextw( ctx, addr ) << 16);
             }
             
             /* Gather outer displacement from insn stream */
             if ( od_size == 0x02 || od_size == 0x03 ) {
-                od = (LWORD)nextw( f, addr );
+                od = (LWORD)nextw( ctx, addr );
                 if ( od_size == 0x03 )
-                    od = od + ((LWORD)nextw( f, addr ) << 16);
+                    od = od + ((LWORD)nextw( ctx, addr ) << 16);
             }
             
-            operand( "( " );
+            operand( ctx, "( " );
             
             if ( isiis == 1 || isiis == 2 )
-                operand( "[ " );
+                operand( ctx, "[ " );
             
-            operand( "%s" FORMAT_IMM32, bd < 0 ? "-" : "", abs(bd) );
+            operand( ctx, "%s" FORMAT_IMM32, bd < 0 ? "-" : "", abs(bd) );
             if ( !bs )
-                operand( ", " FORMAT_AREG, reg );
+                operand( ctx, ", " FORMAT_AREG, reg );
                 
             if ( isiis == 1 )
-                operand( "], " );
+                operand( ctx, "], " );
                 
             if ( !is )
             {
-                operand( "%c%d.%c*%d" ")", 
+                operand( ctx, "%c%d.%c*%d" ")", 
                     da ? 'A' : 'D', ireg, wl ? 'L' : 'W', (1 << scale)
                 );            
             }
             
             if ( isiis == 2 )
-                operand( "]" );
+                operand( ctx, "]" );
             
-            operand( ", %s" FORMAT_IMM32, od < 0 ? "-" : "", abs(od) );
+            operand( ctx, ", %s" FORMAT_IMM32, od < 0 ? "-" : "", abs(od) );
             
-            operand( " )" );
+            operand( ctx, " )" );
         }
         else
         {
@@ -347,7 +351,7 @@ OPERAND_FUNC(ea)
             if ( disp > 0x7F )
                 disp -= 0x100;
                 
-            operand( "(%d," FORMAT_AREG "," "%c%d.%c*%d" ")", 
+            operand( ctx, "(%d," FORMAT_AREG "," "%c%d.%c*%d" ")", 
                 disp, 
                 reg, 
                 da ? 'A' : 'D', ireg, wl ? 'L' : 'W', (1 << scale)
@@ -368,6 +372,72 @@ OPERAND_FUNC(ea)
     }
 }
 
+/************************************************************
+ * Process control addressing mode effective address, as used
+ * by JMP and JSR:
+ * 5  4  3  2  1  0
+ * [ mode ][ reg  ]
+ *
+ * The op table only passes the control modes: (An), d16(An),
+ * d8(An,Xn), abs.W, abs.L, d16(PC) and d8(PC,Xn).  Absolute and
+ * PC-relative targets are cross-referenced.
+ ************************************************************/
+OPERAND_FUNC(ctl_ea)
+{
+    int mode = ( opc >> 3 ) & 0x7;
+    int reg  = opc & 0x7;
+    
+    if ( mode == EAMODE_ADDR_INDIR )                /* 2.2.3 */
+    {
+        operand( ctx, "(" FORMAT_AREG ")", reg );
+    }
+    else if ( mode == EAMODE_ADDR_IND_DISP )        /* 2.2.6 */
+    {
+        WORD disp = (WORD)nextw( ctx, addr );
+        operand( ctx, "(" "%s#" FORMAT_IMM16 "," FORMAT_AREG ")", 
+                disp < 0 ? "-" : "", abs(disp), 
+                reg );
+    }
+    else if ( mode == EAMODE_ADDR_IND_IDX           /* 2.2.7, 2.2.13 */
+              || ( mode == EAMODE_SUB_MODE && reg == 3 ) )
+    {
+        UWORD extn = nextw( ctx, addr );
+        BYTE  disp = (BYTE)( extn & 0xFF );
+        
+        if ( mode == EAMODE_SUB_MODE )
+            operand( ctx, "(%d,PC,", disp );
+        else
+            operand( ctx, "(%d," FORMAT_AREG ",", disp, reg );
+        operand( ctx, "%c%d.%c)", 
+                extn & (1 << 15) ? 'A' : 'D', ( extn >> 12 ) & 0x07, 
+                extn & (1 << 11) ? 'L' : 'W' );
+    }
+    else
+    {
+        ADDR dest;
+        
+        if ( reg == 0 )                             /* 2.2.16 abs.W */
+            dest = (ADDR)(LWORD)(WORD)nextw( ctx, addr );
+        else if ( reg == 1 )                        /* 2.2.17 abs.L */
+        {
+            UWORD hi = nextw( ctx, addr );
+            UWORD lo = nextw( ctx, addr );
+            dest = MK_LONG( hi, lo );
+        }
+        else                                        /* 2.2.11 d16(PC) */
+        {
+            ADDR pc = *addr;
+            dest = pc + (WORD)nextw( ctx, addr );
+        }
+        
+        dest &= 0xFFFFFF;
+        if ( reg == 2 )
+            operand( ctx, "(%s,PC)", XREF_WORDADDR( FORMAT_IMM32, dest / dasm_word_width_bytes ) );
+        else
+            operand( ctx, "%s", XREF_WORDADDR( FORMAT_IMM32, dest / dasm_word_width_bytes ) );
+        dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
+    }
+}
 
 
 
@@ -415,7 +485,7 @@ enum {
 
 OPERAND_FUNC(indexed)
 {
-    UBYTE postbyte = next( f, addr );
+    UBYTE postbyte = next( ctx, addr );
     UBYTE rr = ( postbyte >> 5 ) & 0x03;
     static const char * rrtab[] = { "X", "Y", "U", "S" };
     
@@ -423,7 +493,7 @@ OPERAND_FUNC(indexed)
     {
         BYTE offset = ((BYTE)( ( postbyte & 0x1F ) << 3 )) >> 3;
         
-        operand( "%d, %s", offset, rrtab[rr] );    
+        operand( ctx, "%d, %s", offset, rrtab[rr] );    
     }
     else
     {
@@ -431,90 +501,90 @@ OPERAND_FUNC(indexed)
         int   ind  = postbyte & 0x10;
         
         if ( ind )
-            operand("[");
+            operand(ctx, "[");
             
         switch ( mode )
         {
         case MODE_AUTO_INC:
-            operand( ",%s+", rrtab[rr] );
+            operand( ctx, ",%s+", rrtab[rr] );
             break;
             
         case MODE_AUTO_INC2:
-            operand( ",%s++", rrtab[rr] );
+            operand( ctx, ",%s++", rrtab[rr] );
             break;
             
         case MODE_AUTO_DEC:
-            operand( ",-%s", rrtab[rr] );
+            operand( ctx, ",-%s", rrtab[rr] );
             break;
             
         case MODE_AUTO_DEC2:
-            operand( ",--%s", rrtab[rr] );
+            operand( ctx, ",--%s", rrtab[rr] );
             break;
             
         case MODE_REG_ONLY:
-            operand( ",%s", rrtab[rr] );
+            operand( ctx, ",%s", rrtab[rr] );
             break;
             
         case MODE_REG_ACCB:
-            operand( "B, %s", rrtab[rr] );
+            operand( ctx, "B, %s", rrtab[rr] );
             break;
             
         case MODE_REG_ACCA:
-            operand( "A, %s", rrtab[rr] );
+            operand( ctx, "A, %s", rrtab[rr] );
             break;
             
         case MODE_REG_D:
-            operand( "D, %s", rrtab[rr] );
+            operand( ctx, "D, %s", rrtab[rr] );
             break;
             
         case MODE_REG_8OFF:
             {
-                BYTE offset = (BYTE)next( f, addr );
-                operand( "%d, %s", offset, rrtab[rr] );
+                BYTE offset = (BYTE)next( ctx, addr );
+                operand( ctx, "%d, %s", offset, rrtab[rr] );
             }
             break;
             
         case MODE_REG_16OFF:
             {
-                UBYTE msb    = next( f, addr );
-                UBYTE lsb    = next( f, addr );
+                UBYTE msb    = next( ctx, addr );
+                UBYTE lsb    = next( ctx, addr );
                 WORD  offset = MK_WORD( lsb, msb );
-                operand( "%d, %s", offset, rrtab[rr] );
+                operand( ctx, "%d, %s", offset, rrtab[rr] );
             }
             break;
             
         case MODE_PCR_8OFF:
             {
-                BYTE offset = (BYTE)next( f, addr );
-                operand( "%d, PCR", offset );
+                BYTE offset = (BYTE)next( ctx, addr );
+                operand( ctx, "%d, PCR", offset );
             }
             break;
             
         case MODE_PCR_16OFF:
             {
-                UBYTE msb    = next( f, addr );
-                UBYTE lsb    = next( f, addr );
+                UBYTE msb    = next( ctx, addr );
+                UBYTE lsb    = next( ctx, addr );
                 WORD  offset = MK_WORD( lsb, msb );
-                operand( "%d, PCR", offset );
+                operand( ctx, "%d, PCR", offset );
             }
             break;
             
         case MODE_EXT_IND:
             {
-                UBYTE msb = next( f, addr );
-                UBYTE lsb = next( f, addr );
+                UBYTE msb = next( ctx, addr );
+                UBYTE lsb = next( ctx, addr );
                 WORD  ea  = MK_WORD( lsb, msb );
-                operand( "%d", ea );
+                operand( ctx, "%d", ea );
             }
             break;
             
         default:
-            operand( "???" );
+            operand( ctx, "???" );
             break;
         }
         
         if ( ind )
-            operand("]");
+            operand(ctx, "]");
     }
 }
 
@@ -524,12 +594,12 @@ OPERAND_FUNC(indexed)
  
 OPERAND_FUNC(extended)
 {
-    UBYTE msb    = next( f, addr );
-    UBYTE lsb    = next( f, addr );
+    UBYTE msb    = next( ctx, addr );
+    UBYTE lsb    = next( ctx, addr );
     UWORD addr16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -538,11 +608,11 @@ OPERAND_FUNC(extended)
 
 OPERAND_FUNC(rel8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -551,13 +621,13 @@ OPERAND_FUNC(rel8)
 
 OPERAND_FUNC(rel16)
 {
-    UBYTE msb = next( f, addr );
-    UBYTE lsb = next( f, addr );
+    UBYTE msb = next( ctx, addr );
+    UBYTE lsb = next( ctx, addr );
     WORD disp = MK_WORD( lsb, msb );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 #endif
@@ -649,7 +719,7 @@ optab_t base_optab[] = {
   ----------------------------------------------------------------------------*/
 
 
-    MASK ( "BRA",       relX,   0xFF00, 0x6000, X_JMP )
+    MASK_STOP ( "BRA",       relX,   0xFF00, 0x6000, X_JMP )
     MASK ( "BHI",       relX,   0xFF00, 0x6200, X_JMP )
     MASK ( "BLS",       relX,   0xFF00, 0x6300, X_JMP )
     MASK ( "BCC",       relX,   0xFF00, 0x6400, X_JMP )
@@ -769,8 +839,13 @@ optab_t base_optab[] = {
   
     INSN ( "NOP",       none,   0x4E71,         X_NONE )
     
-    INSN ( "RTR",       none,   0x4E77,         X_NONE )
-    INSN ( "RTS",       none,   0x4E75,         X_NONE )
+    INSN_STOP ( "RTR",       none,   0x4E77,         X_NONE )
+    INSN_STOP ( "RTS",       none,   0x4E75,         X_NONE )
+
+    RANGE_STOP ( "JMP",      ctl_ea, 0x4ED0, 0x4ED7, X_JMP )
+    RANGE_STOP ( "JMP",      ctl_ea, 0x4EE8, 0x4EFB, X_JMP )
+    RANGE ( "JSR",      ctl_ea, 0x4E90, 0x4E97, X_CALL )
+    RANGE ( "JSR",      ctl_ea, 0x4EA8, 0x4EBB, X_CALL )
 
   
     MASK ( "BKPT",      vector3, 0xFFF8, 0x4848, X_NONE )
@@ -778,7 +853,7 @@ optab_t base_optab[] = {
     INSN ( "ILLEGAL",   none,   0x4AFC,         X_NONE )
   
     INSN ( "RESET",     none,   0x4E70,         X_NONE )
-    INSN ( "RTE",       none,   0x4E73,         X_NONE )
+    INSN_STOP ( "RTE",       none,   0x4E73,         X_NONE )
     
     INSN ( "STOP",      imm16,  0x4E72,         X_IMM  )
     
@@ -914,8 +989,6 @@ UNPK
 DBcc
 Scc
 BSR
-JMP
-JSR
 RTD
 TST
 FTST
@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm7000", "TI TMS7000", 4, 9, 1, 1, 1 )
+DASM_PROFILE( "dasm7000", "TI TMS7000", 4, 9, 1, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -83,7 +83,7 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(A)
 {
-    operand( "A" );
+    operand( ctx, "A" );
 }
 
 /***********************************************************
@@ -92,7 +92,7 @@ OPERAND_FUNC(A)
 
 OPERAND_FUNC(B)
 {
-    operand( "B" );
+    operand( ctx, "B" );
 }
 
 /***********************************************************
@@ -101,7 +101,7 @@ OPERAND_FUNC(B)
  
 OPERAND_FUNC(ST)
 {
-    operand( "ST" );
+    operand( ctx, "ST" );
 }
 
 /***********************************************************
@@ -111,9 +111,9 @@ OPERAND_FUNC(ST)
 
 OPERAND_FUNC(reg)
 {
-    UBYTE reg = next( f, addr );
+    UBYTE reg = next( ctx, addr );
     
-    operand( FORMAT_REG, reg );
+    operand( ctx, FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -123,9 +123,9 @@ OPERAND_FUNC(reg)
 
 OPERAND_FUNC(iop)
 {
-    UBYTE iop = next( f, addr );
+    UBYTE iop = next( ctx, addr );
     
-    operand( "%%" FORMAT_NUM_8BIT, iop );
+    operand( ctx, "%%" FORMAT_NUM_8BIT, iop );
 }
 
 /***********************************************************
@@ -140,14 +140,14 @@ OPERAND_FUNC(iop)
  
 OPERAND_FUNC(Pn)
 {
-    UBYTE pn = next( f, addr );
+    UBYTE pn = next( ctx, addr );
     const char * s;
     
     if ( pn <= MAX_INTERNAL_PERIP_REG 
          && ( s = xref_findaddrlabel( pn + INTERNAL_PERIP_REG_BASE ) ) )
-        operand( "%s", s );
+        operand( ctx, "%s", s );
     else
-        operand( "P" FORMAT_NUM_8BIT, pn );
+        operand( ctx, "P" FORMAT_NUM_8BIT, pn );
 }
 
 /***********************************************************
@@ -158,7 +158,7 @@ OPERAND_FUNC(trap)
 {
     UBYTE t = 0xFF - opc;
     
-    operand( "%d", t );
+    operand( ctx, "%d", t );
 }
 
 /***********************************************************
@@ -168,12 +168,12 @@ OPERAND_FUNC(trap)
  
 OPERAND_FUNC(iop16)
 {
-    UBYTE msb   = next( f, addr );
-    UBYTE lsb   = next( f, addr );
+    UBYTE msb   = next( ctx, addr );
+    UBYTE lsb   = next( ctx, addr );
     UWORD iop16 = MK_WORD( lsb, msb );
 
-    operand( "%%%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, iop16 ) );
-    xref_addxref( xtype, g_insn_addr, iop16 );
+    operand( ctx, "%%%s", XREF_WORDADDR( FORMAT_NUM_16BIT, iop16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, iop16 );
 }
 
 /***********************************************************
@@ -183,8 +183,8 @@ OPERAND_FUNC(iop16)
  
 OPERAND_FUNC(iop16_B)
 {
-    operand_iop16( f, addr, opc, xtype );
-    operand( "(B)" );
+    operand_iop16( ctx, addr, opc, xtype );
+    operand( ctx, "(B)" );
 }
 
 /***********************************************************
@@ -194,12 +194,12 @@ OPERAND_FUNC(iop16_B)
  
 OPERAND_FUNC(label)
 {
-    UBYTE msb_addr  = next( f, addr );
-    UBYTE lsb_addr  = next( f, addr );
+    UBYTE msb_addr  = next( ctx, addr );
+    UBYTE lsb_addr  = next( ctx, addr );
     UWORD addr16    = MK_WORD( lsb_addr, msb_addr );
 
-    operand( "@%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "@%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -209,8 +209,8 @@ OPERAND_FUNC(label)
  
 OPERAND_FUNC(label_B)
 {
-    operand_label( f, addr, opc, xtype );
-    operand( "(B)" );
+    operand_label( ctx, addr, opc, xtype );
+    operand( ctx, "(B)" );
 }
 
 /***********************************************************
@@ -219,8 +219,8 @@ OPERAND_FUNC(label_B)
  
 OPERAND_FUNC(indreg)
 {
-    operand( "*" );
-    operand_reg( f, addr, opc, xtype );
+    operand( ctx, "*" );
+    operand_reg( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -229,11 +229,11 @@ OPERAND_FUNC(indreg)
 
 OPERAND_FUNC(ofst)
 {
-    BYTE ofst = (BYTE)next( f, addr );
+    BYTE ofst = (BYTE)next( ctx, addr );
     ADDR dest = *addr + ofst;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /******************************************************************************/
@@ -300,6 +300,11 @@ THREE_OPERAND(reg, Pn, ofst)
                 INSN( M_name, label,   ( 0x80 | M_mask ), X_PTR ) \
                 INSN( M_name, label_B, ( 0xA0 | M_mask ), X_PTR ) \
                 INSN( M_name, indreg,  ( 0x90 | M_mask ), X_PTR )
+
+#define WORD_OPS_STOP(M_name, M_mask) \
+                INSN_STOP( M_name, label,   ( 0x80 | M_mask ), X_PTR ) \
+                INSN_STOP( M_name, label_B, ( 0xA0 | M_mask ), X_PTR ) \
+                INSN_STOP( M_name, indreg,  ( 0x90 | M_mask ), X_PTR )
                 
 #define BT_OP(M_name, M_mask) \
                 INSN( M_name, B_A_ofst,        ( 0x60 | M_mask ), X_NONE ) \
@@ -352,12 +357,12 @@ optab_t base_optab[] = {
     INSN ( "JPZ", ofst, 0xE5, X_JMP )
 #endif
 
-    INSN ( "JMP", ofst, 0xE0, X_JMP )
-    WORD_OPS( "BR",   0x0C )
+    INSN_STOP ( "JMP", ofst, 0xE0, X_JMP )
+    WORD_OPS_STOP( "BR",   0x0C )
     
     WORD_OPS( "CALL", 0x0E )
-    INSN ( "RETI", none, 0x0B, X_NONE )
-    INSN ( "RETS", none, 0x0A, X_NONE )
+    INSN_STOP ( "RETI", none, 0x0B, X_NONE )
+    INSN_STOP ( "RETS", none, 0x0A, X_NONE )
 
     BT_OP( "BTJO", 0x06 )
     BT_OP( "BTJZ", 0x07 )
@@ -42,7 +42,7 @@
  * Gloabally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm78k3", "NEC 78K/III", 5, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm78k3", "NEC 78K/III", 5, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -238,12 +238,12 @@ static const char * R2[2] = {
  *      none
  *
  ************************************************************/
-static void emit_saddr( UBYTE offset )
+static void emit_saddr( dasm_ctx_t *ctx, UBYTE offset )
 {
    ADDR saddr = offset + ( offset >= 0x20 ? SADDR_OFFSET : SFR_OFFSET );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, saddr ) );
-    xref_addxref( saddr >= SFR_OFFSET ? X_REG : X_PTR, g_insn_addr, saddr );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, saddr ) );
+    dasm_addxref( ctx, saddr >= SFR_OFFSET ? X_REG : X_PTR, ctx->insn_addr, saddr );
 }
 
 /******************************************************************************/
@@ -271,7 +271,7 @@ OPERAND_FUNC(bit)
 {
     UBYTE bit = opc & 0x07;
     
-    operand( ".%d", bit );
+    operand( ctx, ".%d", bit );
 }
 
 /***********************************************************
@@ -283,7 +283,7 @@ OPERAND_FUNC(r)
 {
     UBYTE r = opc & 0x0F;
     
-    operand( "%s", R[r] );
+    operand( ctx, "%s", R[r] );
 }
 
 /***********************************************************
@@ -295,7 +295,7 @@ OPERAND_FUNC(r1)
 {
     UBYTE r1 = opc & 0x07;
     
-    operand( "%s", R[r1] );
+    operand( ctx, "%s", R[r1] );
 }
 
 /***********************************************************
@@ -307,7 +307,7 @@ OPERAND_FUNC(r2)
 {
     UBYTE r2 = opc & 0x01;
     
-    operand( "%s", R2[r2] );
+    operand( ctx, "%s", R2[r2] );
 }
 
 /***********************************************************
@@ -319,7 +319,7 @@ OPERAND_FUNC(rp)
 {
     UBYTE rp = opc & 0x07;
     
-    operand( "%s", RP[rp] );
+    operand( ctx, "%s", RP[rp] );
 }
 
 /***********************************************************
@@ -331,7 +331,7 @@ OPERAND_FUNC(rp1)
 {
     UBYTE rp1 = opc & 0x07;
     
-    operand( "%s", RP1[rp1] );
+    operand( ctx, "%s", RP1[rp1] );
 }
 
 /***********************************************************
@@ -343,7 +343,7 @@ OPERAND_FUNC(rp2)
 {
     UBYTE rp2 = opc & 0x03;
     
-    operand( "%s", RP2[rp2] );
+    operand( ctx, "%s", RP2[rp2] );
 }
 
 /***********************************************************
@@ -355,7 +355,7 @@ OPERAND_FUNC(RBn)
 {
     UBYTE n = opc & 0x07;
     
-    operand( "RB%d", n );
+    operand( ctx, "RB%d", n );
 }
 
 /***********************************************************
@@ -367,9 +367,9 @@ OPERAND_FUNC(RBn_ALT)
 {
     UBYTE n = opc & 0x07;
     
-    operand( "RB%d", n );
+    operand( ctx, "RB%d", n );
     COMMA;
-    operand( "ALT" );
+    operand( ctx, "ALT" );
 }
 
 /***********************************************************
@@ -379,9 +379,9 @@ OPERAND_FUNC(RBn_ALT)
 
 OPERAND_FUNC(byte)
 {
-   UBYTE byte = next( f, addr );
+   UBYTE byte = next( ctx, addr );
     
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -391,9 +391,9 @@ OPERAND_FUNC(byte)
 
 OPERAND_FUNC(saddr)
 {
-   UBYTE saddr_offset = next( f, addr );
+   UBYTE saddr_offset = next( ctx, addr );
     
-    emit_saddr( saddr_offset );
+    emit_saddr( ctx, saddr_offset );
 }
 
 /***********************************************************
@@ -403,9 +403,9 @@ OPERAND_FUNC(saddr)
 
 OPERAND_FUNC(saddrp)
 {
-   UBYTE saddrp_offset = next( f, addr );
+   UBYTE saddrp_offset = next( ctx, addr );
     
-    emit_saddr( saddrp_offset );
+    emit_saddr( ctx, saddrp_offset );
 }
 
 /***********************************************************
@@ -415,16 +415,16 @@ OPERAND_FUNC(saddrp)
 
 OPERAND_FUNC(sfr)
 {
-   UBYTE sfr_offset = next( f, addr );
+   UBYTE sfr_offset = next( ctx, addr );
     
     if ( sfr_offset == 0xFE )
-        operand( "PSWL" );
+        operand( ctx, "PSWL" );
     else if ( sfr_offset == 0xFF )
-        operand( "PSWH" );
+        operand( ctx, "PSWH" );
     else
     {
-        operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, sfr_offset + SFR_OFFSET ) );
-        xref_addxref( X_REG, g_insn_addr, sfr_offset + SFR_OFFSET );
+        operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, sfr_offset + SFR_OFFSET ) );
+        dasm_addxref( ctx, X_REG, ctx->insn_addr, sfr_offset + SFR_OFFSET );
     }
 }
 
@@ -435,18 +435,18 @@ OPERAND_FUNC(sfr)
 
 OPERAND_FUNC(sfrp)
 {
-   UBYTE sfr_offset = next( f, addr );
+   UBYTE sfr_offset = next( ctx, addr );
     
     if ( sfr_offset == 0xFC )
-        operand( "SP" );
+        operand( ctx, "SP" );
     else if ( sfr_offset == 0xFE )
-        operand( "PSWL" );
+        operand( ctx, "PSWL" );
     else if ( sfr_offset == 0xFF )
-        operand( "PSWH" );
+        operand( ctx, "PSWH" );
     else
     {
-        operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, sfr_offset + SFR_OFFSET ) );
-        xref_addxref( X_REG, g_insn_addr, sfr_offset + SFR_OFFSET );
+        operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, sfr_offset + SFR_OFFSET ) );
+        dasm_addxref( ctx, X_REG, ctx->insn_addr, sfr_offset + SFR_OFFSET );
     }
 }
 
@@ -460,7 +460,7 @@ OPERAND_FUNC(mem)
 {
     UBYTE mem = opc & 0x07;
     
-    operand( "%s", MEM_MOD_RI[mem] );
+    operand( ctx, "%s", MEM_MOD_RI[mem] );
 }
 
 /***********************************************************
@@ -473,45 +473,45 @@ OPERAND_FUNC(memmod)
     UBYTE mod = opc & 0x1F;
     UBYTE mem, low_offset, high_offset;
     
-    mem = next( f, addr );
+    mem = next( ctx, addr );
     mem = ( mem >> 4 ) & 0x07;
     
     if ( mod == 0x16 ) /* Register Indirect Addressing */
-        operand_mem( f, addr, mem, xtype );
+        operand_mem( ctx, addr, mem, xtype );
     else if ( mod == 0x17 ) /* Base Index Addressing */
-        operand( "%s", MEM_MOD_BI[mem] );
+        operand( ctx, "%s", MEM_MOD_BI[mem] );
     else if ( mod == 0x06 ) /* Base Addressing */
     {
-       low_offset  = next( f, addr );
-        operand( "%s" FORMAT_NUM_8BIT "]", MEM_MOD_BASE[mem], low_offset );
+       low_offset  = next( ctx, addr );
+        operand( ctx, "%s" FORMAT_NUM_8BIT "]", MEM_MOD_BASE[mem], low_offset );
     }
     else if ( mod == 0x0A ) /* Index Addressing */
     {
         UWORD base;
         
-        low_offset  = next( f, addr );
-        high_offset = next( f, addr );        
+        low_offset  = next( ctx, addr );
+        high_offset = next( ctx, addr );        
         base        = MK_WORD(low_offset, high_offset);
         
         if ( xref_findaddrlabel( base ) )
         {
-            operand( "%s%s", 
-                         xref_genwordaddr( NULL, FORMAT_NUM_16BIT, base ), 
+            operand( ctx, "%s%s", 
+                         XREF_WORDADDR( FORMAT_NUM_16BIT, base ), 
                         MEM_MOD_INDEX[mem] );
         }
         else if ( xref_findaddrlabel( base - 1 ) )
         {
-            operand( "%s+1%s", 
-                         xref_genwordaddr( NULL, FORMAT_NUM_16BIT, base - 1 ), 
+            operand( ctx, "%s+1%s", 
+                         XREF_WORDADDR( FORMAT_NUM_16BIT, base - 1 ), 
                         MEM_MOD_INDEX[mem] );
         }
         else
         {
-            operand( "$" FORMAT_ADDR "%s", 
-                         base, 
+            operand( ctx, "$" FORMAT_ADDR "%s", 
+                         ADDR_DIGITS, base, 
                         MEM_MOD_INDEX[mem] );
         }
-        xref_addxref( X_TABLE, g_insn_addr, base );
+        dasm_addxref( ctx, X_TABLE, ctx->insn_addr, base );
     }
 }
 
@@ -524,8 +524,8 @@ OPERAND_FUNC(ind_addr5)
     UBYTE addr5 = opc & 0x1f;
     ADDR  vector = 0x0040 + ( 2 * addr5 );
     
-    operand( "[" FORMAT_NUM_16BIT "]", vector );
-    xref_addxref( xtype, g_insn_addr, vector );
+    operand( ctx, "[" FORMAT_NUM_16BIT "]", vector );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, vector );
 }
 
 /***********************************************************
@@ -534,11 +534,11 @@ OPERAND_FUNC(ind_addr5)
 
 OPERAND_FUNC(addr11_abs)
 {
-    UBYTE low_addr = next( f, addr );
+    UBYTE low_addr = next( ctx, addr );
     ADDR addr11 = MK_WORD( low_addr, opc & 0x07 );
     
-    operand( "!%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr11 ) );
-    xref_addxref( xtype, g_insn_addr, addr11 );
+    operand( ctx, "!%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr11 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr11 );
 }
 
 /***********************************************************
@@ -547,12 +547,12 @@ OPERAND_FUNC(addr11_abs)
 
 OPERAND_FUNC(addr16_abs)
 {
-    UBYTE low_addr  = next( f, addr );
-    UBYTE high_addr = next( f, addr );
+    UBYTE low_addr  = next( ctx, addr );
+    UBYTE high_addr = next( ctx, addr );
     UWORD addr16    = MK_WORD( low_addr, high_addr );
 
-    operand( "!%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "!%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -561,11 +561,11 @@ OPERAND_FUNC(addr16_abs)
  
 OPERAND_FUNC(addr16_rel)
 {
-    BYTE jdisp = (BYTE)next( f, addr );
+    BYTE jdisp = (BYTE)next( ctx, addr );
     ADDR addr16 = *addr + jdisp;
     
-    operand( "$%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "$%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 /***********************************************************
@@ -575,12 +575,12 @@ OPERAND_FUNC(addr16_rel)
  
 OPERAND_FUNC(word)
 {
-    UBYTE low_byte  = next( f, addr );
-    UBYTE high_byte = next( f, addr );
+    UBYTE low_byte  = next( ctx, addr );
+    UBYTE high_byte = next( ctx, addr );
     UWORD word      = MK_WORD( low_byte, high_byte );
     
-    operand( "#%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, word ) );
-    xref_addxref( xtype, g_insn_addr, word );
+    operand( ctx, "#%s", XREF_WORDADDR( FORMAT_NUM_16BIT, word ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, word );
 }
 
 /***********************************************************
@@ -589,7 +589,7 @@ OPERAND_FUNC(word)
  
 OPERAND_FUNC(A)
 {
-    operand( "A" );
+    operand( ctx, "A" );
 }
 
 /***********************************************************
@@ -598,7 +598,7 @@ OPERAND_FUNC(A)
  
 OPERAND_FUNC(CY)
 {
-    operand( "CY" );
+    operand( ctx, "CY" );
 }
 
 /***********************************************************
@@ -607,7 +607,7 @@ OPERAND_FUNC(CY)
  
 OPERAND_FUNC(SP)
 {
-    operand( "SP" );
+    operand( ctx, "SP" );
 }
 
 /***********************************************************
@@ -617,7 +617,7 @@ OPERAND_FUNC(SP)
  
 OPERAND_FUNC(post)
 {
-    UBYTE post = next( f, addr );
+    UBYTE post = next( ctx, addr );
     int bit;
     int comma = 0;
     
@@ -626,8 +626,8 @@ OPERAND_FUNC(post)
         if ( post & BIT(bit) )
         {
             if ( comma )
-                operand( "," );
-            operand( "%s", RP[bit] );
+                operand( ctx, "," );
+            operand( ctx, "%s", RP[bit] );
             comma = 1;
         }
     }
@@ -639,7 +639,7 @@ OPERAND_FUNC(post)
  
 OPERAND_FUNC(PSW)
 {
-    operand( "PSW" );
+    operand( ctx, "PSW" );
 }
 
 /***********************************************************
@@ -648,7 +648,7 @@ OPERAND_FUNC(PSW)
  
 OPERAND_FUNC(DE_inc)
 {
-    operand( "[DE+]" );
+    operand( ctx, "[DE+]" );
 }
 
 /***********************************************************
@@ -657,7 +657,7 @@ OPERAND_FUNC(DE_inc)
  
 OPERAND_FUNC(DE_dec)
 {
-    operand( "[DE-]" );
+    operand( ctx, "[DE-]" );
 }
 
 /***********************************************************
@@ -666,7 +666,7 @@ OPERAND_FUNC(DE_dec)
 
 OPERAND_FUNC(HL_inc)
 {
-    operand( "[HL+]" );
+    operand( ctx, "[HL+]" );
 }
 
 /***********************************************************
@@ -675,7 +675,7 @@ OPERAND_FUNC(HL_inc)
  
 OPERAND_FUNC(HL_dec)
 {
-    operand( "[HL-]" );
+    operand( ctx, "[HL-]" );
 }
 
 /******************************************************************************/
@@ -689,11 +689,11 @@ OPERAND_FUNC(HL_dec)
  
 OPERAND_FUNC(r_r1)
 {
-    UBYTE regs = next( f, addr );
+    UBYTE regs = next( ctx, addr );
     
-    operand_r( f, addr, regs >> 4, xtype );
+    operand_r( ctx, addr, regs >> 4, xtype );
     COMMA;
-    operand_r1( f, addr, regs, xtype );
+    operand_r1( ctx, addr, regs, xtype );
 }
 
 /***********************************************************
@@ -703,11 +703,11 @@ OPERAND_FUNC(r_r1)
  
 OPERAND_FUNC(rp_rp1)
 {
-    UBYTE regs = next( f, addr );
+    UBYTE regs = next( ctx, addr );
     
-    operand_rp( f, addr, regs >> 5, xtype );
+    operand_rp( ctx, addr, regs >> 5, xtype );
     COMMA;
-    operand_rp1( f, addr, regs, xtype );
+    operand_rp1( ctx, addr, regs, xtype );
 }
 
 /***********************************************************
@@ -720,12 +720,12 @@ OPERAND_FUNC(rp_rp1)
 
 OPERAND_FUNC(saddr_saddr)
 {
-    UBYTE saddr_src_offset = next( f, addr );
-    UBYTE saddr_dst_offset = next( f, addr );
+    UBYTE saddr_src_offset = next( ctx, addr );
+    UBYTE saddr_dst_offset = next( ctx, addr );
     
-    emit_saddr( saddr_dst_offset );
+    emit_saddr( ctx, saddr_dst_offset );
     COMMA;
-    emit_saddr( saddr_src_offset );
+    emit_saddr( ctx, saddr_src_offset );
 }
 
 /***********************************************************
@@ -734,11 +734,11 @@ OPERAND_FUNC(saddr_saddr)
  
 OPERAND_FUNC(A_saddrp)
 {
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
     COMMA;
-    operand( "[" );
-    operand_saddrp( f, addr, opc, xtype );
-    operand( "]" );
+    operand( ctx, "[" );
+    operand_saddrp( ctx, addr, opc, xtype );
+    operand( ctx, "]" );
 }
 
 /***********************************************************
@@ -747,11 +747,11 @@ OPERAND_FUNC(A_saddrp)
  
 OPERAND_FUNC(saddrp_A)
 {
-    operand( "[" );
-    operand_saddrp( f, addr, opc, xtype );
-    operand( "]" );
+    operand( ctx, "[" );
+    operand_saddrp( ctx, addr, opc, xtype );
+    operand( ctx, "]" );
     COMMA;
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -760,9 +760,9 @@ OPERAND_FUNC(saddrp_A)
 
 OPERAND_FUNC(A_addr16)
 {
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
     COMMA;
-    operand_addr16_abs( f, addr, opc, xtype );
+    operand_addr16_abs( ctx, addr, opc, xtype );
 }
  
 /***********************************************************
@@ -771,9 +771,9 @@ OPERAND_FUNC(A_addr16)
 
 OPERAND_FUNC(addr16_A)
 {
-    operand_addr16_abs( f, addr, opc, xtype );
+    operand_addr16_abs( ctx, addr, opc, xtype );
     COMMA;
-    operand_A( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -782,9 +782,9 @@ OPERAND_FUNC(addr16_A)
  
 OPERAND_FUNC(AX_saddrp)
 {
-    operand( "AX" );
+    operand( ctx, "AX" );
     COMMA;
-    operand_saddrp( f, addr, opc, xtype );
+    operand_saddrp( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -793,9 +793,9 @@ OPERAND_FUNC(AX_saddrp)
  
 OPERAND_FUNC(saddrp_AX)
 {
-    operand_saddrp( f, addr, opc, xtype );
+    operand_saddrp( ctx, addr, opc, xtype );
     COMMA;
-    operand( "AX" );
+    operand( ctx, "AX" );
 }
 
 /***********************************************************
@@ -808,12 +808,12 @@ OPERAND_FUNC(saddrp_AX)
  
 OPERAND_FUNC(saddrp_saddrp)
 {
-    UBYTE saddr_src_offset = next( f, addr );
-    UBYTE saddr_dst_offset = next( f, addr );
+    UBYTE saddr_src_offset = next( ctx, addr );
+    UBYTE saddr_dst_offset = next( ctx, addr );
     
-    emit_saddr( saddr_dst_offset );
+    emit_saddr( ctx, saddr_dst_offset );
     COMMA;
-    emit_saddr( saddr_src_offset );
+    emit_saddr( ctx, saddr_src_offset );
 }
 
 /***********************************************************
@@ -822,9 +822,9 @@ OPERAND_FUNC(saddrp_saddrp)
  
 OPERAND_FUNC(AX_sfrp)
 {
-    operand( "AX" );
+    operand( ctx, "AX" );
     COMMA;
-    operand_sfrp( f, addr, opc, xtype );
+    operand_sfrp( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -833,9 +833,9 @@ OPERAND_FUNC(AX_sfrp)
  
 OPERAND_FUNC(sfrp_AX)
 {
-    operand_sfrp( f, addr, opc, xtype );
+    operand_sfrp( ctx, addr, opc, xtype );
     COMMA;
-    operand( "AX" );
+    operand( ctx, "AX" );
 }
 
 /***********************************************************
@@ -844,9 +844,9 @@ OPERAND_FUNC(sfrp_AX)
 
 OPERAND_FUNC(rp1_addr16)
 {
-    operand_rp1( f, addr, opc, xtype );
+    operand_rp1( ctx, addr, opc, xtype );
     COMMA;
-    operand_addr16_abs( f, addr, opc, xtype );
+    operand_addr16_abs( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -855,9 +855,9 @@ OPERAND_FUNC(rp1_addr16)
 
 OPERAND_FUNC(addr16_rp1)
 {
-    operand_addr16_abs( f, addr, opc, xtype );
+    operand_addr16_abs( ctx, addr, opc, xtype );
     COMMA;
-    operand_rp1( f, addr, opc, xtype );
+    operand_rp1( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -866,9 +866,9 @@ OPERAND_FUNC(addr16_rp1)
  
 OPERAND_FUNC(AX_word)
 {
-    operand( "AX" );
+    operand( ctx, "AX" );
     COMMA;
-    operand_word( f, addr, opc, xtype );
+    operand_word( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -878,11 +878,11 @@ OPERAND_FUNC(AX_word)
  
 OPERAND_FUNC(r1_n)
 {
-   UBYTE args = next( f, addr );
+   UBYTE args = next( ctx, addr );
     
-    operand_r1( f, addr, args, xtype );
+    operand_r1( ctx, addr, args, xtype );
     COMMA;
-    operand( "%d", ( args >> 3 ) & 0x07 );
+    operand( ctx, "%d", ( args >> 3 ) & 0x07 );
 }
 
 /***********************************************************
@@ -892,11 +892,11 @@ OPERAND_FUNC(r1_n)
  
 OPERAND_FUNC(rp1_n)
 {
-   UBYTE args = next( f, addr );
+   UBYTE args = next( ctx, addr );
     
-    operand_rp1( f, addr, args, xtype );
+    operand_rp1( ctx, addr, args, xtype );
     COMMA;
-    operand( "%d", ( args >> 3 ) & 0x07 );
+    operand( ctx, "%d", ( args >> 3 ) & 0x07 );
 }
 
 /***********************************************************
@@ -905,9 +905,9 @@ OPERAND_FUNC(rp1_n)
  
 OPERAND_FUNC(rp1_ind)
 {
-    operand( "[" );
-    operand_rp1( f, addr, opc, xtype );
-    operand( "]" );
+    operand( ctx, "[" );
+    operand_rp1( ctx, addr, opc, xtype );
+    operand( ctx, "]" );
 }
 
 /***********************************************************
@@ -916,8 +916,8 @@ OPERAND_FUNC(rp1_ind)
  
 OPERAND_FUNC(saddr_bit)
 {
-    operand_saddr( f, addr, opc, xtype );
-    operand_bit( f, addr, opc, xtype );
+    operand_saddr( ctx, addr, opc, xtype );
+    operand_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -926,8 +926,8 @@ OPERAND_FUNC(saddr_bit)
  
 OPERAND_FUNC(sfr_bit)
 {
-    operand_sfr( f, addr, opc, xtype );
-    operand_bit( f, addr, opc, xtype );
+    operand_sfr( ctx, addr, opc, xtype );
+    operand_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -936,8 +936,8 @@ OPERAND_FUNC(sfr_bit)
  
 OPERAND_FUNC(A_bit)
 {
-    operand_A( f, addr, opc, xtype );
-    operand_bit( f, addr, opc, xtype );
+    operand_A( ctx, addr, opc, xtype );
+    operand_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -946,8 +946,8 @@ OPERAND_FUNC(A_bit)
  
 OPERAND_FUNC(X_bit)
 {
-    operand( "X" );
-    operand_bit( f, addr, opc, xtype );
+    operand( ctx, "X" );
+    operand_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -956,8 +956,8 @@ OPERAND_FUNC(X_bit)
  
 OPERAND_FUNC(PSWL_bit)
 {
-    operand( "PSWL" );
-    operand_bit( f, addr, opc, xtype );
+    operand( ctx, "PSWL" );
+    operand_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -966,8 +966,8 @@ OPERAND_FUNC(PSWL_bit)
  
 OPERAND_FUNC(PSWH_bit)
 {
-    operand( "PSWH" );
-    operand_bit( f, addr, opc, xtype );
+    operand( ctx, "PSWH" );
+    operand_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -976,10 +976,10 @@ OPERAND_FUNC(PSWH_bit)
  
 OPERAND_FUNC(CY_n_saddr_bit)
 {
-    operand_CY( f, addr, opc, xtype );
+    operand_CY( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_saddr_bit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_saddr_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -988,10 +988,10 @@ OPERAND_FUNC(CY_n_saddr_bit)
  
 OPERAND_FUNC(CY_n_sfr_bit)
 {
-    operand_CY( f, addr, opc, xtype );
+    operand_CY( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_sfr_bit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_sfr_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -1000,10 +1000,10 @@ OPERAND_FUNC(CY_n_sfr_bit)
  
 OPERAND_FUNC(CY_n_A_bit)
 {
-    operand_CY( f, addr, opc, xtype );
+    operand_CY( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_A_bit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_A_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -1012,10 +1012,10 @@ OPERAND_FUNC(CY_n_A_bit)
  
 OPERAND_FUNC(CY_n_X_bit)
 {
-    operand_CY( f, addr, opc, xtype );
+    operand_CY( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_X_bit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_X_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -1024,10 +1024,10 @@ OPERAND_FUNC(CY_n_X_bit)
  
 OPERAND_FUNC(CY_n_PSWL_bit)
 {
-    operand_CY( f, addr, opc, xtype );
+    operand_CY( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_PSWL_bit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_PSWL_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -1036,10 +1036,10 @@ OPERAND_FUNC(CY_n_PSWL_bit)
  
 OPERAND_FUNC(CY_n_PSWH_bit)
 {
-    operand_CY( f, addr, opc, xtype );
+    operand_CY( ctx, addr, opc, xtype );
     COMMA;
-    operand( "/" );
-    operand_PSWH_bit( f, addr, opc, xtype );
+    operand( ctx, "/" );
+    operand_PSWH_bit( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -1052,11 +1052,11 @@ OPERAND_FUNC(CY_n_PSWH_bit)
 
 OPERAND_FUNC(STBC_byte)
 {
-    (void)next( f, addr );
+    (void)next( ctx, addr );
     
-    operand( "STBC" );
+    operand( ctx, "STBC" );
     COMMA;
-    operand_byte( f, addr, opc, xtype );
+    operand_byte( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -1069,11 +1069,11 @@ OPERAND_FUNC(STBC_byte)
 
 OPERAND_FUNC(WDM_byte)
 {
-    (void)next( f, addr );
+    (void)next( ctx, addr );
     
-    operand( "WDM" );
+    operand( ctx, "WDM" );
     COMMA;
-    operand_byte( f, addr, opc, xtype );
+    operand_byte( ctx, addr, opc, xtype );
 }
 
 /* Simple cases */
@@ -1265,8 +1265,8 @@ static optab_t optab_05[] = {
     INSN  ( "incw",  SP,       0xC8, X_NONE )
     INSN  ( "decw",  SP,       0xC9, X_NONE )
     
-    RANGE ( "br",    rp1,      0x48, 0x4F, X_JMP )
-    RANGE ( "br",    rp1_ind,  0x68, 0x6F, X_JMP )
+    RANGE_STOP ( "br",    rp1,      0x48, 0x4F, X_JMP )
+    RANGE_STOP ( "br",    rp1_ind,  0x68, 0x6F, X_JMP )
     
     RANGE ( "brkcs", RBn,      0xD8, 0xDF, X_NONE )
     
@@ -1554,8 +1554,8 @@ optab_t base_optab[] = {
     RANGE ( "callf",  addr11_abs,  0x90, 0x97, X_CALL )
     RANGE ( "callt",  ind_addr5,   0xE0, 0xFF, X_TABLE )
     INSN  ( "brk",    none,        0x5E, X_NONE )
-    INSN  ( "ret",    none,        0x56, X_NONE )
-    INSN  ( "reti",   none,        0x57, X_NONE )
+    INSN_STOP  ( "ret",    none,        0x56, X_NONE )
+    INSN_STOP  ( "reti",   none,        0x57, X_NONE )
     
 /*----------------------------------------------------------------------------
   Stack Manipulation
@@ -1572,8 +1572,8 @@ optab_t base_optab[] = {
   Unconditional Branch
   ----------------------------------------------------------------------------*/    
     
-    INSN  ( "br",     addr16_abs, 0x2C, X_JMP )
-    INSN  ( "br",     addr16_rel, 0x14, X_JMP )
+    INSN_STOP  ( "br",     addr16_abs, 0x2C, X_JMP )
+    INSN_STOP  ( "br",     addr16_rel, 0x14, X_JMP )
     
 /*----------------------------------------------------------------------------
   Conditional Branch
@@ -1599,7 +1599,7 @@ optab_t base_optab[] = {
   ----------------------------------------------------------------------------*/    
     
     /* BRKCS in optab_05 */
-    INSN  ( "retcs",  addr16_abs,  0x29, X_NONE )
+    INSN_STOP  ( "retcs",  addr16_abs,  0x29, X_NONE )
     
 /*----------------------------------------------------------------------------
   String
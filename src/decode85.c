@@ -50,7 +50,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasm85", "Intel 8085", 4, 9, 0, 1, 1 )
+DASM_PROFILE( "dasm85", "Intel 8085", 4, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -91,9 +91,9 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( FORMAT_NUM_8BIT, byte );
+    operand( ctx, FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -102,12 +102,12 @@ OPERAND_FUNC(imm8)
 
 OPERAND_FUNC(imm16)
 {
-    UBYTE lsb   = next( f, addr );
-    UBYTE msb   = next( f, addr );
+    UBYTE lsb   = next( ctx, addr );
+    UBYTE msb   = next( ctx, addr );
     UWORD imm16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, imm16 ) );
-    xref_addxref( xtype, g_insn_addr, imm16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, imm16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, imm16 );
 }
 
 /***********************************************************
@@ -120,13 +120,13 @@ OPERAND_FUNC(regS)
     UBYTE reg = opc & 0x07;
     static char *rtab[] = { "B", "C", "D", "E", "H", "L", "M", "A" };
     
-    operand( "%s", rtab[reg] );
+    operand( ctx, "%s", rtab[reg] );
 }
 
 /* xxRRR_Rxxx */
 OPERAND_FUNC(regD)
 {
-    operand_regS( f, addr, opc >> 3, xtype );
+    operand_regS( ctx, addr, opc >> 3, xtype );
 }
 
 /* xxRR_xxxx */
@@ -135,7 +135,7 @@ OPERAND_FUNC(rpairPSW)
     UBYTE reg = ( opc >> 4 ) & 0x03;
     static char *rtab[] = { "B", "D", "H", "PSW" };
     
-    operand( "%s", rtab[reg] );
+    operand( ctx, "%s", rtab[reg] );
 }
 
 OPERAND_FUNC(rpair)
@@ -143,7 +143,7 @@ OPERAND_FUNC(rpair)
     UBYTE reg = ( opc >> 4 ) & 0x03;
     static char *rtab[] = { "B", "D", "H", "SP" };
     
-    operand( "%s", rtab[reg] );
+    operand( ctx, "%s", rtab[reg] );
 }
 
 /* xxRR_xxxx */
@@ -152,7 +152,7 @@ OPERAND_FUNC(indrpair)
     UBYTE reg = ( opc >> 4 ) & 0x03;
     static char *rtab[] = { "B", "D", "???", "???" };
     
-    operand( "%s", rtab[reg] );
+    operand( ctx, "%s", rtab[reg] );
 }
 
 /***********************************************************
@@ -161,12 +161,12 @@ OPERAND_FUNC(indrpair)
 
 OPERAND_FUNC(addr16)
 {
-    UBYTE lsb = next( f, addr );
-    UBYTE msb = next( f, addr );
+    UBYTE lsb = next( ctx, addr );
+    UBYTE msb = next( ctx, addr );
     ADDR dest = MK_WORD( lsb, msb );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -175,12 +175,12 @@ OPERAND_FUNC(addr16)
 
 OPERAND_FUNC(mem16)
 {
-    UBYTE lsb = next( f, addr );
-    UBYTE msb = next( f, addr );
+    UBYTE lsb = next( ctx, addr );
+    UBYTE msb = next( ctx, addr );
     ADDR dest = MK_WORD( lsb, msb );
     
-    operand( "(%s)", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "(%s)", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -189,10 +189,10 @@ OPERAND_FUNC(mem16)
 
 OPERAND_FUNC(iop8)
 {
-    UBYTE ioport = next( f, addr );
+    UBYTE ioport = next( ctx, addr );
     
-    operand( "(%s)", xref_genwordaddr( NULL, FORMAT_NUM_8BIT, ioport ) );
-    xref_addxref( xtype, g_insn_addr, ioport );
+    operand( ctx, "(%s)", XREF_WORDADDR( FORMAT_NUM_8BIT, ioport ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, ioport );
 }
 
 /***********************************************************
@@ -203,7 +203,7 @@ OPERAND_FUNC(rst)
 {
     UBYTE rst = ( opc >> 3 ) & 0x07;
     
-    operand( FORMAT_NUM_8BIT, rst );
+    operand( ctx, FORMAT_NUM_8BIT, rst );
 }
 
 /******************************************************************************/
@@ -307,7 +307,7 @@ optab_t base_optab[] = {
   Control Transfer
   ----------------------------------------------------------------------------*/
 
-    INSN ( "JMP",   addr16,      0xC3,       X_JMP )
+    INSN_STOP ( "JMP",   addr16,      0xC3,       X_JMP )
     
 #define JCR(M_name,M_op,M_bit,M_type) \
     INSN( M_name "NZ",M_op, M_bit | (0 << 3), M_type) \
@@ -326,10 +326,10 @@ optab_t base_optab[] = {
     INSN ( "CALL",  addr16,      0xCD,       X_CALL )
     JCR  ( "C",     addr16,      0xC4,       X_CALL )
 
-    INSN ( "RET",   none,        0xC9,       X_NONE )
+    INSN_STOP ( "RET",   none,        0xC9,       X_NONE )
     JCR  ( "R",     none,        0xC0,       X_NONE )
 
-    INSN ( "PCHL",  none,        0xE9,       X_NONE )
+    INSN_STOP ( "PCHL",  none,        0xE9,       X_NONE )
 
 /*----------------------------------------------------------------------------
   Stack Operations
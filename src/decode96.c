@@ -38,10 +38,7 @@
 #include "dasmxx.h"
 
 
-DASM_PROFILE( "dasm96", "Intel 8096", 8, 9, 0, 1, 1 )
-
-
-static char * output_buffer = NULL;
+DASM_PROFILE( "dasm96", "Intel 8096", 8, 9, 0, 1, 1, 4, 2 )
 
 
 #define ADDR_DIRECT     0
@@ -117,22 +114,22 @@ char instrlen[] = {
  *        Private Functions
  *****************************************************************************/
  
-static void opcode( const char *opcode )
+static void opcode( dasm_ctx_t *ctx, const char *opcode )
 {
-	int n = sprintf( output_buffer, "%-*s", dasm_max_opcode_width, opcode );
-	output_buffer += n;
+	int n = sprintf( ctx->outbuf, "%-*s", dasm_max_opcode_width, opcode );
+	ctx->outbuf += n;
 }
 
-static void operand( const char *operand, ... )
+static void operand_text( dasm_ctx_t *ctx, const char *operand, ... )
 {
 	va_list ap;
 	int n;
 	
 	va_start( ap, operand );
-	n = vsprintf( output_buffer, operand, ap );
+	n = vsprintf( ctx->outbuf, operand, ap );
 	va_end( ap );
 	
-	output_buffer += n;
+	ctx->outbuf += n;
 }
 
 /***********************************************************
@@ -182,7 +179,7 @@ static short getOffset( unsigned char * buf )
  *
  ************************************************************/
 
-static void do_sjmp( int addr, unsigned char *buf, int n )
+static void do_sjmp( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     short offset;
     
@@ -191,8 +188,9 @@ static void do_sjmp( int addr, unsigned char *buf, int n )
     if ( buf[0] & 4 )
         offset |= 0xFC00;
     
-    operand( "sjmp    %s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + offset ) );
-    xref_addxref( X_JMP, addr - n, addr + offset );
+    operand( ctx, "sjmp    %s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr + offset ) );
+    dasm_addxref( ctx, X_JMP, addr - n, addr + offset );
+    ctx->flow_stop = 1;
 }
 
 /***********************************************************
@@ -208,7 +206,7 @@ static void do_sjmp( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_scall( int addr, unsigned char *buf, int n )
+static void do_scall( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     short offset;
     
@@ -217,8 +215,8 @@ static void do_scall( int addr, unsigned char *buf, int n )
     if ( buf[0] & 4 )
         offset |= 0xFC00;
     
-    operand( "scall   %s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + offset ) );
-    xref_addxref( X_CALL, addr - n, addr + offset );
+    operand( ctx, "scall   %s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr + offset ) );
+    dasm_addxref( ctx, X_CALL, addr - n, addr + offset );
 }
 
 /***********************************************************
@@ -234,10 +232,10 @@ static void do_scall( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_jbc( int addr, unsigned char *buf, int n )
+static void do_jbc( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
-    operand( "jbc     R%02X,%d, %s", buf[1], buf[0] & 0x07, xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
-    xref_addxref( X_JMP, addr - n, addr + (char)buf[2] );
+    operand( ctx, "jbc     R%02X,%d, %s", buf[1], buf[0] & 0x07, XREF_WORDADDR( FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
+    dasm_addxref( ctx, X_JMP, addr - n, addr + (char)buf[2] );
 }
 
 /***********************************************************
@@ -253,10 +251,10 @@ static void do_jbc( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_jbs( int addr, unsigned char *buf, int n )
+static void do_jbs( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
-    operand( "jbs     R%02X,%d, %s", buf[1], buf[0] & 0x07, xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
-    xref_addxref( X_JMP, addr - n, addr + (char)buf[2] );
+    operand( ctx, "jbs     R%02X,%d, %s", buf[1], buf[0] & 0x07, XREF_WORDADDR( FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
+    dasm_addxref( ctx, X_JMP, addr - n, addr + (char)buf[2] );
 }
 
 /***********************************************************
@@ -272,15 +270,15 @@ static void do_jbs( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_condjmp( int addr, unsigned char *buf, int n )
+static void do_condjmp( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     char *opcodes[] = { "jnst",     "jnh",      "jgt",      "jnc",
                         "jnvt",     "jnv",      "jge",      "jne",
                         "jst",      "jh",       "jle",      "jc", 
                         "jvt",      "jv",       "jlt",      "je" };
 
-    operand( "%-6s  %s", opcodes[buf[0] & 0x0F], xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + (char)buf[1] ) );
-    xref_addxref( X_JMP, addr - n, addr + (char)buf[1] );
+    operand( ctx, "%-6s  %s", opcodes[buf[0] & 0x0F], XREF_WORDADDR( FORMAT_NUM_16BIT, addr + (char)buf[1] ) );
+    dasm_addxref( ctx, X_JMP, addr - n, addr + (char)buf[1] );
 }
 
 /***********************************************************
@@ -296,14 +294,18 @@ static void do_condjmp( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_f0( int addr, unsigned char *buf, int n )
+static void do_f0( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     char *opcodes[] = { "ret",      "",         "pushf",    "popf",
                         "pusha",    "popa",     "idlpd",    "trap",
                         "clrc",     "setc",     "di",       "ei",
                         "clrvt",    "nop",      "",         "rst" };
 
-    operand( "%s", opcodes[buf[0] & 0x0F] );
+    operand( ctx, "%s", opcodes[buf[0] & 0x0F] );
+
+    /* ret and rst */
+    if ( ( buf[0] & 0x0F ) == 0x00 || ( buf[0] & 0x0F ) == 0x0F )
+        ctx->flow_stop = 1;
 }
 
 /***********************************************************
@@ -320,7 +322,7 @@ static void do_f0( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_middle( int addr, unsigned char *buf, int n, int isSigned )
+static void do_middle( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n, int isSigned )
 {
     char *opcodes[] = { "and",      "add",      "sub",      "mul",
                         "and",      "add",      "sub",      "mul",
@@ -353,27 +355,27 @@ static void do_middle( int addr, unsigned char *buf, int n, int isSigned )
     if ( buf[0] & 0x04 ) op |= 1;
     
     if ( op == 0x0F )   /* Handle ldb{s|z}e */
-        operand( "%s", ( buf[0] & 0x10 ) ? "ldbse " : "ldbze " );
+        operand( ctx, "%s", ( buf[0] & 0x10 ) ? "ldbse " : "ldbze " );
     else
     {
         if ( isSigned )
-            operand( "%s%s%c", opcodes[op], 
+            operand( ctx, "%s%s%c", opcodes[op], 
                     ( isSigned ) ? "" : "u", 
                     ( buf[0] & 0x10 ) ? 'b' : ' ' );
         else
-            operand( "%s%c", opcodes[op], ( buf[0] & 0x10 ) ? 'b' : ' ' );
+            operand( ctx, "%s%c", opcodes[op], ( buf[0] & 0x10 ) ? 'b' : ' ' );
     }
     
     for ( i = strlen( opcodes[op] ); i < 7; i++ )
-        operand( " " );;
+        operand( ctx, " " );;
     
     switch( buf[0] & 0x3 )
     {
         case ADDR_DIRECT:
             if ( n == 3 )
-                operand( "R%02X, R%02X", buf[2], buf[1] );
+                operand( ctx, "R%02X, R%02X", buf[2], buf[1] );
             else
-                operand( "R%02X, R%02X, R%02X", buf[3], buf[2], buf[1] );
+                operand( ctx, "R%02X, R%02X, R%02X", buf[3], buf[2], buf[1] );
             break;
             
         case ADDR_IMMED:
@@ -382,31 +384,31 @@ static void do_middle( int addr, unsigned char *buf, int n, int isSigned )
                 /* byte const */
                 
                 if ( n == 4 )
-                    operand( "R%02X, ", buf[3] );
+                    operand( ctx, "R%02X, ", buf[3] );
                 
-                operand( "R%02X, #%02X", buf[2], buf[1] );
+                operand( ctx, "R%02X, #%02X", buf[2], buf[1] );
             }
             else
             {
                 /* word const */
                 if ( n == 5 )
-                    operand( "R%02X, ", buf[4] );
-                operand( "R%02X, #%s", buf[3], 
-                        xref_genwordaddr( NULL, FORMAT_NUM_16BIT, getAddress(&buf[1]) ) );
-                xref_addxref( X_DATA, addr - n, getAddress(&buf[1]) );
+                    operand( ctx, "R%02X, ", buf[4] );
+                operand( ctx, "R%02X, #%s", buf[3], 
+                        XREF_WORDADDR( FORMAT_NUM_16BIT, getAddress(&buf[1]) ) );
+                dasm_addxref( ctx, X_DATA, addr - n, getAddress(&buf[1]) );
             }
             break;
 
         case ADDR_INDIR:
             if ( n == 4 )
-                operand( "R%02X, ", buf[3] );
+                operand( ctx, "R%02X, ", buf[3] );
             
             if ( n >= 3 )
-                operand( "R%02X, ", buf[2] );
+                operand( ctx, "R%02X, ", buf[2] );
             
-            operand( "[R%02X]", buf[1] & 0xFE );
+            operand( ctx, "[R%02X]", buf[1] & 0xFE );
             if ( buf[1] & 0x01 )
-                operand( "+" );
+                operand( ctx, "+" );
 
             break;
 
@@ -417,14 +419,14 @@ static void do_middle( int addr, unsigned char *buf, int n, int isSigned )
                 if ( buf[1] & 0x01 )
                 {
                     /* word offset */
-                    operand( "R%02X, R%02X, %s[R%02X]", buf[5], buf[4], 
-                            xref_genwordaddr( NULL, FORMAT_NUM_16BIT, getAddress(&buf[2]) ), buf[1] & 0xFE );
-                    xref_addxref( X_PTR, addr - n, getAddress( &buf[2] ) );
+                    operand( ctx, "R%02X, R%02X, %s[R%02X]", buf[5], buf[4], 
+                            XREF_WORDADDR( FORMAT_NUM_16BIT, getAddress(&buf[2]) ), buf[1] & 0xFE );
+                    dasm_addxref( ctx, X_PTR, addr - n, getAddress( &buf[2] ) );
                 }
                 else
                 {
                     /* byte offset */
-                    operand( "R%02X, R%02X, %02X[R%02X]", buf[4], buf[3], buf[2], buf[1] & 0xFE );
+                    operand( ctx, "R%02X, R%02X, %02X[R%02X]", buf[4], buf[3], buf[2], buf[1] & 0xFE );
                 }
             }
             else
@@ -433,14 +435,14 @@ static void do_middle( int addr, unsigned char *buf, int n, int isSigned )
                 if ( buf[1] & 0x01 )
                 {
                     /* word offset */
-                    operand( "R%02X, %s[R%02X]", buf[4], xref_genwordaddr( NULL, FORMAT_NUM_16BIT, getAddress(&buf[2]) ),
+                    operand( ctx, "R%02X, %s[R%02X]", buf[4], XREF_WORDADDR( FORMAT_NUM_16BIT, getAddress(&buf[2]) ),
                             buf[1] & 0xFE );
-                    xref_addxref( X_PTR, addr - n, getAddress(&buf[2]) );                    
+                    dasm_addxref( ctx, X_PTR, addr - n, getAddress(&buf[2]) );                    
                 }
                 else
                 {
                     /* byte offset */
-                    operand( "R%02X, %02X[R%02X]", buf[3], buf[2], buf[1] & 0xFE );
+                    operand( ctx, "R%02X, %02X[R%02X]", buf[3], buf[2], buf[1] & 0xFE );
                 }
             }
             break;
@@ -460,7 +462,7 @@ static void do_middle( int addr, unsigned char *buf, int n, int isSigned )
  *
  ************************************************************/
 
-static void do_00( int addr, unsigned char *buf, int n )
+static void do_00( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     char *opcodes[] = { "skip",     "clr",      "not",      "neg",
                         "",         "dec",      "ext",      "inc",
@@ -472,18 +474,18 @@ static void do_00( int addr, unsigned char *buf, int n )
                         "shrb",     "shlb",     "shrab",    "",
                         "",         "",         "",         "" };
     
-    operand( "%-6s  ", opcodes[buf[0] & 0x1F] );
+    operand( ctx, "%-6s  ", opcodes[buf[0] & 0x1F] );
     
     if ( buf[0] & 0x08 )
     {
-        operand( "R%02X, ", buf[2] );
+        operand( ctx, "R%02X, ", buf[2] );
         if ( buf[0] != 0x0F && buf[1] < 0x10 )
-            operand( "#%02X", buf[1] );
+            operand( ctx, "#%02X", buf[1] );
         else
-            operand( "R%02X", buf[1] );
+            operand( ctx, "R%02X", buf[1] );
     }
     else
-        operand( "R%02X", buf[1] );
+        operand( ctx, "R%02X", buf[1] );
 }
 
 /***********************************************************
@@ -500,7 +502,7 @@ static void do_00( int addr, unsigned char *buf, int n )
  *
  ************************************************************/
 
-static void do_c0( int addr, unsigned char *buf, int n )
+static void do_c0( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     char *opcodes[] = { "st",       "bmov",     "st",       "st",
                         "stb",      "cmpl",     "stb",      "stb",
@@ -511,36 +513,36 @@ static void do_c0( int addr, unsigned char *buf, int n )
     {
         /* 80196 -- bmov */
         
-        operand( "bmov    R%02X, R%02X", buf[1], buf[2] );
+        operand( ctx, "bmov    R%02X, R%02X", buf[1], buf[2] );
     }
     else if ( buf[0] == 0xC5 )
     {
         /* 80196 -- cmpl */
         
-        operand( "cmpl    R%02X, R%02X", buf[1], buf[2] );        
+        operand( ctx, "cmpl    R%02X, R%02X", buf[1], buf[2] );        
     }
     else 
     {
-        operand( "%-6s  ", opcodes[buf[0] & 0x0F] );
+        operand( ctx, "%-6s  ", opcodes[buf[0] & 0x0F] );
         
         switch( buf[0] & 0x03 )
         {
             case ADDR_DIRECT:
                 if ( n == 3 )
-                    operand( "R%02X, ", buf[2] );
-                operand( "R%02X", buf[1] );
+                    operand( ctx, "R%02X, ", buf[2] );
+                operand( ctx, "R%02X", buf[1] );
                 break;
                 
             case ADDR_IMMED:    /* only PUSH words on to stack */
-                operand( "#%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, getAddress(&buf[1]) ) );
+                operand( ctx, "#%s", XREF_WORDADDR( FORMAT_NUM_16BIT, getAddress(&buf[1]) ) );
                 break;
                 
             case ADDR_INDIR:
                 if ( n == 3 )
-                    operand( "R%02X, ", buf[2] );
-                operand( "[R%02X]", buf[1] & 0xFE );
+                    operand( ctx, "R%02X, ", buf[2] );
+                operand( ctx, "[R%02X]", buf[1] & 0xFE );
                 if ( buf[1] & 0x01 )
-                    operand( "+" );
+                    operand( ctx, "+" );
                 break;
                 
             case ADDR_INDEX:
@@ -548,23 +550,23 @@ static void do_c0( int addr, unsigned char *buf, int n )
                 {
                     /* push/pop */
                     if ( n == 3 )
-                        operand( "%02X[R%02X]", buf[2], buf[1] & 0xFE );
+                        operand( ctx, "%02X[R%02X]", buf[2], buf[1] & 0xFE );
                     else
                     {
-                        operand( "%s[R%02X]", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, getAddress(&buf[2]) ), buf[1] & 0xFE );
-                        xref_addxref( X_PTR, addr - n, getAddress(&buf[2]) );
+                        operand( ctx, "%s[R%02X]", XREF_WORDADDR( FORMAT_NUM_16BIT, getAddress(&buf[2]) ), buf[1] & 0xFE );
+                        dasm_addxref( ctx, X_PTR, addr - n, getAddress(&buf[2]) );
                     }
                 }
                 else
                 {
                     /* st(b) */
                     if ( n == 4 )
-                        operand( "R%02X, %02X[R%02X]", buf[3], buf[2], buf[1] & 0xFE );
+                        operand( ctx, "R%02X, %02X[R%02X]", buf[3], buf[2], buf[1] & 0xFE );
                     else
                     {
-                        operand( "R%02X, %s[R%02X]", buf[4], xref_genwordaddr( NULL, FORMAT_NUM_16BIT, getAddress(&buf[2]) ),
+                        operand( ctx, "R%02X, %s[R%02X]", buf[4], XREF_WORDADDR( FORMAT_NUM_16BIT, getAddress(&buf[2]) ),
                                 buf[1] & 0xFE);
-                        xref_addxref( X_PTR, addr - n, getAddress(&buf[2]) );
+                        dasm_addxref( ctx, X_PTR, addr - n, getAddress(&buf[2]) );
                     }
                 }
                 break;
@@ -592,37 +594,40 @@ static void do_c0( int addr, unsigned char *buf, int n )
 #define OP_LJMP     0xE7
 #define OP_LCALL    0xEF
 
-static void do_e0( int addr, unsigned char *buf, int n )
+static void do_e0( dasm_ctx_t *ctx, int addr, unsigned char *buf, int n )
 {
     switch(buf[0])
     {
         case OP_DJNZ:
-            operand( "djnz    R%02X, %s", buf[1], xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
-            xref_addxref( X_JMP, addr - n, addr + (char)buf[2] );
+            operand( ctx, "djnz    R%02X, %s", buf[1], XREF_WORDADDR( FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
+            dasm_addxref( ctx, X_JMP, addr - n, addr + (char)buf[2] );
             break;
 
         case OP_DJNZW:
             /* 80196 */
-            operand( "djnzw   R%02X, %s", buf[1], xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
-            xref_addxref( X_JMP, addr - n, addr + (char)buf[2] );
+            operand( ctx, "djnzw   R%02X, %s", buf[1], XREF_WORDADDR( FORMAT_NUM_16BIT, addr + (char)buf[2] ) );
+            dasm_addxref( ctx, X_JMP, addr - n, addr + (char)buf[2] );
             break;
             
         case OP_BR:
-            operand( "br      [R%02X]", buf[1] );
+            operand( ctx, "br      [R%02X]", buf[1] );
+            ctx->flow_stop = 1;
             break;
             
         case OP_LJMP:
-            operand( "ljmp    %s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + getOffset(buf + 1) ) );
-            xref_addxref( X_JMP, addr - n, addr + getOffset(buf + 1) );
+            operand( ctx, "ljmp    %s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr + getOffset(buf + 1) ) );
+            dasm_addxref( ctx, X_JMP, addr - n, addr + getOffset(buf + 1) );
+            ctx->flow_stop = 1;
             break;
         
         case OP_LCALL:
-            operand( "lcall   %s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr + getOffset(buf + 1) ) );
-            xref_addxref( X_CALL, addr - n, addr + getOffset(buf + 1) );
+            operand( ctx, "lcall   %s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr + getOffset(buf + 1) ) );
+            dasm_addxref( ctx, X_CALL, addr - n, addr + getOffset(buf + 1) );
             break;
         
         default:
-            operand("???");
+            ctx->undefined = 1;
+            operand(ctx, "???");
     }
 }
 
@@ -637,12 +642,14 @@ static void do_e0( int addr, unsigned char *buf, int n )
  *
  * DESCRIPTION
  *      Disassembles the next instruction in the input stream.
+ *      With a NULL outbuf it only decodes: the length and
+ *       xrefs are worked out but no text is written.
  *
  * RETURNS
  *      address of next input byte
  *
  ************************************************************/
-ADDR dasm_insn( FILE *f, char * outbuf, ADDR addr )
+ADDR dasm_insn( dasm_ctx_t *ctx, char * outbuf, ADDR addr )
 {
 	int isSigned = 0;
 	int opc;
@@ -650,13 +657,16 @@ ADDR dasm_insn( FILE *f, char * outbuf, ADDR addr )
 	unsigned char buf[8];
 	int i;
 	
-	output_buffer = outbuf;
+	ctx->insn_addr = addr;
+	ctx->outbuf    = outbuf;
+	ctx->undefined = 0;
+	ctx->flow_stop = 0;
             
-   opc = next( f, &addr );
+   opc = next( ctx, &addr );
    if ( opc == 0xFE )
    {
       isSigned = 1;
-      opc = next( f, &addr );
+      opc = next( ctx, &addr );
    }
 
    n = instrlen[opc];
@@ -665,34 +675,35 @@ ADDR dasm_insn( FILE *f, char * outbuf, ADDR addr )
    if ( n < 0 )
    {
       n = -n;
-      buf[1] = next( f, &addr );
+      buf[1] = next( ctx, &addr );
       if ( buf[1] & 1 ) 
          n++;
       for ( i = 2; i < n; i++ )
-         buf[i] = next( f, &addr );
+         buf[i] = next( ctx, &addr );
    }
    else
       for ( i = 1; i < n; i++ )
-         buf[i] = next( f, &addr );
+         buf[i] = next( ctx, &addr );
 
    if ( n == 0 )
    {
       /* Unknown instruction */
-      operand( "???" );
+      ctx->undefined = 1;
+      operand( ctx, "???" );
    }
 	else
 	{
 
-            if      ( ( opc & 0xf8 ) == 0x20 )  do_sjmp   ( addr, buf, n );
-            else if ( ( opc & 0xf8 ) == 0x28 )  do_scall  ( addr, buf, n );
-            else if ( ( opc & 0xf8 ) == 0x30 )  do_jbc    ( addr, buf, n );
-            else if ( ( opc & 0xf8 ) == 0x38 )  do_jbs    ( addr, buf, n );
-            else if ( ( opc & 0xf0 ) == 0xd0 )  do_condjmp( addr, buf, n );
-            else if ( ( opc & 0xf0 ) == 0xf0 )  do_f0     ( addr, buf, n );
-            else if ( ( opc & 0xf0 ) == 0xe0 )  do_e0     ( addr, buf, n );
-            else if ( ( opc & 0xf0 ) == 0xc0 )  do_c0     ( addr, buf, n );
-            else if ( ( opc & 0xe0 ) == 0 )     do_00     ( addr, buf, n );
-            else                                do_middle ( addr, buf, n, isSigned );
+            if      ( ( opc & 0xf8 ) == 0x20 )  do_sjmp   ( ctx, addr, buf, n );
+            else if ( ( opc & 0xf8 ) == 0x28 )  do_scall  ( ctx, addr, buf, n );
+            else if ( ( opc & 0xf8 ) == 0x30 )  do_jbc    ( ctx, addr, buf, n );
+            else if ( ( opc & 0xf8 ) == 0x38 )  do_jbs    ( ctx, addr, buf, n );
+            else if ( ( opc & 0xf0 ) == 0xd0 )  do_condjmp( ctx, addr, buf, n );
+            else if ( ( opc & 0xf0 ) == 0xf0 )  do_f0     ( ctx, addr, buf, n );
+            else if ( ( opc & 0xf0 ) == 0xe0 )  do_e0     ( ctx, addr, buf, n );
+            else if ( ( opc & 0xf0 ) == 0xc0 )  do_c0     ( ctx, addr, buf, n );
+            else if ( ( opc & 0xe0 ) == 0 )     do_00     ( ctx, addr, buf, n );
+            else                                do_middle ( ctx, addr, buf, n, isSigned );
 	}
 
    return addr;
@@ -49,7 +49,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmavr", "Atmel AVR", 4, 9, 0, 2, 1 )
+DASM_PROFILE( "dasmavr", "Atmel AVR", 4, 9, 0, 2, 2, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -90,7 +90,7 @@ OPERAND_FUNC(rD5)
 {
     int Rd = ( opc >> 4 ) & 0x1F;
     
-    operand( FORMAT_REG, Rd );
+    operand( ctx, FORMAT_REG, Rd );
 }
 
 /***********************************************************
@@ -106,8 +106,8 @@ OPERAND_FUNC(bra7)
     BYTE disp = ((BYTE)(opc >> 2 )) / 2; /* SIGNED arithmetic! */
     ADDR dest = *addr + ( 2 * disp );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -123,8 +123,8 @@ OPERAND_FUNC(rel_k12)
     
     ADDR dest = *addr + ( k * 2 );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest ); 
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest ); 
 }
 
 /***********************************************************
@@ -134,12 +134,12 @@ OPERAND_FUNC(rel_k12)
  ************************************************************/
 OPERAND_FUNC(long_addr)
 {
-    ADDR dest = (ADDR)nextw( f, addr );
+    ADDR dest = (ADDR)nextw( ctx, addr );
     dest |= ( opc & 0x0001 ) << 16;
     dest |= ( opc & 0x01F0 ) << 13;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest ); 
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest ); 
 }
 
 /***********************************************************
@@ -151,7 +151,7 @@ OPERAND_FUNC(bit)
 {
     int s = ( opc >> 4 ) & 0x07;
     
-    operand( "%d", s );
+    operand( ctx, "%d", s );
 }
 
 /******************************************************************************/
@@ -169,9 +169,9 @@ OPERAND_FUNC(rpair_rpair)
     int Rd = ( ( opc >> 4 ) & 0x0F ) * 2;
     int Rr = ( opc & 0x0F ) * 2;
     
-    operand( FORMAT_REG ":" FORMAT_REG, Rd + 1, Rd );
+    operand( ctx, FORMAT_REG ":" FORMAT_REG, Rd + 1, Rd );
     COMMA;
-    operand( FORMAT_REG ":" FORMAT_REG, Rr + 1, Rr );
+    operand( ctx, FORMAT_REG ":" FORMAT_REG, Rr + 1, Rr );
 }
 
 /***********************************************************
@@ -185,9 +185,9 @@ OPERAND_FUNC(rhigh_rhigh)
     int Rd = ( ( opc >> 4 ) & 0x0F ) + 16;
     int Rr = ( opc & 0x0F ) + 16;
     
-    operand( FORMAT_REG, Rd );
+    operand( ctx, FORMAT_REG, Rd );
     COMMA;
-    operand( FORMAT_REG, Rr );
+    operand( ctx, FORMAT_REG, Rr );
 }
 
 /***********************************************************
@@ -201,9 +201,9 @@ OPERAND_FUNC(rhigh3_rhigh3)
     int Rd = ( ( opc >> 4 ) & 0x07 ) + 16;
     int Rr = ( opc & 0x07 ) + 16;
     
-    operand( FORMAT_REG, Rd );
+    operand( ctx, FORMAT_REG, Rd );
     COMMA;
-    operand( FORMAT_REG, Rr );
+    operand( ctx, FORMAT_REG, Rr );
 }
 
 /***********************************************************
@@ -216,9 +216,9 @@ OPERAND_FUNC(r_r)
 {
     int Rr = ( ( opc >> 5 ) & 0x10 ) | ( opc & 0x0F );
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
-    operand( FORMAT_REG, Rr );
+    operand( ctx, FORMAT_REG, Rr );
 }
 
 /***********************************************************
@@ -232,9 +232,9 @@ OPERAND_FUNC(rhigh_k8)
     int Rd = ( ( opc >> 4 ) & 0x0F ) + 16;
     int K  = ( ( opc >> 4 ) & 0xF0 ) | ( opc & 0x0F );
 
-    operand( FORMAT_REG, Rd );
+    operand( ctx, FORMAT_REG, Rd );
     COMMA;
-    operand( FORMAT_NUM_8BIT, K );
+    operand( ctx, FORMAT_NUM_8BIT, K );
 }
 
 /***********************************************************
@@ -249,11 +249,11 @@ OPERAND_FUNC(r_YZ)
     int A = opc & 0x0008;
     int Q = ( opc & 0x07 ) | ( ( opc >> 8 ) & 0x18 ) | ( ( opc >> 8 ) & 0x20 );
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
-    operand( A ? "Y" : "Z" );
+    operand( ctx, A ? "Y" : "Z" );
     if ( Q )
-        operand( "+%d", Q );
+        operand( ctx, "+%d", Q );
 }
 
 /***********************************************************
@@ -268,11 +268,11 @@ OPERAND_FUNC(YZ_r)
     int A = opc & 0x0008;
     int Q = ( opc & 0x07 ) | ( ( opc >> 8 ) & 0x18 ) | ( ( opc >> 8 ) & 0x20 );
     
-    operand( A ? "Y" : "Z" );
+    operand( ctx, A ? "Y" : "Z" );
     if ( Q )
-        operand( "+%d", Q );
+        operand( ctx, "+%d", Q );
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -285,9 +285,9 @@ OPERAND_FUNC(r_b)
 {
     int b = opc & 0x07;
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
-    operand( "%d", b );
+    operand( ctx, "%d", b );
 }
     
 /***********************************************************
@@ -301,9 +301,9 @@ OPERAND_FUNC(A_b)
     int A = ( opc >> 3 ) & 0x1F;
     int b = opc & 0x07;
     
-    operand( FORMAT_NUM_8BIT, A );
+    operand( ctx, FORMAT_NUM_8BIT, A );
     COMMA;
-    operand( "%d", b );
+    operand( ctx, "%d", b );
 }
 
 /***********************************************************
@@ -323,9 +323,9 @@ OPERAND_FUNC(rphigh_k6)
         "ZH:ZL"
     };
     
-    operand( "%s", rpair[R] );
+    operand( ctx, "%s", rpair[R] );
     COMMA;
-    operand( "%d", k );
+    operand( ctx, "%d", k );
 }
 
 /***********************************************************
@@ -338,10 +338,10 @@ OPERAND_FUNC(r_A6)
 {
     UBYTE A = ( opc & 0x0F ) | ( ( opc >> 5 ) & 0x30 );
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, A ) );
-    xref_addxref( xtype, g_insn_addr, A );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, A ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, A );
 }
 
 /***********************************************************
@@ -354,10 +354,10 @@ OPERAND_FUNC(A6_r)
 {
     UBYTE A = ( opc & 0x0F ) | ( ( opc >> 5 ) & 0x30 );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, A ) );
-    xref_addxref( xtype, g_insn_addr, A );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, A ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, A );
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -374,14 +374,14 @@ OPERAND_FUNC(r_Zpm)
         PREDEC  = 0x02
     } mode = opc & 0x03;
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
     switch ( mode )
     {
-    case STATIC:  operand(  "Z"  ); break;
-    case POSTINC: operand(  "Z+" ); break;
-    case PREDEC:  operand( "-Z"  ); break;
-    default:      operand( "???" ); break;
+    case STATIC:  operand(  ctx, "Z"  ); break;
+    case POSTINC: operand(  ctx, "Z+" ); break;
+    case PREDEC:  operand( ctx, "-Z"  ); break;
+    default:      operand( ctx, "???" ); break;
     }
 }
 
@@ -399,14 +399,14 @@ OPERAND_FUNC(r_Ypm)
         PREDEC  = 0x02
     } mode = opc & 0x03;
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
     switch ( mode )
     {
-    case STATIC:  operand(  "Y"  ); break;
-    case POSTINC: operand(  "Y+" ); break;
-    case PREDEC:  operand( "-Y"  ); break;
-    default:      operand( "???" ); break;
+    case STATIC:  operand(  ctx, "Y"  ); break;
+    case POSTINC: operand(  ctx, "Y+" ); break;
+    case PREDEC:  operand( ctx, "-Y"  ); break;
+    default:      operand( ctx, "???" ); break;
     }
 }
 
@@ -424,14 +424,14 @@ OPERAND_FUNC(r_Xpm)
         PREDEC  = 0x02
     } mode = opc & 0x03;
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
     switch ( mode )
     {
-    case STATIC:  operand(  "X"  ); break;
-    case POSTINC: operand(  "X+" ); break;
-    case PREDEC:  operand( "-X"  ); break;
-    default:      operand( "???" ); break;
+    case STATIC:  operand(  ctx, "X"  ); break;
+    case POSTINC: operand(  ctx, "X+" ); break;
+    case PREDEC:  operand( ctx, "-X"  ); break;
+    default:      operand( ctx, "???" ); break;
     }
 }
 
@@ -451,13 +451,13 @@ OPERAND_FUNC(Zpm_r)
     
     switch ( mode )
     {
-    case STATIC:  operand(  "Z"  ); break;
-    case POSTINC: operand(  "Z+" ); break;
-    case PREDEC:  operand( "-Z"  ); break;
-    default:      operand( "???" ); break;
+    case STATIC:  operand(  ctx, "Z"  ); break;
+    case POSTINC: operand(  ctx, "Z+" ); break;
+    case PREDEC:  operand( ctx, "-Z"  ); break;
+    default:      operand( ctx, "???" ); break;
     }
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -476,13 +476,13 @@ OPERAND_FUNC(Ypm_r)
     
     switch ( mode )
     {
-    case STATIC:  operand(  "Y"  ); break;
-    case POSTINC: operand(  "Y+" ); break;
-    case PREDEC:  operand( "-Y"  ); break;
-    default:      operand( "???" ); break;
+    case STATIC:  operand(  ctx, "Y"  ); break;
+    case POSTINC: operand(  ctx, "Y+" ); break;
+    case PREDEC:  operand( ctx, "-Y"  ); break;
+    default:      operand( ctx, "???" ); break;
     }
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -501,13 +501,13 @@ OPERAND_FUNC(Xpm_r)
     
     switch ( mode )
     {
-    case STATIC:  operand(  "X"  ); break;
-    case POSTINC: operand(  "X+" ); break;
-    case PREDEC:  operand( "-X"  ); break;
-    default:      operand( "???" ); break;
+    case STATIC:  operand(  ctx, "X"  ); break;
+    case POSTINC: operand(  ctx, "X+" ); break;
+    case PREDEC:  operand( ctx, "-X"  ); break;
+    default:      operand( ctx, "???" ); break;
     }
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -517,12 +517,12 @@ OPERAND_FUNC(Xpm_r)
  ************************************************************/
 OPERAND_FUNC(r_k16)
 {
-    ADDR dest = (ADDR)nextw( f, addr );
+    ADDR dest = (ADDR)nextw( ctx, addr );
     
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
     COMMA;
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest ); 
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest ); 
 }
 
 /***********************************************************
@@ -532,12 +532,12 @@ OPERAND_FUNC(r_k16)
  ************************************************************/
 OPERAND_FUNC(k16_r)
 {
-    ADDR dest = (ADDR)nextw( f, addr );
+    ADDR dest = (ADDR)nextw( ctx, addr );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest ); 
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest ); 
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /***********************************************************
@@ -548,9 +548,9 @@ OPERAND_FUNC(k16_r)
  ************************************************************/
 OPERAND_FUNC(Z_r)
 {
-    operand( "Z" );
+    operand( ctx, "Z" );
     COMMA;
-    operand_rD5( f, addr, opc, xtype );
+    operand_rD5( ctx, addr, opc, xtype );
 }
 
 /******************************************************************************/
@@ -701,11 +701,11 @@ optab_t base_optab[] = {
     INSN ( "CLT",    none,          0x94E8,         X_NONE )
     INSN ( "CLI",    none,          0x94F8,         X_NONE )
     
-    INSN ( "IJMP",   none,          0x9409,         X_NONE )
-    INSN ( "EIJMP",  none,          0x9419,         X_NONE )
-    INSN ( "RET",    none,          0x9508,         X_NONE )
+    INSN_STOP ( "IJMP",   none,          0x9409,         X_NONE )
+    INSN_STOP ( "EIJMP",  none,          0x9419,         X_NONE )
+    INSN_STOP ( "RET",    none,          0x9508,         X_NONE )
     INSN ( "ICALL",  none,          0x9509,         X_NONE )
-    INSN ( "RETI",   none,          0x9518,         X_NONE )
+    INSN_STOP ( "RETI",   none,          0x9518,         X_NONE )
     INSN ( "EICALL", none,          0x9519,         X_NONE )
     
     INSN ( "SLEEP",  none,          0x9588,         X_NONE )
@@ -713,7 +713,7 @@ optab_t base_optab[] = {
     INSN ( "WDR",    none,          0x95A8,         X_NONE )
     
     MASK ( "CALL",   long_addr,     0xFE0E, 0x940E, X_CALL )
-    MASK ( "JMP",    long_addr,     0xFE0E, 0x940C, X_JMP  )
+    MASK_STOP ( "JMP",    long_addr,     0xFE0E, 0x940C, X_JMP  )
     
     INSN ( "LPM",    none,          0x95C8,         X_NONE )
     INSN ( "ELPM",   none,          0x95D8,         X_NONE )
@@ -732,7 +732,7 @@ optab_t base_optab[] = {
     MASK ( "IN",     r_A6,          0xF800, 0xB000, X_NONE )
     MASK ( "OUT",    A6_r,          0xF800, 0xB800, X_NONE )
     
-    MASK ( "RJMP",   rel_k12,       0xF000, 0xC000, X_JMP  )
+    MASK_STOP ( "RJMP",   rel_k12,       0xF000, 0xC000, X_JMP  )
     MASK ( "RCALL",  rel_k12,       0xF000, 0xD000, X_CALL )
     
     MASK ( "LDI",    rhigh_k8,      0xF000, 0xE000, X_IMM )
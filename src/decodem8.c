@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmm8", "ST Micro STM8", 5, 7, 1, 1, 1 )
+DASM_PROFILE( "dasmm8", "ST Micro STM8", 5, 7, 1, 1, 1, 6, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -82,57 +82,57 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(A)
 {
-    operand( "A" );
+    operand( ctx, "A" );
 }
 
 OPERAND_FUNC(CC)
 {
-    operand( "CC" );
+    operand( ctx, "CC" );
 }
 
 OPERAND_FUNC(X)
 {
-    operand( "X" );
+    operand( ctx, "X" );
 }
 
 OPERAND_FUNC(indX)
 {
-    operand( "(X)" );
+    operand( ctx, "(X)" );
 }
 
 OPERAND_FUNC(XL)
 {
-    operand( "XL" );
+    operand( ctx, "XL" );
 }
 
 OPERAND_FUNC(XH)
 {
-    operand( "XH" );
+    operand( ctx, "XH" );
 }
 
 OPERAND_FUNC(Y)
 {
-    operand( "Y" );
+    operand( ctx, "Y" );
 }
 
 OPERAND_FUNC(indY)
 {
-    operand( "(Y)" );
+    operand( ctx, "(Y)" );
 }
 
 OPERAND_FUNC(YL)
 {
-    operand( "YL" );
+    operand( ctx, "YL" );
 }
 
 OPERAND_FUNC(YH)
 {
-    operand( "YH" );
+    operand( ctx, "YH" );
 }
 
 OPERAND_FUNC(SP)
 {
-    operand( "SP" );
+    operand( ctx, "SP" );
 }
 
 /******************************************************************************/
@@ -145,9 +145,9 @@ OPERAND_FUNC(SP)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
 
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -156,9 +156,9 @@ OPERAND_FUNC(imm8)
 
 OPERAND_FUNC(off8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
 
-    operand( FORMAT_NUM_8BIT, byte );
+    operand( ctx, FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -167,16 +167,16 @@ OPERAND_FUNC(off8)
 
 OPERAND_FUNC(imm16)
 {
-    UWORD word = nextw( f, addr );
+    UWORD word = nextw( ctx, addr );
 
-    operand( "#" FORMAT_NUM_16BIT, word );
+    operand( ctx, "#" FORMAT_NUM_16BIT, word );
 }
 
 OPERAND_FUNC(off16)
 {
-    UWORD word = nextw( f, addr );
+    UWORD word = nextw( ctx, addr );
 
-    operand( FORMAT_NUM_16BIT, word );
+    operand( ctx, FORMAT_NUM_16BIT, word );
 }
 
 /***********************************************************
@@ -185,26 +185,26 @@ OPERAND_FUNC(off16)
 
 OPERAND_FUNC(mem8)
 {
-    ADDR addr8 = (ADDR)next( f, addr );
+    ADDR addr8 = (ADDR)next( ctx, addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_8BIT, addr8 ) );
-    xref_addxref( xtype, g_insn_addr, addr8 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_8BIT, addr8 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr8 );
 }
 
 OPERAND_FUNC(ind8)
 {
-    operand( "[" );
-    operand_mem8( f, addr, opc, xtype );
-    operand( "]" );
+    operand( ctx, "[" );
+    operand_mem8( ctx, addr, opc, xtype );
+    operand( ctx, "]" );
 }
 
 OPERAND_FUNC(rel8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -213,17 +213,17 @@ OPERAND_FUNC(rel8)
 
 OPERAND_FUNC(mem16)
 {
-    ADDR addr16     = nextw( f, addr );
+    ADDR addr16     = nextw( ctx, addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr16 ) );
-    xref_addxref( xtype, g_insn_addr, addr16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr16 );
 }
 
 OPERAND_FUNC(ind16)
 {
-    operand( "[" );
-    operand_mem16( f, addr, opc, xtype );
-    operand( "]" );
+    operand( ctx, "[" );
+    operand_mem16( ctx, addr, opc, xtype );
+    operand( ctx, "]" );
 }
 
 /***********************************************************
@@ -232,25 +232,25 @@ OPERAND_FUNC(ind16)
 
 OPERAND_FUNC(mem24)
 {
-    UBYTE hi_addr  = next( f, addr );
-    UBYTE mid_addr = next( f, addr );
-    UBYTE lo_addr  = next( f, addr );
+    UBYTE hi_addr  = next( ctx, addr );
+    UBYTE mid_addr = next( ctx, addr );
+    UBYTE lo_addr  = next( ctx, addr );
     ADDR addr24    = MK_LONG_WORD( lo_addr, mid_addr, hi_addr );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_24BIT, addr24 ) );
-    xref_addxref( xtype, g_insn_addr, addr24 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_24BIT, addr24 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr24 );
 }
 
 OPERAND_FUNC(ind24)
 {
-    operand( "[" );
-    operand_mem24( f, addr, opc, xtype );
-    operand( "]" );
+    operand( ctx, "[" );
+    operand_mem24( ctx, addr, opc, xtype );
+    operand( ctx, "]" );
 }
 
 OPERAND_FUNC(off24)
 {
-    operand_mem24( f, addr, opc, xtype );
+    operand_mem24( ctx, addr, opc, xtype );
 }
 
 /******************************************************************************/
@@ -294,83 +294,83 @@ TWO_OPERAND(SP, imm8)
 
 OPERAND_FUNC(off8SP)
 {
-    operand( "(" );
-    operand_off8( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off8( ctx, addr, opc, xtype );
     COMMA;
-    operand_SP( f, addr, opc, xtype );
-    operand( ")" );
+    operand_SP( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(off8X)
 {
-    operand( "(" );
-    operand_off8( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off8( ctx, addr, opc, xtype );
     COMMA;
-    operand_X( f, addr, opc, xtype );
-    operand( ")" );
+    operand_X( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(off8Y)
 {
-    operand( "(" );
-    operand_off8( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off8( ctx, addr, opc, xtype );
     COMMA;
-    operand_Y( f, addr, opc, xtype );
-    operand( ")" );
+    operand_Y( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(off16X)
 {
-    operand( "(" );
-    operand_off16( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off16( ctx, addr, opc, xtype );
     COMMA;
-    operand_X( f, addr, opc, xtype );
-    operand( ")" );
+    operand_X( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(off16Y)
 {
-    operand( "(" );
-    operand_off16( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off16( ctx, addr, opc, xtype );
     COMMA;
-    operand_Y( f, addr, opc, xtype );
-    operand( ")" );
+    operand_Y( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(ind8X)
 {
-    operand( "(" );
-    operand_ind8( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_ind8( ctx, addr, opc, xtype );
     COMMA;
-    operand_X( f, addr, opc, xtype );
-    operand( ")" );
+    operand_X( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(ind8Y)
 {
-    operand( "(" );
-    operand_ind8( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_ind8( ctx, addr, opc, xtype );
     COMMA;
-    operand_Y( f, addr, opc, xtype );
-    operand( ")" );
+    operand_Y( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(ind16X)
 {
-    operand( "(" );
-    operand_ind16( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_ind16( ctx, addr, opc, xtype );
     COMMA;
-    operand_X( f, addr, opc, xtype );
-    operand( ")" );
+    operand_X( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(ind16Y)
 {
-    operand( "(" );
-    operand_ind16( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_ind16( ctx, addr, opc, xtype );
     COMMA;
-    operand_Y( f, addr, opc, xtype );
-    operand( ")" );
+    operand_Y( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 /* The STM8 does not store instruction operands in order so we need to
@@ -378,40 +378,40 @@ OPERAND_FUNC(ind16Y)
  */
 OPERAND_FUNC(mem16_bit)
 {
-    UBYTE pos = next( f, addr );
+    UBYTE pos = next( ctx, addr );
 
-    operand_mem16( f, addr, opc, xtype );
+    operand_mem16( ctx, addr, opc, xtype );
     COMMA;
-    operand( "#%d", (pos >> 1) & 0x07 );
+    operand( ctx, "#%d", (pos >> 1) & 0x07 );
 }
 
 OPERAND_FUNC(mem16_imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
 
-    operand_mem16( f, addr, opc, xtype );
+    operand_mem16( ctx, addr, opc, xtype );
     COMMA;
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 OPERAND_FUNC(mem8_mem8)
 {
-    ADDR src = (ADDR)next( f, addr );
+    ADDR src = (ADDR)next( ctx, addr );
 
-    operand_mem8( f, addr, opc, xtype );
+    operand_mem8( ctx, addr, opc, xtype );
     COMMA;
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_8BIT, src ) );
-    xref_addxref( xtype, g_insn_addr, src );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_8BIT, src ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, src );
 }
 
 OPERAND_FUNC(mem16_mem16)
 {
-    ADDR src = (ADDR)nextw( f, addr );
+    ADDR src = (ADDR)nextw( ctx, addr );
 
-    operand_mem16( f, addr, opc, xtype );
+    operand_mem16( ctx, addr, opc, xtype );
     COMMA;
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, src ) );
-    xref_addxref( xtype, g_insn_addr, src );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, src ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, src );
 }
 
 /* Extended addressing modes */
@@ -420,20 +420,20 @@ TWO_OPERAND_PAIR(A, mem24)
 
 OPERAND_FUNC(off24X)
 {
-    operand( "(" );
-    operand_off24( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off24( ctx, addr, opc, xtype );
     COMMA;
-    operand_X( f, addr, opc, xtype );
-    operand( ")" );
+    operand_X( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(off24Y)
 {
-    operand( "(" );
-    operand_off24( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_off24( ctx, addr, opc, xtype );
     COMMA;
-    operand_Y( f, addr, opc, xtype );
-    operand( ")" );
+    operand_Y( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 TWO_OPERAND_PAIR(A, ind24)
@@ -442,20 +442,20 @@ TWO_OPERAND_PAIR(A, off24Y)
 
 OPERAND_FUNC(ind24X)
 {
-    operand( "(" );
-    operand_ind24( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_ind24( ctx, addr, opc, xtype );
     COMMA;
-    operand_X( f, addr, opc, xtype );
-    operand( ")" );
+    operand_X( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 OPERAND_FUNC(ind24Y)
 {
-    operand( "(" );
-    operand_ind24( f, addr, opc, xtype );
+    operand( ctx, "(" );
+    operand_ind24( ctx, addr, opc, xtype );
     COMMA;
-    operand_Y( f, addr, opc, xtype );
-    operand( ")" );
+    operand_Y( ctx, addr, opc, xtype );
+    operand( ctx, ")" );
 }
 
 TWO_OPERAND_PAIR(A, ind24X)
@@ -554,8 +554,8 @@ optab_t x72_optab[] = {
     INSN ( "call",  ind16,   0xCD, X_CALL )
     INSN ( "call",  ind16X, 0xDD, X_CALL )
 
-    INSN ( "jp",    ind16,   0xCC, X_JMP  )
-    INSN ( "jp",    ind16X, 0xDC, X_JMP  )
+    INSN_STOP ( "jp",    ind16,   0xCC, X_JMP  )
+    INSN_STOP ( "jp",    ind16X, 0xDC, X_JMP  )
 
     INSN ( "wfe", none,       0x8F, X_NONE )
 
@@ -645,9 +645,9 @@ optab_t x90_optab[] = {
     INSN ( "call",  off8Y,   0xED, X_CALL )
     INSN ( "call",  off16Y,  0xDD, X_CALL )
 
-    INSN ( "jp",    indY,     0xFC, X_JMP  )
-    INSN ( "jp",    off8Y,   0xEC, X_JMP  )
-    INSN ( "jp",    off16Y,  0xDC, X_JMP  )
+    INSN_STOP ( "jp",    indY,     0xFC, X_JMP  )
+    INSN_STOP ( "jp",    off8Y,   0xEC, X_JMP  )
+    INSN_STOP ( "jp",    off16Y,  0xDC, X_JMP  )
 
     MASK ( "bcpl", mem16_bit, 0xF1, 0x10, X_PTR )
     MASK ( "bccm", mem16_bit, 0xF1, 0x11, X_PTR )
@@ -722,7 +722,7 @@ optab_t x91_optab[] = {
     BYTE_OPS
 
     INSN ( "c",     ind8Y,    0xDD, X_CALL )
-    INSN ( "jp",    ind8Y,    0xDC, X_JMP  )
+    INSN_STOP ( "jp",    ind8Y,    0xDC, X_JMP  )
 
     INSN ( "ldf",   A_ind24Y, 0xAF, X_PTR )
     INSN ( "ldf",   ind24Y_A, 0xA7, X_PTR )
@@ -766,9 +766,9 @@ optab_t x92_optab[] = {
     INSN ( "call",  ind8,     0xCD, X_CALL )
     INSN ( "call",  ind8X,    0xDD, X_CALL )
 
-    INSN ( "jpf",   ind16,    0xAC, X_JMP  )
-    INSN ( "jp",    ind8,     0xCC, X_JMP  )
-    INSN ( "jp",    ind8X,    0xDC, X_JMP  )
+    INSN_STOP ( "jpf",   ind16,    0xAC, X_JMP  )
+    INSN_STOP ( "jp",    ind8,     0xCC, X_JMP  )
+    INSN_STOP ( "jp",    ind8X,    0xDC, X_JMP  )
 
     INSN ( "ldf",   A_ind24X, 0xAF, X_PTR )
     INSN ( "ldf",   ind24X_A, 0xA7, X_PTR )
@@ -969,22 +969,22 @@ optab_t base_optab[] = {
     INSN ( "call",  off8X,   0xED, X_CALL )
     INSN ( "call",  off16X,  0xDD, X_CALL )
 
-    INSN ( "jp",    mem16,    0xCC, X_JMP  )
-    INSN ( "jp",    indX,     0xFC, X_JMP  )
-    INSN ( "jp",    off8X,   0xEC, X_JMP  )
-    INSN ( "jp",    off16X,  0xDC, X_JMP  )
+    INSN_STOP ( "jp",    mem16,    0xCC, X_JMP  )
+    INSN_STOP ( "jp",    indX,     0xFC, X_JMP  )
+    INSN_STOP ( "jp",    off8X,   0xEC, X_JMP  )
+    INSN_STOP ( "jp",    off16X,  0xDC, X_JMP  )
 
-    INSN ( "jpf",   mem24,    0xAC, X_JMP  )
-    INSN ( "jra",   rel8,     0x20, X_JMP  )
+    INSN_STOP ( "jpf",   mem24,    0xAC, X_JMP  )
+    INSN_STOP ( "jra",   rel8,     0x20, X_JMP  )
 
-    INSN ( "ret",   none,     0x81, X_NONE )
-    INSN ( "retf",  none,     0x87, X_NONE )
+    INSN_STOP ( "ret",   none,     0x81, X_NONE )
+    INSN_STOP ( "retf",  none,     0x87, X_NONE )
 
 /*----------------------------------------------------------------------------
   Conditional Branch
   ----------------------------------------------------------------------------*/
 
-    INSN ( "jrt",     rel8, 0x20, X_JMP )
+    INSN_STOP ( "jrt",     rel8, 0x20, X_JMP )
     INSN ( "jrf",     rel8, 0x21, X_JMP )
     INSN ( "jrugt",   rel8, 0x22, X_JMP )
     INSN ( "jrule",   rel8, 0x23, X_JMP )
@@ -1018,12 +1018,12 @@ optab_t base_optab[] = {
 
     INSN ( "break",   none, 0x8B, X_NONE )
     INSN ( "halt",    none, 0x8E, X_NONE )
-    INSN ( "iret",    none, 0x80, X_NONE )
+    INSN_STOP ( "iret",    none, 0x80, X_NONE )
     INSN ( "nop",     none, 0x9D, X_NONE )
     INSN ( "trap",    none, 0x83, X_NONE )
     INSN ( "wfi",     none, 0x8F, X_NONE )
 
-    INSN ( "int",    mem24, 0x82, X_JMP  )
+    INSN_STOP ( "int",    mem24, 0x82, X_JMP  )
 
     END
 };
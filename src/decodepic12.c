@@ -47,7 +47,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmpic12", "Microchip PIC10/PIC12", 4, 9, 0, 2, 1 )
+DASM_PROFILE( "dasmpic12", "Microchip PIC10/PIC12", 4, 9, 0, 2, 2, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -85,7 +85,7 @@ OPERAND_FUNC(f)
 {
     BYTE reg = opc & 0x001F;
     
-    operand( FORMAT_REG, reg );
+    operand( ctx, FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -98,7 +98,7 @@ OPERAND_FUNC(f3)
 {
     BYTE f3 = opc & 0x0007;
     
-    operand( FORMAT_REG, f3 );
+    operand( ctx, FORMAT_REG, f3 );
 }
 
 /***********************************************************
@@ -110,7 +110,7 @@ OPERAND_FUNC(imm8)
 {
     BYTE imm8 = opc & 0x00FF;
     
-    operand( FORMAT_NUM_8BIT, imm8 );
+    operand( ctx, FORMAT_NUM_8BIT, imm8 );
 }
 
 /***********************************************************
@@ -131,7 +131,7 @@ OPERAND_FUNC(addr8)
 {
     BYTE addr8 = opc & 0x00FF;
     
-    operand( FORMAT_NUM_8BIT, addr8 );
+    operand( ctx, FORMAT_NUM_8BIT, addr8 );
 }
 
 /***********************************************************
@@ -150,7 +150,7 @@ OPERAND_FUNC(addr9)
 {
     UWORD addr9 = opc & 0x01FF;
     
-    operand( FORMAT_NUM_16BIT, addr9 );
+    operand( ctx, FORMAT_NUM_16BIT, addr9 );
 }
 
 /******************************************************************************/
@@ -166,9 +166,9 @@ OPERAND_FUNC(f_d)
 {
     int d = ( ( opc >> 5 ) & 0x0001 );
     
-    operand_f( f, addr, opc, xtype );
+    operand_f( ctx, addr, opc, xtype );
     COMMA;
-    operand( FORMAT_REG, d );
+    operand( ctx, FORMAT_REG, d );
 }
 
 /***********************************************************
@@ -180,9 +180,9 @@ OPERAND_FUNC(f_b)
 {
     int b = ( ( opc >> 5 ) & 0x0007 );
     
-    operand_f( f, addr, opc, xtype );
+    operand_f( ctx, addr, opc, xtype );
     COMMA;
-    operand( FORMAT_REG, b );
+    operand( ctx, FORMAT_REG, b );
 }
 
 /******************************************************************************/
@@ -225,10 +225,10 @@ optab_t base_optab[] = {
         
     MASK ( "ANDLW",  imm8,          0x0F00, 0x0E00, X_NONE )
     MASK ( "CALL",   addr8,         0x0F00, 0x0900, X_NONE )
-    MASK ( "GOTO",   addr9,         0x0E00, 0x0A00, X_NONE )
+    MASK_STOP ( "GOTO",   addr9,         0x0E00, 0x0A00, X_NONE )
     MASK ( "IORLW",  imm8,          0x0F00, 0x0D00, X_NONE )
     MASK ( "MOVLW",  imm8,          0x0F00, 0x0C00, X_NONE )
-    MASK ( "RETLW",  imm8,          0x0F00, 0x0800, X_NONE )
+    MASK_STOP ( "RETLW",  imm8,          0x0F00, 0x0800, X_NONE )
     MASK ( "XORLW",  imm8,          0x0F00, 0x0F00, X_NONE )
     
     MASK ( "TRIS",   f3,            0x0FF8, 0x0000, X_NONE )
@@ -47,7 +47,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmpic16", "Microchip PIC16", 4, 9, 0, 2, 1 )
+DASM_PROFILE( "dasmpic16", "Microchip PIC16", 4, 9, 0, 2, 2, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -85,7 +85,7 @@ OPERAND_FUNC(f)
 {
     BYTE reg = opc & 0x003F;
     
-    operand( FORMAT_REG, reg );
+    operand( ctx, FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -97,7 +97,7 @@ OPERAND_FUNC(imm8)
 {
     BYTE imm8 = opc & 0x00FF;
     
-    operand( FORMAT_NUM_8BIT, imm8 );
+    operand( ctx, FORMAT_NUM_8BIT, imm8 );
 }
 
 /***********************************************************
@@ -109,8 +109,8 @@ OPERAND_FUNC(addr11)
 {
     UWORD addr11 = opc & 0x03FF;
     
-    operand( "%s", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr11 ) );
-    xref_addxref( xtype, g_insn_addr, addr11 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr11 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr11 );
 }
 
 /******************************************************************************/
@@ -126,9 +126,9 @@ OPERAND_FUNC(f_d)
 {
     int d = ( ( opc >> 7 ) & 0x0001 );
     
-    operand_f( f, addr, opc, xtype );
+    operand_f( ctx, addr, opc, xtype );
     COMMA;
-    operand( FORMAT_REG, d );
+    operand( ctx, FORMAT_REG, d );
 }
 
 /***********************************************************
@@ -140,9 +140,9 @@ OPERAND_FUNC(f_b)
 {
     int b = ( ( opc >> 7 ) & 0x0007 );
     
-    operand_f( f, addr, opc, xtype );
+    operand_f( ctx, addr, opc, xtype );
     COMMA;
-    operand( FORMAT_REG, b );
+    operand( ctx, FORMAT_REG, b );
 }
 
 /******************************************************************************/
@@ -187,18 +187,18 @@ optab_t base_optab[] = {
     MASK ( "ADDLW",  imm8,          0x3E00, 0x3E00, X_NONE )
     MASK ( "ANDLW",  imm8,          0x3F00, 0x3900, X_NONE )
     MASK ( "CALL",   addr11,        0x3800, 0x2000, X_NONE )
-    MASK ( "GOTO",   addr11,        0x3800, 0x2800, X_NONE )
+    MASK_STOP ( "GOTO",   addr11,        0x3800, 0x2800, X_NONE )
     MASK ( "IORLW",  imm8,          0x3F00, 0x3800, X_NONE )
     MASK ( "MOVLW",  imm8,          0x3C00, 0x3000, X_NONE )
-    MASK ( "RETLW",  imm8,          0x3C00, 0x3400, X_NONE )
+    MASK_STOP ( "RETLW",  imm8,          0x3C00, 0x3400, X_NONE )
     MASK ( "SUBLW",  imm8,          0x3E00, 0x3C00, X_NONE )
     MASK ( "XORLW",  imm8,          0x3F00, 0x3A00, X_NONE )
     
     INSN ( "CLRWDT", none,          0x0064,         X_NONE )
     INSN ( "OPTION", none,          0x0002,         X_NONE )
     INSN ( "SLEEP",  none,          0x0063,         X_NONE )
-    INSN ( "RETFIE", none,          0x0009,         X_NONE )
-    INSN ( "RETURN", none,          0x0008,         X_NONE )
+    INSN_STOP ( "RETFIE", none,          0x0009,         X_NONE )
+    INSN_STOP ( "RETURN", none,          0x0008,         X_NONE )
 
 /*----------------------------------------------------------------------------*/  
     
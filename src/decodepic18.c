@@ -47,7 +47,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmpic18", "Microchip PIC18", 4, 9, 0, 2, 1 )
+DASM_PROFILE( "dasmpic18", "Microchip PIC18", 4, 9, 0, 2, 2, 5, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -86,7 +86,7 @@ OPERAND_FUNC(f)
 {
     BYTE reg = opc & 0x00FF;
     
-    operand( FORMAT_REG, reg );
+    operand( ctx, FORMAT_REG, reg );
 }
 
 /***********************************************************
@@ -98,7 +98,7 @@ OPERAND_FUNC(imm4)
 {
     BYTE imm4 = opc & 0x000F;
     
-    operand( FORMAT_NUM_8BIT, imm4 );
+    operand( ctx, FORMAT_NUM_8BIT, imm4 );
 }
 
 /***********************************************************
@@ -110,7 +110,7 @@ OPERAND_FUNC(imm8)
 {
     BYTE imm8 = opc & 0x00FF;
     
-    operand( FORMAT_NUM_8BIT, imm8 );
+    operand( ctx, FORMAT_NUM_8BIT, imm8 );
 }
 
 /***********************************************************
@@ -122,7 +122,7 @@ OPERAND_FUNC(d)
 {
 	BYTE d = !!(opc & BIT(9));
 	
-	operand( d ? "F" : "W" );
+	operand( ctx, d ? "F" : "W" );
 }
 
 /***********************************************************
@@ -134,7 +134,7 @@ OPERAND_FUNC(a)
 {
 	BYTE a = !!(opc & BIT(8));
 	
-	operand( a ? "B" : "A" );
+	operand( ctx, a ? "B" : "A" );
 }
 
 /***********************************************************
@@ -146,7 +146,7 @@ OPERAND_FUNC(b)
 {
 	BYTE b = ( opc >> 9 ) & 0x07;
 	
-	operand( "%d", b );
+	operand( ctx, "%d", b );
 }
 
 /***********************************************************
@@ -158,7 +158,7 @@ OPERAND_FUNC(s0)
 {
 	BYTE s0 = opc & BIT(0);
 	
-	operand( "%d", !!s0 );
+	operand( ctx, "%d", !!s0 );
 }
 
 /***********************************************************
@@ -171,8 +171,8 @@ OPERAND_FUNC(rel8)
     BYTE disp = opc & 0xFF;
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -184,7 +184,7 @@ OPERAND_FUNC(fsr)
 {
 	BYTE fsr = ( opc >> 4 ) & 0x03;
 	
-	operand( "%d", fsr);
+	operand( ctx, "%d", fsr);
 }
 
 /***********************************************************
@@ -196,15 +196,15 @@ OPERAND_FUNC(fsr)
 OPERAND_FUNC(fs_fd)
 {
 	ADDR addr12 = opc & 0x0FFF;
-	operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr12 ) );
-    xref_addxref( xtype, g_insn_addr, addr12 );
+	operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr12 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr12 );
     
 	COMMA;
 
-	opc = nextw( f, addr );
+	opc = nextw( ctx, addr );
 	addr12 = opc & 0x0FFF;
-	operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, addr12 ) );
-    xref_addxref( xtype, g_insn_addr, addr12 );
+	operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, addr12 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, addr12 );
 }
 
 /***********************************************************
@@ -216,13 +216,13 @@ OPERAND_FUNC(fs_fd)
 OPERAND_FUNC(addr20)
 {
 	ADDR lo = opc & 0x00FF;
-	ADDR hi = nextw( f, addr );
+	ADDR hi = nextw( ctx, addr );
 	hi &= 0x0FFF;
 	hi <<= 8;
 	hi |= lo;
 	
-	operand( xref_genwordaddr( NULL, FORMAT_NUM_24BIT, hi ) );
-    xref_addxref( xtype, g_insn_addr, hi );
+	operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_24BIT, hi ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, hi );
 }
 
 /***********************************************************
@@ -235,15 +235,15 @@ OPERAND_FUNC(addr20_s8)
 {
 	ADDR lo = opc & 0x00FF;
 	BYTE s8 = !!(opc & BIT(8));
-	ADDR hi = nextw( f, addr );
+	ADDR hi = nextw( ctx, addr );
 	hi &= 0x0FFF;
 	hi <<= 8;
 	hi |= lo;
 	
-	operand( xref_genwordaddr( NULL, FORMAT_NUM_24BIT, hi ) );
-    xref_addxref( xtype, g_insn_addr, hi );
+	operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_24BIT, hi ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, hi );
     COMMA;
-    operand( "%d", !!s8 );
+    operand( ctx, "%d", !!s8 );
 }
 
 /***********************************************************
@@ -256,8 +256,8 @@ OPERAND_FUNC(rel11)
     WORD disp = opc & 0x3FF;
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -269,12 +269,12 @@ OPERAND_FUNC(rel11)
 OPERAND_FUNC(imm12)
 {
 	UWORD hi = opc & 0x000F;
-	UWORD lo = nextw( f, addr );
+	UWORD lo = nextw( ctx, addr );
 	lo &= 0x00FF;
 	hi <<= 8;
 	hi |= lo;
 	
-	operand( FORMAT_NUM_24BIT, hi );
+	operand( ctx, FORMAT_NUM_24BIT, hi );
 }
 
 /******************************************************************************/
@@ -345,12 +345,12 @@ optab_t base_optab[] = {
     MASK ( "BNZ",    rel8,          0xFF00, 0xE100, X_NONE )
     MASK ( "BOV",    rel8,          0xFF00, 0xE400, X_NONE )
     MASK ( "BZ",     rel8,          0xFF00, 0xE000, X_NONE )
-    MASK ( "BRA",    rel8,          0xF800, 0xD000, X_NONE )
+    MASK_STOP ( "BRA",    rel8,          0xF800, 0xD000, X_NONE )
     
     MASK ( "CALL",   addr20_s8,     0xFE00, 0xEC00, X_NONE )
     INSN ( "CLRWDT", none,          0x0004,         X_NONE )
     INSN ( "DAW",    none,          0x0007,         X_NONE )
-    MASK ( "GOTO",   addr20,        0xFF00, 0xEF00, X_NONE )
+    MASK_STOP ( "GOTO",   addr20,        0xFF00, 0xEF00, X_NONE )
     
     INSN ( "NOP",    none,          0x0000,         X_NONE )
     MASK ( "NOP",    none,          0xF000, 0xF000, X_NONE )
@@ -358,11 +358,11 @@ optab_t base_optab[] = {
     INSN ( "POP",    none,          0x0006,         X_NONE )
     INSN ( "PUSH",   none,          0x0005,         X_NONE )
     MASK ( "RCALL",  rel11,         0xF800, 0xD800, X_NONE )
-    INSN ( "RESET",  none,          0x00FF,         X_NONE )
+    INSN_STOP ( "RESET",  none,          0x00FF,         X_NONE )
     
-    MASK ( "RETFIE", s0,            0xFFFE, 0x0010, X_NONE )
-    MASK ( "RETLW",  imm8,          0xFF00, 0x0C00, X_NONE )
-    MASK ( "RETURN", s0,            0xFFFE, 0x0012, X_NONE )
+    MASK_STOP ( "RETFIE", s0,            0xFFFE, 0x0010, X_NONE )
+    MASK_STOP ( "RETLW",  imm8,          0xFF00, 0x0C00, X_NONE )
+    MASK_STOP ( "RETURN", s0,            0xFFFE, 0x0012, X_NONE )
      
     INSN ( "SLEEP",  none,          0x0003,         X_NONE )
     
@@ -375,7 +375,7 @@ optab_t base_optab[] = {
     MASK ( "MOVLB",  imm4,          0xFFF0, 0x0100, X_NONE )
     MASK ( "MOVLW",  imm8,          0xFF00, 0x0E00, X_NONE )
     MASK ( "MOVLW",  imm8,          0xFF00, 0x0E00, X_NONE )
-    MASK ( "RETLW",  imm8,          0xFF00, 0x0C00, X_NONE )
+    MASK_STOP ( "RETLW",  imm8,          0xFF00, 0x0C00, X_NONE )
     MASK ( "SUBLW",  imm8,          0xFF00, 0x0800, X_NONE )
     MASK ( "XORLW",  imm8,          0xFF00, 0x0A00, X_NONE )
     
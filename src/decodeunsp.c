@@ -16,7 +16,7 @@
 /* Note: u'nSP is not able to address individual bytes at all.
  * So dasm_word_width_bytes is set to 2, and only 16-bit words can be addressed.
  */
-DASM_PROFILE( "dasmunsp", "SunPlus µnSP", 4, 8, 0, 2, 2 )
+DASM_PROFILE( "dasmunsp", "SunPlus µnSP", 4, 8, 0, 2, 2, 6, 2 )
 
 const char* const regname[] = { "SP", "R1", "R2", "R3", "R4", "BP", "SR", "PC" };
 
@@ -33,20 +33,20 @@ OPERAND_FUNC(none)
 OPERAND_FUNC(int)
 {
 	const char* const intname[] = { "OFF", "IRQ", "FIQ", "IRQ,FIQ" };
-	operand( "%s", intname[OPB]);
+	operand( ctx, "%s", intname[OPB]);
 }
 
 OPERAND_FUNC(fir)
 {
 	const char* const intname[] = { "ON", "OFF" };
-	operand( "%s", intname[OPB & 1]);
+	operand( ctx, "%s", intname[OPB & 1]);
 }
 
 OPERAND_FUNC(call)
 {
-	int target = (IMM6 << 16) | nextw(f, addr);
+	int target = (IMM6 << 16) | nextw(ctx, addr);
 	char buf[32];
-	operand( "%s", xref_genwordaddr(buf, "%08x", target));
+	operand( ctx, "%s", xref_genwordaddr(buf, sizeof(buf), "%08x", target, ctx->insn_addr));
 }
 
 OPERAND_FUNC(jmp)
@@ -55,19 +55,19 @@ OPERAND_FUNC(jmp)
 	int off = IMM6;
 	char buf[32];
 	if (dir == 1) {
-		operand("%s", xref_genwordaddr(buf, "%04x", *addr / 2 - off));
+		operand(ctx, "%s", xref_genwordaddr(buf, sizeof(buf), "%04x", *addr / 2 - off, ctx->insn_addr));
 	} else if (dir == 0) {
-		operand("%s", xref_genwordaddr(buf, "%04x", *addr / 2 + off));
+		operand(ctx, "%s", xref_genwordaddr(buf, sizeof(buf), "%04x", *addr / 2 + off, ctx->insn_addr));
 	} else {
-		operand("?? unknown jump direction %d", dir);
+		operand(ctx, "?? unknown jump direction %d", dir);
 	}
 }
 
 OPERAND_FUNC(ljmp)
 {
 	char buf[32];
-	int word = nextw(f, addr);
-	operand("%s", xref_genwordaddr(buf, "%08x", word | (*addr / 2 & 0xFFFF0000)));
+	int word = nextw(ctx, addr);
+	operand(ctx, "%s", xref_genwordaddr(buf, sizeof(buf), "%08x", word | (*addr / 2 & 0xFFFF0000), ctx->insn_addr));
 }
 
 OPERAND_FUNC(pushset)
@@ -78,40 +78,40 @@ OPERAND_FUNC(pushset)
 	// 2     1 R2
 	// Rh to Rh-N, OPA encodes Rh
 	if ((OPA + 1) >= OPN)
-		operand("%s-%s", regname[OPA + 1 - OPN] , regname[OPA]);
+		operand(ctx, "%s-%s", regname[OPA + 1 - OPN] , regname[OPA]);
 	else
-		operand("INVALID");
+		operand(ctx, "INVALID");
 }
 
 OPERAND_FUNC(popset)
 {
 	// Rl to Rl+N, OPA encodes Rl-1
 	if ((OPA + 1) > 7 || (OPA + OPN) > 7)
-		operand("INVALID");
+		operand(ctx, "INVALID");
 	else
-		operand("%s-%s", regname[OPA + 1] , regname[OPA + OPN]);
+		operand(ctx, "%s-%s", regname[OPA + 1] , regname[OPA + OPN]);
 }
 
 OPERAND_FUNC(stack)
 {
-    operand( "[%s]", regname[OPB]);
+    operand( ctx, "[%s]", regname[OPB]);
 }
 
 OPERAND_FUNC(op1)
 {
-    operand( "%s", regname[OPA]);
+    operand( ctx, "%s", regname[OPA]);
 }
 
-bool op3 = false;
+/* ctx->state is set while decoding the third operand of op1_op3 */
 
 OPERAND_FUNC(op2)
 {
 	switch (OP1) {
 		case 0:
-			operand("[BP+%x]", IMM6);
+			operand(ctx, "[BP+%x]", IMM6);
 			break;
 		case 1:
-			operand("#%x", IMM6);
+			operand(ctx, "#%x", IMM6);
 			break;
 		case 3:
 		{
@@ -119,19 +119,19 @@ OPERAND_FUNC(op2)
 			int rs = OPB;
 			int word;
 			if (opn & 4)
-				operand("D:");
+				operand(ctx, "D:");
 			switch (opn & 3) {
 				case 0:
-					operand("[%s]", regname[rs]);
+					operand(ctx, "[%s]", regname[rs]);
 					break;
 				case 1:
-					operand("[%s--]", regname[rs]);
+					operand(ctx, "[%s--]", regname[rs]);
 					break;
 				case 2:
-					operand("[%s++]", regname[rs]);
+					operand(ctx, "[%s++]", regname[rs]);
 					break;
 				default:
-					operand("[++%s]", regname[rs]);
+					operand(ctx, "[++%s]", regname[rs]);
 					break;
 			}
 			break;
@@ -142,25 +142,25 @@ OPERAND_FUNC(op2)
 			int word;
 			switch (opn) {
 				case 0:
-					operand("%s", regname[OPB]);
+					operand(ctx, "%s", regname[OPB]);
 					break;
 				case 1:
-					if (op3) {
-						operand("%s, ", regname[OPB]);
+					if (ctx->state) {
+						operand(ctx, "%s, ", regname[OPB]);
 					}
-					word = nextw(f, addr);
-					operand("#%x", word);
+					word = nextw(ctx, addr);
+					operand(ctx, "#%x", word);
 					break;
 				case 2:
 				case 3: // only for ST
 				{
-					word = nextw(f, addr);
+					word = nextw(ctx, addr);
 					char buf[32];
-					operand("[%s]", xref_genwordaddr(buf, "%04x", word));
+					operand(ctx, "[%s]", xref_genwordaddr(buf, sizeof(buf), "%04x", word, ctx->insn_addr));
 					break;
 				}
 				default:
-					operand("%s ASR %d", regname[OPB], opn - 3);
+					operand(ctx, "%s ASR %d", regname[OPB], opn - 3);
 					break;
 			}
 			break;
@@ -169,36 +169,36 @@ OPERAND_FUNC(op2)
 		{
 			int opn = OPN;
 			if (opn >= 4)
-				operand("%s LSR %d", regname[OPB], opn - 3);
+				operand(ctx, "%s LSR %d", regname[OPB], opn - 3);
 			else
-				operand("%s LSL %d", regname[OPB], opn + 1);
+				operand(ctx, "%s LSL %d", regname[OPB], opn + 1);
 			break;
 		}
 		case 6:
 		{
 			int opn = OPN;
 			if (opn >= 4)
-				operand("%s ROR %d", regname[OPB], opn - 3);
+				operand(ctx, "%s ROR %d", regname[OPB], opn - 3);
 			else
-				operand("%s ROL %d", regname[OPB], opn + 1);
+				operand(ctx, "%s ROL %d", regname[OPB], opn + 1);
 			break;
 		}
 		default:
-			operand("?? unknown op1 %d", OP1);
+			operand(ctx, "?? unknown op1 %d", OP1);
 			break;
 	}
 }
 
 OPERAND_FUNC(op3)
 {
-	op3 = true;
-	operand_op2(f, addr, opc, xtype);
-	op3 = false;
+	ctx->state = true;
+	operand_op2(ctx, addr, opc, xtype);
+	ctx->state = false;
 }
 
 OPERAND_FUNC(mul)
 {
-	operand("%s, %s", regname[OPA], regname[OPB]);
+	operand(ctx, "%s, %s", regname[OPA], regname[OPB]);
 }
 
 OPERAND_FUNC(mac)
@@ -206,7 +206,7 @@ OPERAND_FUNC(mac)
 	int opn = OPN;
 	int op1 = OP1;
 	opn += (op1 & 1) << 3;
-	operand("%s, %s, %d", regname[OPA], regname[OPB], opn);
+	operand(ctx, "%s, %s, %d", regname[OPA], regname[OPB], opn);
 }
 
 TWO_OPERAND(op1, op2)
@@ -223,13 +223,13 @@ optab_t base_optab[] = {
 	MASK( "JMI", jmp,     0xFF80, 0x7E00, X_JMP)
 	MASK( "JA",  jmp,     0xFF80, 0x9E00, X_JMP)
 	MASK( "JG",  jmp,     0xFF80, 0xBE00, X_JMP)
-	MASK( "JMP", jmp,     0xFF80, 0xEE00, X_JMP)
+	MASK_STOP( "JMP", jmp,     0xFF80, 0xEE00, X_JMP)
 
-	INSN( "RETF", none, 0x9A90, X_NONE)
-	INSN( "RETI", none, 0x9A98, X_NONE)
+	INSN_STOP( "RETF", none, 0x9A90, X_NONE)
+	INSN_STOP( "RETI", none, 0x9A98, X_NONE)
 	MASK( "POP",  popset_stack, 0xF1C0, 0x9080, X_NONE)
 	MASK( "PUSH", pushset_stack, 0xF1C0, 0xD080, X_NONE)
-	INSN( "LJMP", ljmp, 0x9F0F, X_JMP)
+	INSN_STOP( "LJMP", ljmp, 0x9F0F, X_JMP)
 
 	// ALU ops
 	MASK( "ADD",  op1_op3, 0xF000, 0x0000, X_NONE)
@@ -249,7 +249,7 @@ optab_t base_optab[] = {
 	MASK( "INT",  int,  0xF1FC, 0xF140, X_NONE)
 	MASK( "FIR_MOV",  fir,  0xF1FE, 0xF144, X_NONE)
 	MASK( "CALL", call, 0xF1C0, 0xF040, X_CALL)
-	MASK( "GOTO", call, 0xFFC0, 0xFE80, X_CALL)
+	MASK_STOP( "GOTO", call, 0xFFC0, 0xFE80, X_CALL)
 	MASK( "MULU", mul,  0xF1F8, 0xF008, X_NONE)
 	MASK( "MULS", mul,  0xF1F8, 0xF108, X_NONE)
 	MASK( "MACU", mac,  0xF180, 0xF080, X_NONE)
@@ -42,7 +42,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmx86", "Intel x86", 5, 9, 0, 1, 1 )
+DASM_PROFILE( "dasmx86", "Intel x86", 5, 9, 0, 1, 1, 5, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -57,7 +57,7 @@ DASM_PROFILE( "dasmx86", "Intel x86", 5, 9, 0, 1, 1 )
 
 #define NOSEGPFX    ( 0 )
 #define EMIT_SEG_PFX \
-    if (segpfx) {operand("%s:", segreg[segpfx]); segpfx = NOSEGPFX;}
+    if (ctx->state) {operand(ctx, "%s:", segreg[ctx->state]); ctx->state = NOSEGPFX;}
 
 /*****************************************************************************
  * Private data.  Declare as static.
@@ -67,8 +67,6 @@ static const char * const segreg[5]  = { "", "ES", "CS", "SS", "DS" };
 static const char * const wordreg[8] = { "AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI" };
 static const char * const bytereg[8] = { "AL", "CL", "DL", "BL", "AH", "CH", "DH", "BH" };
 
-static int segpfx = NOSEGPFX;
-
 /*****************************************************************************
  *        Private Functions
  *****************************************************************************/
@@ -85,15 +83,16 @@ PREFIX_FUNC(pfx_seg)
 {
     int reg = (opc >> 3) & 0x03;
     
-    segpfx = reg + 1;
+    /* Segment prefix is held in the context until used */
+    ctx->state = reg + 1;
 }
 
 PREFIX_FUNC(pfx_rep)
 {
     if ( opc & 1 )
-        operand( "REP  " );
+        operand( ctx, "REP  " );
     else
-        operand( "REPZ " );    
+        operand( ctx, "REPZ " );    
 }
 
 /******************************************************************************/
@@ -112,7 +111,7 @@ OPERAND_FUNC(none)
 /* This operand just gobbles up the next byte with no effect */
 OPERAND_FUNC(gobble)
 {
-    UBYTE unused = next( f, addr );
+    UBYTE unused = next( ctx, addr );
 }
 
 /******************************************************************************/
@@ -121,7 +120,7 @@ OPERAND_FUNC(gobble)
 
 OPERAND_FUNC(dx)
 {
-    operand( "DX" );
+    operand( ctx, "DX" );
 }
 
 OPERAND_FUNC(reg)
@@ -129,102 +128,102 @@ OPERAND_FUNC(reg)
     int reg = opc & 0x07;
     int isword = opc & 0x08;
     
-    operand( (isword ? wordreg : bytereg)[reg] );
+    operand( ctx, (isword ? wordreg : bytereg)[reg] );
 }
 
 OPERAND_FUNC(reg16)
 {
     int reg = opc & 0x07;
     
-    operand( wordreg[reg] );
+    operand( ctx, wordreg[reg] );
 }
 
 OPERAND_FUNC(acc)
 {
     int wordop = opc & 1;
-    operand( wordop ? "AX" : "AL" );
+    operand( ctx, wordop ? "AX" : "AL" );
 }
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( FORMAT_NUM_8BIT, byte );
+    operand( ctx, FORMAT_NUM_8BIT, byte );
 }
 
 OPERAND_FUNC(port8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( FORMAT_NUM_8BIT, byte );
+    operand( ctx, FORMAT_NUM_8BIT, byte );
 }
 
 OPERAND_FUNC(disp8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 OPERAND_FUNC(imm16)
 {
-    UBYTE lsb   = next( f, addr );
-    UBYTE msb   = next( f, addr );
+    UBYTE lsb   = next( ctx, addr );
+    UBYTE msb   = next( ctx, addr );
     UWORD imm16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, imm16 ) );
-    xref_addxref( xtype, g_insn_addr, imm16 );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, imm16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, imm16 );
 }
 
 OPERAND_FUNC(addr16)
 {
-    UBYTE lsb = next( f, addr );
-    UBYTE msb = next( f, addr );
+    UBYTE lsb = next( ctx, addr );
+    UBYTE msb = next( ctx, addr );
     ADDR dest = MK_WORD( lsb, msb );
     
     EMIT_SEG_PFX;
-    operand( "%c[%s]", 
+    operand( ctx, "%c[%s]", 
         opc & 1 ? 'W' : 'B', 
-        xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+        XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 OPERAND_FUNC(disp16)
 {
-    UBYTE lsb = next( f, addr );
-    UBYTE msb = next( f, addr );
+    UBYTE lsb = next( ctx, addr );
+    UBYTE msb = next( ctx, addr );
     ADDR dest = *addr + MK_WORD( lsb, msb );
     
     EMIT_SEG_PFX;
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 OPERAND_FUNC(segoff)
 {
-    UBYTE offlo = next( f, addr );
-    UBYTE offhi = next( f, addr );
-    UBYTE seglo = next( f, addr );
-    UBYTE seghi = next( f, addr );
+    UBYTE offlo = next( ctx, addr );
+    UBYTE offhi = next( ctx, addr );
+    UBYTE seglo = next( ctx, addr );
+    UBYTE seghi = next( ctx, addr );
     
     ADDR offset = MK_WORD( offlo, offhi );
     ADDR segment = MK_WORD( seglo, seghi );
     
-    operand( FORMAT_NUM_16BIT ":" FORMAT_NUM_16BIT, segment, offset );    
+    operand( ctx, FORMAT_NUM_16BIT ":" FORMAT_NUM_16BIT, segment, offset );    
 }
 
 OPERAND_FUNC(segmreg)
 {
     UBYTE reg = ( opc >> 3 ) & 3;
     
-    operand( segreg[reg+1] );
+    operand( ctx, segreg[reg+1] );
 }
 
 OPERAND_FUNC(modrm)
 {
-    UBYTE arg  = next( f, addr );
+    UBYTE arg  = next( ctx, addr );
     int mod    = (arg >> 6) & 3;
     int reg    = (arg >> 3) & 7;
     int rm     = arg & 7;
@@ -282,9 +281,9 @@ OPERAND_FUNC(modrm)
         {
         case DO_REG:
             if ( isseg )
-                operand( segreg[reg+1] );
+                operand( ctx, segreg[reg+1] );
             else
-                operand( (wordop ? wordreg : bytereg)[reg] );
+                operand( ctx, (wordop ? wordreg : bytereg)[reg] );
             break;
                 
         case DO_ADDR:
@@ -295,22 +294,22 @@ OPERAND_FUNC(modrm)
                     EMIT_SEG_PFX;
                     if ( rm == 6 )
                     {
-                        UBYTE displo = next( f, addr );
-                        UBYTE disphi = next( f, addr );
+                        UBYTE displo = next( ctx, addr );
+                        UBYTE disphi = next( ctx, addr );
                         ADDR disp = MK_WORD( displo, disphi );
-                        operand( FORMAT_NUM_16BIT, disp );
+                        operand( ctx, FORMAT_NUM_16BIT, disp );
                     }
                     else
                     {
-                        operand( "%c[%s]", wordop ? 'W' : 'B', eareg[rm] );
+                        operand( ctx, "%c[%s]", wordop ? 'W' : 'B', eareg[rm] );
                     }                
                     break;
                     
                 case 1: /* MOD = 01, DISP is 8-bit sign-extended */
                 {
-                    BYTE disp = (BYTE)next( f, addr );
+                    BYTE disp = (BYTE)next( ctx, addr );
                     EMIT_SEG_PFX;
-                    operand( "%c[%s + " FORMAT_NUM_8BIT "]", 
+                    operand( ctx, "%c[%s + " FORMAT_NUM_8BIT "]", 
                         wordop ? 'W' : 'B',
                         eareg[rm], 
                         disp );
@@ -319,11 +318,11 @@ OPERAND_FUNC(modrm)
                     
                 case 2: /* MOD = 10, DISP is 16-bit signed */
                 {
-                    UBYTE displo = next( f, addr );
-                    UBYTE disphi = next( f, addr );
+                    UBYTE displo = next( ctx, addr );
+                    UBYTE disphi = next( ctx, addr );
                     ADDR disp = MK_WORD( displo, disphi );
                     EMIT_SEG_PFX;
-                    operand( "%c[%s + " FORMAT_NUM_16BIT "]", 
+                    operand( ctx, "%c[%s + " FORMAT_NUM_16BIT "]", 
                         wordop ? 'W' : 'B',
                         eareg[rm], 
                         disp );                
@@ -331,7 +330,7 @@ OPERAND_FUNC(modrm)
                 }
                     
                 case 3: /* MOD = 11, r/m is treated as reg field */
-                    operand( (wordop ? wordreg : bytereg)[rm] );                
+                    operand( ctx, (wordop ? wordreg : bytereg)[rm] );                
                     break;
             }
             break;
@@ -340,7 +339,7 @@ OPERAND_FUNC(modrm)
         if ( action == src )
             break;
         action = src;
-        operand( ", " );
+        operand( ctx, ", " );
     }
     while ( 1 );
 }
@@ -349,12 +348,12 @@ OPERAND_FUNC(modrmC)
 {
     UBYTE clreg = opc & 2;
     
-    operand_modrm( f, addr, opc, xtype );
+    operand_modrm( ctx, addr, opc, xtype );
     
     if ( clreg )
-        operand( ", CL" );
+        operand( ctx, ", CL" );
     else
-        operand( ", 1" );    
+        operand( ctx, ", 1" );    
 }
 
 OPERAND_FUNC(modrmimm)
@@ -362,8 +361,8 @@ OPERAND_FUNC(modrmimm)
     UBYTE datalo, datahi;
     UWORD imm16;
     
-    operand_modrm( f, addr, opc, xtype );
-    operand( ", " );
+    operand_modrm( ctx, addr, opc, xtype );
+    operand( ctx, ", " );
     
     /* Some variations do not support sign-extended immediates */
     if ( (opc & 0xFE) == 0xC6 || (opc & 0xFE) == 0xF6 )
@@ -372,21 +371,21 @@ OPERAND_FUNC(modrmimm)
     switch( opc & 3 )
     {
     case 0: /* s:w = 00 :: 8-bit immediate */
-        datalo = next( f, addr );
-        operand( FORMAT_NUM_8BIT, datalo );
+        datalo = next( ctx, addr );
+        operand( ctx, FORMAT_NUM_8BIT, datalo );
         break;
         
     case 1: /* s:w = 01 :: 16-bit immediate */
-        datalo = next( f, addr );
-        datahi = next( f, addr );
+        datalo = next( ctx, addr );
+        datahi = next( ctx, addr );
         imm16 = MK_WORD( datalo, datahi );
-        operand( FORMAT_NUM_16BIT, imm16 );
+        operand( ctx, FORMAT_NUM_16BIT, imm16 );
         break;
         
     case 3: /* s:w = 11 :: 8-bit sign-extended to 16-bit */
-        imm16 = next( f, addr );
+        imm16 = next( ctx, addr );
         if ( imm16 & 0x80 ) imm16 |= 0xFF00;
-        operand( FORMAT_NUM_16BIT, imm16 );
+        operand( ctx, FORMAT_NUM_16BIT, imm16 );
         break;
     }
 }
@@ -593,16 +592,16 @@ optab_t base_optab[] = {
     MASK2( "CALL", modrm, 0xFF, 0x38, 0x10, X_CALL )
     MASK2( "CALL", modrm, 0xFF, 0x38, 0x18, X_CALL )
   
-    INSN( "JMP",   disp8,  0xEB, X_JMP )
-    INSN( "JMP",   disp16, 0xE9, X_JMP )
-    INSN( "JMP",   segoff, 0xEA, X_JMP )
-    MASK2( "JMP",  modrm, 0xFF, 0x38, 0x20, X_JMP )
-    MASK2( "JMP",  modrm, 0xFF, 0x38, 0x28, X_JMP )
+    INSN_STOP( "JMP",   disp8,  0xEB, X_JMP )
+    INSN_STOP( "JMP",   disp16, 0xE9, X_JMP )
+    INSN_STOP( "JMP",   segoff, 0xEA, X_JMP )
+    MASK2_STOP( "JMP",  modrm, 0xFF, 0x38, 0x20, X_JMP )
+    MASK2_STOP( "JMP",  modrm, 0xFF, 0x38, 0x28, X_JMP )
   
-    INSN( "RETN",  none,   0xC3, X_NONE )
-    INSN( "RETN",  imm16,  0xC2, X_NONE )
-    INSN( "RETF",  none,   0xCB, X_NONE )
-    INSN( "RETF",  imm16,  0xCA, X_NONE )
+    INSN_STOP( "RETN",  none,   0xC3, X_NONE )
+    INSN_STOP( "RETN",  imm16,  0xC2, X_NONE )
+    INSN_STOP( "RETF",  none,   0xCB, X_NONE )
+    INSN_STOP( "RETF",  imm16,  0xCA, X_NONE )
   
     INSN( "JO",    disp8,  0x70, X_JMP )
     INSN( "JNO",   disp8,  0x71, X_JMP )
@@ -629,7 +628,7 @@ optab_t base_optab[] = {
     INSN( "INT",   imm8,   0xCD, X_NONE )
     INSN( "INT3",  none,   0xCC, X_NONE )
     INSN( "INTO",  none,   0xCE, X_NONE )
-    INSN( "IRET",  none,   0xCF, X_NONE )
+    INSN_STOP( "IRET",  none,   0xCF, X_NONE )
 
 /*----------------------------------------------------------------------------
   PROCESSOR CONTROL
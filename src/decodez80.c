@@ -46,7 +46,7 @@
  * Globally-visible decoder properties
  *****************************************************************************/
 
-DASM_PROFILE( "dasmz80", "Zilog Z80", 4, 9, 0, 1, 1 )
+DASM_PROFILE( "dasmz80", "Zilog Z80", 4, 9, 0, 1, 1, 4, 2 )
 
 /*****************************************************************************
  * Private data types, macros, constants.
@@ -82,158 +82,158 @@ OPERAND_FUNC(none)
 
 OPERAND_FUNC(a)
 {
-    operand( "A" );
+    operand( ctx, "A" );
 }
 
 OPERAND_FUNC(b)
 {
-    operand( "B" );
+    operand( ctx, "B" );
 }
 
 OPERAND_FUNC(c)
 {
-    operand( "C" );
+    operand( ctx, "C" );
 }
 
 OPERAND_FUNC(ind_c)
 {
-    operand( "(C)" );
+    operand( ctx, "(C)" );
 }
 
 OPERAND_FUNC(d)
 {
-    operand( "D" );
+    operand( ctx, "D" );
 }
 
 OPERAND_FUNC(e)
 {
-    operand( "E" );
+    operand( ctx, "E" );
 }
 
 OPERAND_FUNC(h)
 {
-    operand( "H" );
+    operand( ctx, "H" );
 }
 
 OPERAND_FUNC(l)
 {
-    operand( "L" );
+    operand( ctx, "L" );
 }
 
 OPERAND_FUNC(de)
 {
-    operand( "DE" );
+    operand( ctx, "DE" );
 }
 
 OPERAND_FUNC(hl)
 {
-    operand( "HL" );
+    operand( ctx, "HL" );
 }
 
 OPERAND_FUNC(ind_hl)
 {
-    operand( "(HL)" );
+    operand( ctx, "(HL)" );
 }
 
 OPERAND_FUNC(af)
 {
-    operand( "AF" );
+    operand( ctx, "AF" );
 }
 
 OPERAND_FUNC(afp)
 {
-    operand( "AF\'" );
+    operand( ctx, "AF\'" );
 }
 
 OPERAND_FUNC(sp)
 {
-    operand( "SP" );
+    operand( ctx, "SP" );
 }
 
 OPERAND_FUNC(indsp)
 {
-    operand( "(SP)" );
+    operand( ctx, "(SP)" );
 }
 
 OPERAND_FUNC(ix)
 {
-    operand( "IX" );
+    operand( ctx, "IX" );
 }
 
 OPERAND_FUNC(indix)
 {
-    operand( "(IX)" );
+    operand( ctx, "(IX)" );
 }
 
 OPERAND_FUNC(ixl)
 {
-    operand( "IXL" );
+    operand( ctx, "IXL" );
 }
 
 OPERAND_FUNC(ixh)
 {
-    operand( "IXH" );
+    operand( ctx, "IXH" );
 }
 
 OPERAND_FUNC(ixX)
 {
     if ( opc & 0x01 )
-        operand_ixl( f, addr, opc, xtype );
+        operand_ixl( ctx, addr, opc, xtype );
     else
-        operand_ixh( f, addr, opc, xtype );
+        operand_ixh( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(iy)
 {
-    operand( "IY" );
+    operand( ctx, "IY" );
 }
 
 OPERAND_FUNC(indiy)
 {
-    operand( "(IY)" );
+    operand( ctx, "(IY)" );
 }
 
 OPERAND_FUNC(iyl)
 {
-    operand( "IYL" );
+    operand( ctx, "IYL" );
 }
 
 OPERAND_FUNC(iyh)
 {
-    operand( "IYH" );
+    operand( ctx, "IYH" );
 }
 
 OPERAND_FUNC(iyX)
 {
     if ( opc & 0x01 )
-        operand_iyl( f, addr, opc, xtype );
+        operand_iyl( ctx, addr, opc, xtype );
     else
-        operand_iyh( f, addr, opc, xtype );
+        operand_iyh( ctx, addr, opc, xtype );
 }
 
 OPERAND_FUNC(i)
 {
-    operand( "I" );
+    operand( ctx, "I" );
 }
 
 OPERAND_FUNC(r)
 {
-    operand( "R" );
+    operand( ctx, "R" );
 }
 
 OPERAND_FUNC(0)
 {
-    operand( "0" );
+    operand( ctx, "0" );
 }
 
 OPERAND_FUNC(1)
 {
-    operand( "1" );
+    operand( ctx, "1" );
 }
 
 OPERAND_FUNC(2)
 {
-    operand( "2" );
+    operand( ctx, "2" );
 }
 
 /***********************************************************
@@ -243,9 +243,9 @@ OPERAND_FUNC(2)
 
 OPERAND_FUNC(imm8)
 {
-    UBYTE byte = next( f, addr );
+    UBYTE byte = next( ctx, addr );
     
-    operand( "#" FORMAT_NUM_8BIT, byte );
+    operand( ctx, "#" FORMAT_NUM_8BIT, byte );
 }
 
 /***********************************************************
@@ -254,12 +254,12 @@ OPERAND_FUNC(imm8)
 
 OPERAND_FUNC(imm16)
 {
-    UBYTE lsb   = next( f, addr );
-    UBYTE msb   = next( f, addr );
+    UBYTE lsb   = next( ctx, addr );
+    UBYTE msb   = next( ctx, addr );
     UWORD imm16 = MK_WORD( lsb, msb );
 
-    operand( xref_genwordaddr( NULL, "#" FORMAT_NUM_16BIT, imm16 ) );
-    xref_addxref( xtype, g_insn_addr, imm16 );
+    operand( ctx, "%s", XREF_WORDADDR( "#" FORMAT_NUM_16BIT, imm16 ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, imm16 );
 }
 
 /***********************************************************
@@ -271,7 +271,7 @@ OPERAND_FUNC(bit)
 {
     UBYTE bit = ( opc >> 3 ) & 0x07;
     
-    operand( "%d", bit );
+    operand( ctx, "%d", bit );
 }
 
 /***********************************************************
@@ -284,13 +284,13 @@ OPERAND_FUNC(reg)
     UBYTE reg = opc & 0x07;
     static char *rtab[] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" };
     
-    operand( "%s", rtab[reg] );
+    operand( ctx, "%s", rtab[reg] );
 }
 
 /* xxRRR_Rxxx */
 OPERAND_FUNC(reg2)
 {
-    operand_reg( f, addr, opc >> 3, xtype );
+    operand_reg( ctx, addr, opc >> 3, xtype );
 }
 
 /* xxRR_xxxx */
@@ -299,7 +299,7 @@ OPERAND_FUNC(rpair)
     UBYTE reg = ( opc >> 4 ) & 0x03;
     static char *rtab[] = { "BC", "DE", "HL", "SP" };
     
-    operand( "%s", rtab[reg] );
+    operand( ctx, "%s", rtab[reg] );
 }
 
 /* xxRR_xxxx */
@@ -308,7 +308,7 @@ OPERAND_FUNC(indrpair)
     UBYTE reg = ( opc >> 4 ) & 0x03;
     static char *rtab[] = { "BC", "DE", "HL", "SP" };
     
-    operand( "(%s)", rtab[reg] );
+    operand( ctx, "(%s)", rtab[reg] );
 }
 
 /***********************************************************
@@ -317,11 +317,11 @@ OPERAND_FUNC(indrpair)
 
 OPERAND_FUNC(rel8)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     ADDR dest = *addr + disp;
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -330,12 +330,12 @@ OPERAND_FUNC(rel8)
 
 OPERAND_FUNC(addr16)
 {
-    UBYTE lsb = next( f, addr );
-    UBYTE msb = next( f, addr );
+    UBYTE lsb = next( ctx, addr );
+    UBYTE msb = next( ctx, addr );
     ADDR dest = MK_WORD( lsb, msb );
     
-    operand( xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "%s", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 /***********************************************************
@@ -344,20 +344,20 @@ OPERAND_FUNC(addr16)
 
 OPERAND_FUNC(mem16)
 {
-    UBYTE lsb = next( f, addr );
-    UBYTE msb = next( f, addr );
+    UBYTE lsb = next( ctx, addr );
+    UBYTE msb = next( ctx, addr );
     ADDR dest = MK_WORD( lsb, msb );
     
-    operand( "(%s)", xref_genwordaddr( NULL, FORMAT_NUM_16BIT, dest ) );
-    xref_addxref( xtype, g_insn_addr, dest );
+    operand( ctx, "(%s)", XREF_WORDADDR( FORMAT_NUM_16BIT, dest ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, dest );
 }
 
 OPERAND_FUNC(mem8)
 {
-    UBYTE ioport = next( f, addr );
+    UBYTE ioport = next( ctx, addr );
     
-    operand( "(%s)", xref_genwordaddr( NULL, FORMAT_NUM_8BIT, ioport ) );
-    xref_addxref( xtype, g_insn_addr, ioport );
+    operand( ctx, "(%s)", XREF_WORDADDR( FORMAT_NUM_8BIT, ioport ) );
+    dasm_addxref( ctx, xtype, ctx->insn_addr, ioport );
 }
 
 /***********************************************************
@@ -370,7 +370,7 @@ OPERAND_FUNC(cond)
     UBYTE cond = ( opc >> 3 ) & 0x07;
     static char *ctab[] = { "NZ", "Z", "NC", "C", "PO", "PE", "P", "M" };
 
-    operand( "%s", ctab[cond] );
+    operand( ctx, "%s", ctab[cond] );
 }
 
 /***********************************************************
@@ -381,33 +381,33 @@ OPERAND_FUNC(rst)
 {
     UBYTE rst = ( opc & 0x30 ) | ( ( opc & 0x0F ) == 0x0F ? 0x08 : 0x00 );
     
-    operand( FORMAT_NUM_8BIT, rst );
+    operand( ctx, FORMAT_NUM_8BIT, rst );
 }
 
 /***********************************************************
  * Process IX/IY plus offset operands (IX + DISP)
  ************************************************************/
  
-static void z80_emit_signed_index_offset( const char *idx, BYTE disp )
+static void z80_emit_signed_index_offset( dasm_ctx_t *ctx, const char *idx, BYTE disp )
 {
     if ( disp < 0 )
-    	operand( "(%s-" FORMAT_NUM_8BIT ")", idx, -disp );
+    	operand( ctx, "(%s-" FORMAT_NUM_8BIT ")", idx, -disp );
     else
-    	operand( "(%s+" FORMAT_NUM_8BIT ")", idx, disp );
+    	operand( ctx, "(%s+" FORMAT_NUM_8BIT ")", idx, disp );
 }
 
 OPERAND_FUNC(ixoff)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     
-    z80_emit_signed_index_offset( "IX", disp );
+    z80_emit_signed_index_offset( ctx, "IX", disp );
 }
 
 OPERAND_FUNC(iyoff)
 {
-    BYTE disp = (BYTE)next( f, addr );
+    BYTE disp = (BYTE)next( ctx, addr );
     
-    z80_emit_signed_index_offset( "IY", disp );
+    z80_emit_signed_index_offset( ctx, "IY", disp );
 }
 
 /***********************************************************
@@ -417,16 +417,16 @@ OPERAND_FUNC(iyoff)
 
 OPERAND_FUNC(ixoffS)
 {
-    BYTE disp = (BYTE)stack_pop();
+    BYTE disp = (BYTE)stack_pop( ctx );
 
-    z80_emit_signed_index_offset( "IX", disp );    
+    z80_emit_signed_index_offset( ctx, "IX", disp );    
 }
 
 OPERAND_FUNC(iyoffS)
 {
-    BYTE disp = (BYTE)stack_pop();
+    BYTE disp = (BYTE)stack_pop( ctx );
 
-    z80_emit_signed_index_offset( "IY", disp );    
+    z80_emit_signed_index_offset( ctx, "IY", disp );    
 }
 
 /******************************************************************************/
@@ -513,16 +513,16 @@ TWO_OPERAND(indsp, iy)
 
 OPERAND_FUNC(rD_rS)
 {
-    operand_reg( f, addr, opc >> 3, xtype );
+    operand_reg( ctx, addr, opc >> 3, xtype );
     COMMA;
-    operand_reg( f, addr, opc, xtype );    
+    operand_reg( ctx, addr, opc, xtype );    
 }
 
 OPERAND_FUNC(condalt_rel8)
 {
-   operand_cond( f, addr, opc & ~0x20, xtype );
+   operand_cond( ctx, addr, opc & ~0x20, xtype );
    COMMA;
-   operand_rel8( f, addr, opc, xtype );
+   operand_rel8( ctx, addr, opc, xtype );
 }
 
 /******************************************************************************/
@@ -592,8 +592,8 @@ optab_t pageEXTD[] = {
     INSN ( "OTDR", none, 0xBB, X_NONE )
     
     /* Order is important! */
-    INSN ( "RETI", none, 0x4D, X_NONE )
-    INSN ( "RETN", none, 0x45, X_NONE )
+    INSN_STOP ( "RETI", none, 0x4D, X_NONE )
+    INSN_STOP ( "RETN", none, 0x45, X_NONE )
     
     MASK ( "LD",   mem16_rpair, 0xCF, 0x43, X_PTR )
     MASK ( "LD",   rpair_mem16, 0xCF, 0x4B, X_PTR )
@@ -697,7 +697,7 @@ optab_t pageIX[] = {
     INSN ( "OR",   a_ixoff,  0xB6, X_REG )
     INSN ( "CP",   a_ixoff,  0xBE, X_REG )
     
-    INSN ( "JP",   indix,    0xE9, X_REG )    
+    INSN_STOP ( "JP",   indix,    0xE9, X_REG )    
 
     PUSHTBL ( pageIXBITS,    0xCB, 1 )
     
@@ -765,7 +765,7 @@ optab_t pageIY[] = {
     INSN ( "OR",   a_iyoff,  0xB6, X_REG )
     INSN ( "CP",   a_iyoff,  0xBE, X_REG )
     
-    INSN ( "JP",   indiy,    0xE9, X_REG ) 
+    INSN_STOP ( "JP",   indiy,    0xE9, X_REG ) 
     
     PUSHTBL ( pageIYBITS, 0xCB, 1 )
     
@@ -858,19 +858,19 @@ optab_t base_optab[] = {
   Branch
   ----------------------------------------------------------------------------*/
     
-    INSN ( "RET",  none,        0xC9,       X_NONE )
+    INSN_STOP ( "RET",  none,        0xC9,       X_NONE )
     MASK ( "RET",  cond,        0xC7, 0xC0, X_NONE )
     
     INSN ( "DJNZ", rel8,        0x10,       X_JMP )
     
-    INSN ( "JP",   addr16,      0xC3,       X_JMP )
+    INSN_STOP ( "JP",   addr16,      0xC3,       X_JMP )
     MASK ( "JP",   cond_addr16, 0xC7, 0xC2, X_JMP )
-    INSN ( "JP",   indrpair,    0xE9,       X_REG )
+    INSN_STOP ( "JP",   indrpair,    0xE9,       X_REG )
     
     INSN ( "CALL", addr16,      0xCD,       X_CALL )
     MASK ( "CALL", cond_addr16, 0xC7, 0xC4, X_CALL )
 
-    INSN ( "JR",   rel8,        0x18,       X_JMP )
+    INSN_STOP ( "JR",   rel8,        0x18,       X_JMP )
     MASK ( "JR",   condalt_rel8, 0xE7, 0x20, X_JMP )
     
 /*----------------------------------------------------------------------------
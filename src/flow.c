@@ -0,0 +1,562 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Code discovery
+ *
+ * Starting from a set of root addresses the decoders are run forward,
+ *  instruction by instruction, marking every byte they consume as code.
+ *  The X_JMP and X_CALL xrefs recorded by the operand functions give the
+ *  flow targets, which are queued as further roots.  A sweep ends at an
+ *  instruction the decoder marks as a flow stop (unconditional jumps,
+ *  returns), at an undefined opcode, or on reaching bytes that are
+ *  already code or are marked as data.  The instructions are decoded
+ *  without formatting their text.
+ *
+ * The walks can run on a pool of threads.  Each thread has its own work
+ *  list, pushing and popping the roots it finds at the bottom, and takes
+ *  work from the top of another thread's list when its own runs dry.
+ *  Threads claim an instruction address by atomically setting its bit in
+ *  the visited bitmap, so each address is decoded once however many walks
+ *  reach it, and a walk ends where it meets another.  The map is only
+ *  read and written with atomic operations while the threads run.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Data Types, Macros, Constants
+ *****************************************************************************/
+
+#define FLOW_MAX_TARGETS    ( 8 )
+#define FLOW_WORK_INIT      ( 256 )
+
+/* Bits in each word of the visited bitmap */
+#define FLOW_BITS           ( 8 * sizeof( unsigned long ) )
+
+/* Sets flags in a map byte that other threads may be updating */
+#define FLOW_MARK(M_p, M_f) __atomic_fetch_or( (M_p), (M_f), __ATOMIC_RELAXED )
+
+/* Flow targets recorded while decoding one instruction */
+struct flow_insn {
+    ADDR     target[FLOW_MAX_TARGETS];
+    int      is_call[FLOW_MAX_TARGETS];
+    int      ntargets;
+};
+
+/* A thread's work list.  The owner uses the bottom, thieves the top. */
+struct flow_deque {
+    pthread_mutex_t   lock;
+    ADDR            * item;
+    size_t            top;
+    size_t            bottom;
+    size_t            size;
+};
+
+struct flow_pool;
+
+/* Per-thread exploration state */
+struct flow_worker {
+    struct flow_pool  * pool;
+    int                 index;
+    struct flow_deque   deque;
+    dasm_ctx_t          ctx;
+    struct flow_insn    fi;
+    size_t              ninsns;
+};
+
+/* State shared by all of the threads */
+struct flow_pool {
+    flow_t             * flow;
+    struct flow_worker * workers;
+    int                  nworkers;
+    size_t               pending;   /* Roots queued or being explored */
+};
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_addxref
+ *
+ * DESCRIPTION
+ *      Xref sink used while exploring.  Keeps the jump and
+ *       call targets of the current instruction.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void flow_addxref( void *arg, XREF_TYPE type, ADDR addr, ADDR ref )
+{
+    struct flow_insn *fi = arg;
+
+    if ( ( type == X_JMP || type == X_CALL ) && fi->ntargets < FLOW_MAX_TARGETS )
+    {
+        fi->target[fi->ntargets]  = ref;
+        fi->is_call[fi->ntargets] = ( type == X_CALL );
+        fi->ntargets++;
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_claim
+ *
+ * DESCRIPTION
+ *      Marks an address as visited.  Only one thread can
+ *       claim each address.
+ *
+ * RETURNS
+ *      non-zero if this call claimed the address
+ *
+ ************************************************************/
+
+static int flow_claim( flow_t *flow, size_t offset )
+{
+    unsigned long *word = &flow->visited[offset / FLOW_BITS];
+    unsigned long  bit  = 1UL << ( offset % FLOW_BITS );
+
+    if ( __atomic_load_n( word, __ATOMIC_RELAXED ) & bit )
+        return 0;
+
+    return !( __atomic_fetch_or( word, bit, __ATOMIC_RELAXED ) & bit );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_wanted
+ *
+ * DESCRIPTION
+ *      Checks whether an address is still worth exploring.
+ *
+ * RETURNS
+ *      non-zero if the address is in the map, not data and
+ *       not yet visited
+ *
+ ************************************************************/
+
+static int flow_wanted( flow_t *flow, ADDR addr )
+{
+    size_t offset = (size_t)( addr - flow->base );
+
+    if ( addr < flow->base || offset >= flow->length )
+        return 0;
+    if ( FLOW_FLAGS( &flow->map[offset] ) & FLOW_DATA )
+        return 0;
+
+    return !( __atomic_load_n( &flow->visited[offset / FLOW_BITS], __ATOMIC_RELAXED )
+              & ( 1UL << ( offset % FLOW_BITS ) ) );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      deque_push
+ *
+ * DESCRIPTION
+ *      Adds an address to the bottom of a work list.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void deque_push( struct flow_deque *dq, ADDR addr )
+{
+    pthread_mutex_lock( &dq->lock );
+
+    if ( dq->bottom == dq->size )
+    {
+        if ( dq->top > dq->size / 2 )
+        {
+            memmove( dq->item, dq->item + dq->top,
+                     ( dq->bottom - dq->top ) * sizeof( ADDR ) );
+            dq->bottom -= dq->top;
+            dq->top     = 0;
+        }
+        else
+        {
+            dq->size = dq->size ? dq->size * 2 : FLOW_WORK_INIT;
+            dq->item = realloc( dq->item, dq->size * sizeof( ADDR ) );
+            if ( !dq->item )
+                error( "Out of memory" );
+        }
+    }
+    dq->item[dq->bottom++] = addr;
+
+    pthread_mutex_unlock( &dq->lock );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      deque_take
+ *
+ * DESCRIPTION
+ *      Takes an address from the bottom of a work list for
+ *       its owner, or from the top for a thief.
+ *
+ * RETURNS
+ *      non-zero if an address was taken
+ *
+ ************************************************************/
+
+static int deque_take( struct flow_deque *dq, int steal, ADDR *addr )
+{
+    int found = 0;
+
+    pthread_mutex_lock( &dq->lock );
+
+    if ( dq->top < dq->bottom )
+    {
+        *addr = steal ? dq->item[dq->top++] : dq->item[--dq->bottom];
+        if ( dq->top == dq->bottom )
+            dq->top = dq->bottom = 0;
+        found = 1;
+    }
+
+    pthread_mutex_unlock( &dq->lock );
+
+    return found;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_push
+ *
+ * DESCRIPTION
+ *      Queues a flow target on a thread's own work list.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void flow_push( struct flow_worker *w, ADDR addr )
+{
+    if ( !flow_wanted( w->pool->flow, addr ) )
+        return;
+
+    __atomic_add_fetch( &w->pool->pending, 1, __ATOMIC_ACQ_REL );
+    deque_push( &w->deque, addr );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_sweep
+ *
+ * DESCRIPTION
+ *      Decodes forward from addr until the flow stops,
+ *       marking each instruction as code and queueing the
+ *       targets it refers to.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+static void flow_sweep( struct flow_worker *w, ADDR addr )
+{
+    flow_t *flow = w->pool->flow;
+    dasm_ctx_t *ctx = &w->ctx;
+    struct flow_insn *fi = &w->fi;
+
+    ctx->tos   = -1;
+    ctx->state = 0;
+
+    for ( ;; )
+    {
+        size_t offset = (size_t)( addr - flow->base );
+        size_t i, len;
+        ADDR next;
+
+        if ( addr < flow->base || offset >= flow->length )
+            return;
+        if ( ( FLOW_FLAGS( &flow->map[offset] ) & FLOW_DATA )
+             || !flow_claim( flow, offset ) )
+            return;
+
+        image_seek( ctx, addr );
+        ctx->eof      = 0;
+        ctx->insn_len = 0;
+        fi->ntargets  = 0;
+
+        next = dasm_insn( ctx, NULL, addr );
+
+        /* An insn running past the end of the map is not code */
+        if ( ctx->eof || ctx->undefined
+             || (size_t)( next - flow->base ) > flow->length )
+            return;
+
+        len = (size_t)( next - addr );
+        for ( i = 0; i < len && offset + i < flow->length; i++ )
+            FLOW_MARK( &flow->map[offset + i], FLOW_CODE );
+        FLOW_MARK( &flow->map[offset], FLOW_INSN );
+        w->ninsns++;
+
+        for ( i = 0; i < (size_t)fi->ntargets; i++ )
+        {
+            ADDR target = fi->target[i];
+
+            if ( fi->is_call[i] && target >= flow->base
+                 && (size_t)( target - flow->base ) < flow->length )
+                FLOW_MARK( &flow->map[target - flow->base], FLOW_CALL );
+            flow_push( w, target );
+        }
+
+        if ( ctx->flow_stop )
+            return;
+
+        addr = next;
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_worker
+ *
+ * DESCRIPTION
+ *      Thread body.  Explores roots from its own work list,
+ *       stealing from the other threads when that is empty,
+ *       until no roots are left anywhere.
+ *
+ * RETURNS
+ *      NULL
+ *
+ ************************************************************/
+
+static void *flow_worker( void *arg )
+{
+    struct flow_worker *w = arg;
+    struct flow_pool *pool = w->pool;
+    ADDR addr;
+    int i, found;
+
+    for ( ;; )
+    {
+        found = deque_take( &w->deque, 0, &addr );
+
+        for ( i = 1; !found && i < pool->nworkers; i++ )
+            found = deque_take( &pool->workers[( w->index + i ) % pool->nworkers].deque,
+                                1, &addr );
+
+        if ( found )
+        {
+            flow_sweep( w, addr );
+            __atomic_sub_fetch( &pool->pending, 1, __ATOMIC_ACQ_REL );
+        }
+        else if ( __atomic_load_n( &pool->pending, __ATOMIC_ACQUIRE ) == 0 )
+            break;
+        else
+            sched_yield();
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_init
+ *
+ * DESCRIPTION
+ *      Sets up discovery over length bytes of the input
+ *       image, the first of which is at address base.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+void flow_init( flow_t *flow, ADDR base, size_t length )
+{
+    memset( flow, 0, sizeof( *flow ) );
+
+    flow->base      = base;
+    flow->length    = length;
+    flow->map       = zalloc( length ? length : 1 );
+    flow->visited   = zalloc( ( length / FLOW_BITS + 1 ) * sizeof( unsigned long ) );
+    flow->work_size = FLOW_WORK_INIT;
+    flow->work      = zalloc( flow->work_size * sizeof( ADDR ) );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_free
+ *
+ * DESCRIPTION
+ *      Releases the memory held by the discovery state.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+void flow_free( flow_t *flow )
+{
+    free( flow->map );
+    free( flow->visited );
+    free( flow->work );
+    flow->map     = NULL;
+    flow->visited = NULL;
+    flow->work    = NULL;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_add_root
+ *
+ * DESCRIPTION
+ *      Queues an address to be explored.  Addresses outside
+ *       the map, in data or already visited are dropped.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+void flow_add_root( flow_t *flow, ADDR addr )
+{
+    if ( !flow_wanted( flow, addr ) )
+        return;
+
+    if ( flow->nwork == flow->work_size )
+    {
+        flow->work_size *= 2;
+        flow->work = realloc( flow->work, flow->work_size * sizeof( ADDR ) );
+        if ( !flow->work )
+            error( "Out of memory" );
+    }
+
+    flow->work[flow->nwork++] = addr;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      flow_run
+ *
+ * DESCRIPTION
+ *      Explores from every queued root until no more code
+ *       can be reached, using the given number of threads.
+ *      The roots are dealt out to the threads' work lists in
+ *       turn.
+ *
+ * RETURNS
+ *      nothing
+ *
+ ************************************************************/
+
+void flow_run( flow_t *flow, int jobs )
+{
+    struct flow_pool pool;
+    pthread_t *threads;
+    size_t k;
+    int i;
+
+    if ( jobs < 1 )
+        jobs = 1;
+
+    pool.flow     = flow;
+    pool.nworkers = jobs;
+    pool.workers  = zalloc( jobs * sizeof( struct flow_worker ) );
+    pool.pending  = flow->nwork;
+
+    for ( i = 0; i < jobs; i++ )
+    {
+        struct flow_worker *w = &pool.workers[i];
+
+        w->pool  = &pool;
+        w->index = i;
+        pthread_mutex_init( &w->deque.lock, NULL );
+        dasm_ctx_init( &w->ctx );
+        w->ctx.soft_eof = 1;
+        w->ctx.xref     = flow_addxref;
+        w->ctx.xref_arg = &w->fi;
+    }
+
+    for ( k = 0; k < flow->nwork; k++ )
+        deque_push( &pool.workers[k % jobs].deque, flow->work[k] );
+    flow->nwork = 0;
+
+    /* The calling thread is the first worker */
+    threads = zalloc( jobs * sizeof( pthread_t ) );
+    for ( i = 1; i < jobs; i++ )
+        if ( pthread_create( &threads[i], NULL, flow_worker, &pool.workers[i] ) )
+            error( "Failed to start worker thread" );
+
+    flow_worker( &pool.workers[0] );
+
+    for ( i = 1; i < jobs; i++ )
+        pthread_join( threads[i], NULL );
+
+    for ( i = 0; i < jobs; i++ )
+    {
+        struct flow_worker *w = &pool.workers[i];
+
+        flow->ninsns += w->ninsns;
+        dasm_ctx_free( &w->ctx );
+        pthread_mutex_destroy( &w->deque.lock );
+        free( w->deque.item );
+    }
+
+    free( threads );
+    free( pool.workers );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
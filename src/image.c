@@ -0,0 +1,692 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Input image
+ *
+ * The input is held as a table of segments, each a run of bytes at a
+ *  load address, in address order, from one or more input files.  A
+ *  flat binary file is mapped into memory once and becomes a single
+ *  segment; the loadable parts of an ELF file become segments pointing
+ *  into its mapping; Intel HEX and S-record files are parsed into heap
+ *  segments (see loader.c); the byte lanes of an interleaved image are
+ *  merged into one heap segment.  The gaps between segments take no
+ *  memory.
+ *
+ * All byte accesses made by the disassembler are served through a read
+ *  cursor in the decoder context which points straight into a segment.
+ *  Only when the cursor reaches the end of a segment does image_seek()
+ *  look up the next one, through a page table so that the cost does not
+ *  grow with the number of segments.  Bytes in a gap between segments
+ *  read as IMAGE_GAP_FILL; reading before the first or after the last
+ *  segment is the end of the input.
+ *
+ * On hosts without mmap() the files are read into heap buffers instead.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#define IMAGE_NO_MMAP
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Global Data
+ *****************************************************************************/
+
+struct image image;
+
+/*****************************************************************************
+ *        Private Data
+ *****************************************************************************/
+
+/* Value of bytes in the gaps between segments */
+#define IMAGE_GAP_FILL      ( 0xFF )
+
+/* Size of the buffer of fill bytes the cursor is pointed at in a gap */
+#define IMAGE_GAP_PAGE      ( 4096 )
+
+static UBYTE gap_fill[IMAGE_GAP_PAGE];
+
+/* The page size of the page table is the smallest, from IMAGE_PAGE_BITS
+ * up, that keeps it to IMAGE_PAGES_PER_SEG entries per segment and no
+ * more than IMAGE_MAX_PAGES in all, so that few segments end in a page.
+ */
+#define IMAGE_PAGE_BITS     ( 4 )
+#define IMAGE_PAGES_PER_SEG ( 4 )
+#define IMAGE_MAX_PAGES     ( 65536 )
+
+/* The input files, each mapped or else read into the heap (see
+ * image_file())
+ */
+struct image_map {
+    void        *p;
+    size_t       length;
+    int          mapped;
+};
+
+static struct image_map *image_maps  = NULL;
+static size_t            image_nmaps = 0;
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_read
+ *
+ * DESCRIPTION
+ *      Reads the whole of the named file into a heap buffer.
+ *      Used where the file cannot be mapped.
+ *
+ * RETURNS
+ *      pointer to the buffer, length in *length
+ *
+ ************************************************************/
+
+static UBYTE * image_read( const char *filename, size_t *length )
+{
+    FILE *f;
+    long  len;
+    UBYTE *buf;
+
+    f = fopen( filename, "rb" );
+    if ( !f )
+        error( "Failed to open input file" );
+
+    fseek( f, 0, SEEK_END );
+    len = ftell( f );
+    fseek( f, 0, SEEK_SET );
+
+    if ( len < 0 )
+        error( "Failed to read input file \"%s\"", filename );
+
+    buf = zalloc( len ? len : 1 );
+    if ( fread( buf, 1, len, f ) != (size_t)len )
+        error( "Failed to read input file \"%s\"", filename );
+
+    fclose( f );
+
+    *length = (size_t)len;
+    return buf;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_flat
+ *
+ * DESCRIPTION
+ *      Loads a flat binary file as one segment, the byte at
+ *       offset in the file being at address base, or as one
+ *       byte lane of an interleaved image at base.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void image_flat( const struct image_input *in, unsigned int offset, ADDR base )
+{
+    const UBYTE *data;
+    size_t length;
+
+    data = image_file( in->name, &length );
+
+    if ( offset >= length )
+        return;
+
+    if ( in->lanes )
+        image_add_lane( base, data + offset, length - offset, in->lane, in->lanes );
+    else
+        image_add_segment( base, data + offset, length - offset, NULL );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmp_seg
+ *
+ * DESCRIPTION
+ *      qsort() comparison of two segments by address.
+ *
+ * RETURNS
+ *      <0, 0, >0
+ *
+ ************************************************************/
+
+static int cmp_seg( const void *a, const void *b )
+{
+    ADDR ba = ( (const struct image_seg *)a )->base;
+    ADDR bb = ( (const struct image_seg *)b )->base;
+
+    return ( ba > bb ) - ( ba < bb );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_finish
+ *
+ * DESCRIPTION
+ *      Sorts the segments into address order, joins any
+ *       that are contiguous, checks that none overlap and
+ *       builds the page table.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void image_finish( void )
+{
+    struct image_seg *prev, *seg;
+    size_t i, p, limit, n = 0;
+
+    qsort( image.segs, image.nsegs, sizeof( struct image_seg ), cmp_seg );
+
+    for ( i = 0; i < image.nsegs; i++ )
+    {
+        seg  = &image.segs[i];
+        prev = n ? &image.segs[n - 1] : NULL;
+
+        if ( prev && seg->base - prev->base < prev->length )
+            error( "Overlapping data at $%04X in input file", seg->base );
+
+        if ( prev && prev->heap && prev->data == prev->heap && seg->heap
+             && !prev->lanes && !seg->lanes
+             && seg->base - prev->base == prev->length )
+        {
+            /* Join heap segments that were loaded out of order */
+            if ( prev->length + seg->length > prev->size )
+            {
+                prev->size = prev->length + seg->length;
+                prev->heap = realloc( prev->heap, prev->size );
+                if ( !prev->heap )
+                    error( "Out of memory for input image" );
+                prev->data = prev->heap;
+            }
+            memcpy( prev->heap + prev->length, seg->data, seg->length );
+            prev->length += seg->length;
+            free( seg->heap );
+            continue;
+        }
+
+        image.segs[n++] = *seg;
+    }
+    image.nsegs = n;
+
+    if ( !n )
+        return;
+
+    image.start = image.segs[0].base;
+    image.end   = image.segs[n - 1].base + image.segs[n - 1].length;
+
+    limit = MIN( n * IMAGE_PAGES_PER_SEG, IMAGE_MAX_PAGES );
+    image.page_bits = IMAGE_PAGE_BITS;
+    while ( ( ( image.end - image.start - 1 ) >> image.page_bits ) >= limit )
+        image.page_bits++;
+    image.npages = ( ( image.end - image.start - 1 ) >> image.page_bits ) + 1;
+    image.pages  = zalloc( image.npages * sizeof( ULWORD ) );
+
+    for ( p = 0, i = 0; p < image.npages; p++ )
+    {
+        ADDR page = image.start + ( (ADDR)p << image.page_bits );
+
+        while ( image.segs[i].base + image.segs[i].length <= page )
+            i++;
+        image.pages[p] = (ULWORD)i;
+    }
+}
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_file
+ *
+ * DESCRIPTION
+ *      Maps the whole of the named input file into memory,
+ *       or reads it where it cannot be mapped.  The contents
+ *       are kept until image_close(), so segments may point
+ *       into them.
+ *
+ * RETURNS
+ *      pointer to the contents, length in *length
+ *
+ ************************************************************/
+
+const UBYTE * image_file( const char *filename, size_t *length )
+{
+    struct image_map *m;
+#ifndef IMAGE_NO_MMAP
+    int fd;
+    struct stat st;
+    void *p;
+#endif
+
+    image_maps = realloc( image_maps, ( image_nmaps + 1 ) * sizeof( struct image_map ) );
+    if ( !image_maps )
+        error( "Out of memory for input image" );
+    m = &image_maps[image_nmaps++];
+    m->mapped = 0;
+
+#ifdef IMAGE_NO_MMAP
+    m->p = image_read( filename, length );
+    m->length = *length;
+    return m->p;
+#else
+
+    fd = open( filename, O_RDONLY );
+    if ( fd < 0 )
+        error( "Failed to open input file" );
+
+    if ( fstat( fd, &st ) != 0 )
+        error( "Failed to read input file \"%s\"", filename );
+
+    p = MAP_FAILED;
+    if ( S_ISREG( st.st_mode ) && st.st_size != 0 )
+        p = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    /* Pipes and empty files cannot be mapped */
+    if ( p == MAP_FAILED )
+        p = image_read( filename, length );
+    else
+    {
+        *length   = (size_t)st.st_size;
+        m->mapped = 1;
+    }
+
+    m->p      = p;
+    m->length = *length;
+    return p;
+#endif
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_add_segment
+ *
+ * DESCRIPTION
+ *      Adds a run of bytes at the given address to the
+ *       image.  heap, if not NULL, is the allocation holding
+ *       the data, which the image then owns.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void image_add_segment( ADDR base, const UBYTE *data, size_t length, UBYTE *heap )
+{
+    struct image_seg *seg;
+
+    if ( image.nsegs == image.segs_size )
+    {
+        image.segs_size = image.segs_size ? image.segs_size * 2 : 16;
+        image.segs = realloc( image.segs, image.segs_size * sizeof( struct image_seg ) );
+        if ( !image.segs )
+            error( "Out of memory for input image" );
+    }
+
+    seg = &image.segs[image.nsegs++];
+    seg->base   = base;
+    seg->length = length;
+    seg->data   = data;
+    seg->heap   = heap;
+    seg->size   = heap ? length : 0;
+    seg->lanes  = 0;
+
+    image.length += length;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_add_bytes
+ *
+ * DESCRIPTION
+ *      Adds bytes at the given address, copying them.  Bytes
+ *       which carry on from the last ones added go on the end
+ *       of the same segment, so a file of records in address
+ *       order is held in as few segments as it has runs.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void image_add_bytes( ADDR addr, const UBYTE *data, size_t n )
+{
+    struct image_seg *seg = image.nsegs ? &image.segs[image.nsegs - 1] : NULL;
+
+    if ( !n )
+        return;
+
+    if ( !seg || !seg->heap || seg->data != seg->heap || seg->lanes
+         || seg->base + seg->length != addr )
+    {
+        image_add_segment( addr, NULL, 0, NULL );
+        seg = &image.segs[image.nsegs - 1];
+    }
+
+    if ( seg->length + n > seg->size )
+    {
+        seg->size = MAX( seg->length + n, seg->size ? seg->size * 2 : 256 );
+        seg->heap = realloc( seg->heap, seg->size );
+        if ( !seg->heap )
+            error( "Out of memory for input image" );
+        seg->data = seg->heap;
+    }
+
+    memcpy( seg->heap + seg->length, data, n );
+    seg->length  += n;
+    image.length += n;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_add_lane
+ *
+ * DESCRIPTION
+ *      Adds one byte lane of an image interleaved across
+ *       several files, such as the even and odd EPROMs of a
+ *       16-bit bus: byte i goes to base + lane + i * lanes.
+ *      All the lanes at one base go in one segment; bytes
+ *       that no lane gives read as IMAGE_GAP_FILL.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void image_add_lane( ADDR base, const UBYTE *data, size_t length,
+                     unsigned int lane, unsigned int lanes )
+{
+    struct image_seg *seg = NULL;
+    size_t i, need;
+
+    if ( !length )
+        return;
+
+    for ( i = 0; i < image.nsegs && !seg; i++ )
+        if ( image.segs[i].lanes == lanes && image.segs[i].base == base )
+            seg = &image.segs[i];
+
+    if ( !seg )
+    {
+        image_add_segment( base, NULL, 0, NULL );
+        seg = &image.segs[image.nsegs - 1];
+        seg->lanes = lanes;
+    }
+
+    need = lane + ( length - 1 ) * lanes + 1;
+    if ( need > seg->size )
+    {
+        seg->heap = realloc( seg->heap, need );
+        if ( !seg->heap )
+            error( "Out of memory for input image" );
+        memset( seg->heap + seg->size, IMAGE_GAP_FILL, need - seg->size );
+        seg->size = need;
+        seg->data = seg->heap;
+    }
+    if ( need > seg->length )
+        seg->length = need;
+
+    for ( i = 0; i < length; i++ )
+        seg->heap[lane + i * lanes] = data[i];
+
+    image.length += length;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_open
+ *
+ * DESCRIPTION
+ *      Loads the input files.  ELF, Intel HEX and S-record
+ *       files are loaded at the addresses they give.  Any
+ *       other file is a flat binary, loaded from the given
+ *       offset in the file at its load address, or at base
+ *       if it has none; an offset beyond the end of the file
+ *       leaves nothing of it, so a read there fails in the
+ *       usual way.  The number of bytes loaded from each file
+ *       is set in its length.
+ *      Disassembly starts at base.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void image_open( struct image_input *inputs, size_t n, unsigned int offset, ADDR base )
+{
+    struct image_input *in;
+    size_t loaded;
+
+    memset( gap_fill, IMAGE_GAP_FILL, sizeof( gap_fill ) );
+
+    for ( in = inputs; in < inputs + n; in++ )
+    {
+        loaded = image.length;
+
+        if ( !loader_load( in->name ) )
+            image_flat( in, offset, in->placed ? in->addr : base );
+        else if ( in->placed )
+            error( "\"%s\" gives its own load addresses", in->name );
+        else if ( offset )
+            warning( "File offset ignored for \"%s\"", in->name );
+
+        in->length = image.length - loaded;
+    }
+
+    image_finish();
+    image.origin = base;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_seek
+ *
+ * DESCRIPTION
+ *      Points a decoder context's read cursor at the input
+ *       byte for addr.  The cursor runs to the end of the
+ *       segment, or of the gap, holding addr; outside the
+ *       image it is left empty.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void image_seek( dasm_ctx_t *ctx, ADDR addr )
+{
+    const struct image_seg *seg;
+    size_t n;
+
+    ctx->cur      = gap_fill;
+    ctx->end      = gap_fill;
+    ctx->end_addr = addr;
+
+    if ( addr < image.start || addr >= image.end )
+        return;
+
+    /* First segment ending beyond addr: the page table gives the first
+     * ending beyond the start of its page
+     */
+    seg = &image.segs[image.pages[( addr - image.start ) >> image.page_bits]];
+    while ( seg->base + seg->length <= addr )
+        seg++;
+
+    if ( addr >= seg->base )
+    {
+        ctx->cur      = seg->data + ( addr - seg->base );
+        ctx->end      = seg->data + seg->length;
+        ctx->end_addr = seg->base + seg->length;
+    }
+    else
+    {
+        /* In the gap before it */
+        n = MIN( (size_t)( seg->base - addr ), sizeof( gap_fill ) );
+        ctx->end      = gap_fill + n;
+        ctx->end_addr = addr + n;
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_refill
+ *
+ * DESCRIPTION
+ *      Moves a decoder context's cursor on to the segment or
+ *       gap after the one it has read to the end of.
+ *
+ * RETURNS
+ *      non-zero if there is more input
+ *
+ ************************************************************/
+
+int image_refill( dasm_ctx_t *ctx )
+{
+    image_seek( ctx, ctx->end_addr );
+
+    return ctx->cur < ctx->end;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_byte
+ *
+ * DESCRIPTION
+ *      Reads the byte at the given address.
+ *
+ * RETURNS
+ *      the byte, or -1 if addr is outside the image
+ *
+ ************************************************************/
+
+int image_byte( ADDR addr )
+{
+    dasm_ctx_t ctx;
+
+    image_seek( &ctx, addr );
+
+    return ctx.cur < ctx.end ? *ctx.cur : -1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_loaded
+ *
+ * DESCRIPTION
+ *      Tests whether the input file gave a byte for the given
+ *       address, rather than it falling in a gap.
+ *
+ * RETURNS
+ *      non-zero if it did
+ *
+ ************************************************************/
+
+int image_loaded( ADDR addr )
+{
+    dasm_ctx_t ctx;
+
+    image_seek( &ctx, addr );
+
+    return ctx.cur < ctx.end && ctx.cur != gap_fill;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      image_close
+ *
+ * DESCRIPTION
+ *      Releases the input image.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void image_close( void )
+{
+    size_t i;
+
+    for ( i = 0; i < image.nsegs; i++ )
+        free( image.segs[i].heap );
+    free( image.segs );
+
+    for ( i = 0; i < image_nmaps; i++ )
+    {
+#ifndef IMAGE_NO_MMAP
+        if ( image_maps[i].mapped )
+            munmap( image_maps[i].p, image_maps[i].length );
+        else
+#endif
+            free( image_maps[i].p );
+    }
+    free( image_maps );
+    image_maps  = NULL;
+    image_nmaps = 0;
+    free( image.pages );
+
+    memset( &image, 0, sizeof(image) );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
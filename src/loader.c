@@ -0,0 +1,495 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Image loaders
+ *
+ * Load input files which give their own load addresses into the input
+ *  image (see image.c).  Nothing is converted to a flat binary first,
+ *  and the gaps between the parts of the file take no memory.  HEX and
+ *  S-record files are mapped with the command file reader and loaded
+ *  record by record as they are read.
+ *
+ * The formats understood are:
+ *
+ *      ELF         32- or 64-bit, either byte order, found by its magic
+ *                   number: the file contents of the loadable program
+ *                   segments at their physical addresses or, if there
+ *                   are none, of the allocated sections at theirs
+ *      Intel HEX   *.hex, *.ihx, *.ihex: data, extended segment address
+ *                   and extended linear address records
+ *      S-record    *.s19, *.s28, *.s37, *.srec, *.mot: S1, S2 and S3
+ *                   data records
+ *
+ * ELF segments point into the mapped file rather than being copied.  For
+ *  HEX and S-record files header, count and start address records are
+ *  ignored, and checksums are checked.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Data Types, Macros, Constants
+ *****************************************************************************/
+
+/* Most data bytes in one record (both formats have a one byte count) */
+#define RECORD_MAX      ( 256 )
+
+/* ELF constants (see also dasmxx.h) */
+#define PT_LOAD         1
+#define SHT_PROGBITS    1
+#define SHF_ALLOC       0x2
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      get_hex
+ *
+ * DESCRIPTION
+ *      Decodes n bytes of hex digit pairs from s into buf.
+ *
+ * RETURNS
+ *      0 if they are all there and valid, else -1
+ *
+ ************************************************************/
+
+static int get_hex( const char *s, UBYTE *buf, size_t n )
+{
+    size_t i;
+    int hi, lo;
+
+    for ( i = 0; i < n; i++ )
+    {
+        if ( ( hi = cmdfile_hexval( s[2 * i] ) ) < 0
+             || ( lo = cmdfile_hexval( s[2 * i + 1] ) ) < 0 )
+            return -1;
+        buf[i] = (UBYTE)( ( hi << 4 ) | lo );
+    }
+
+    return 0;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      record_bytes
+ *
+ * DESCRIPTION
+ *      Decodes the bytes of a record which starts with a
+ *       byte count, checking that they are all there.
+ *      extra is the number of bytes, after the count byte,
+ *       that the count does not include.
+ *
+ * RETURNS
+ *      number of bytes in buf, including the count
+ *
+ ************************************************************/
+
+static size_t record_bytes( cmdfile_t *cf, const char *s, UBYTE *buf, size_t extra )
+{
+    size_t n;
+
+    if ( get_hex( s, buf, 1 ) != 0 )
+        error( "%s(%u) :: Bad record", cf->name, cf->lineno );
+
+    n = 1 + buf[0] + extra;
+    if ( strlen( s ) < 2 * n || get_hex( s + 2, buf + 1, n - 1 ) != 0 )
+        error( "%s(%u) :: Bad record", cf->name, cf->lineno );
+
+    return n;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      load_ihex
+ *
+ * DESCRIPTION
+ *      Loads an Intel HEX file.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void load_ihex( cmdfile_t *cf )
+{
+    UBYTE buf[1 + 4 + RECORD_MAX];
+    ULWORD upper = 0;
+    char *line;
+    size_t n, i;
+    UBYTE sum;
+
+    while ( ( line = cmdfile_getline( cf ) ) != NULL )
+    {
+        line += strspn( line, " \t" );
+        if ( *line != ':' )
+            continue;
+
+        /* count, address (2), type, data..., checksum */
+        n = record_bytes( cf, line + 1, buf, 4 );
+
+        for ( sum = 0, i = 0; i < n; i++ )
+            sum += buf[i];
+        if ( sum != 0 )
+            error( "%s(%u) :: Checksum error", cf->name, cf->lineno );
+
+        switch ( buf[3] )
+        {
+        case 0x00:  /* Data */
+            image_add_bytes( upper + ( ( buf[1] << 8 ) | buf[2] ), buf + 4, buf[0] );
+            break;
+
+        case 0x01:  /* End of file */
+            return;
+
+        case 0x02:  /* Extended segment address */
+            upper = ( ( buf[4] << 8 ) | buf[5] ) << 4;
+            break;
+
+        case 0x04:  /* Extended linear address */
+            upper = (ULWORD)( ( buf[4] << 8 ) | buf[5] ) << 16;
+            break;
+
+        default:    /* Start addresses */
+            break;
+        }
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      load_srec
+ *
+ * DESCRIPTION
+ *      Loads a Motorola S-record file.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void load_srec( cmdfile_t *cf )
+{
+    UBYTE buf[1 + RECORD_MAX];
+    ADDR addr;
+    char *line;
+    size_t n, i, alen;
+    UBYTE sum;
+
+    while ( ( line = cmdfile_getline( cf ) ) != NULL )
+    {
+        line += strspn( line, " \t" );
+        if ( line[0] != 'S' && line[0] != 's' )
+            continue;
+
+        /* count, address, data..., checksum: the count covers all but
+         * itself
+         */
+        n = record_bytes( cf, line + 2, buf, 0 );
+
+        for ( sum = 0, i = 0; i < n; i++ )
+            sum += buf[i];
+        if ( sum != 0xFF )
+            error( "%s(%u) :: Checksum error", cf->name, cf->lineno );
+
+        if ( line[1] < '1' || line[1] > '3' )
+            continue;   /* Not a data record */
+
+        alen = line[1] - '0' + 1;
+        if ( buf[0] < alen + 1 )
+            error( "%s(%u) :: Bad record", cf->name, cf->lineno );
+
+        for ( addr = 0, i = 0; i < alen; i++ )
+            addr = ( addr << 8 ) | buf[1 + i];
+
+        image_add_bytes( addr, buf + 1 + alen, buf[0] - alen - 1 );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      load_elf
+ *
+ * DESCRIPTION
+ *      Loads an ELF file: the file contents of each loadable
+ *       program segment at its physical address or, in a file
+ *       with no program headers, of each allocated section at
+ *       its address.  The zero-filled tail of a segment (bss)
+ *       is not loaded.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+#define ELF_GET(M_off, M_n)     elf_get( data + (M_off), (M_n), msb )
+#define ELF_WORD(M_off32, M_off64) \
+    ( is64 ? ELF_GET( (M_off64), 8 ) : ELF_GET( (M_off32), 4 ) )
+
+static void load_elf( const char *filename )
+{
+    const UBYTE *data;
+    size_t length;
+    unsigned long long phoff, shoff, off, offset, addr, size;
+    unsigned int phentsize, phnum, shentsize, shnum, i, nloaded = 0;
+    int is64, msb;
+    ADDR entry;
+
+    data = image_file( filename, &length );
+
+    if ( !loader_elf_entry( data, length, &entry ) )
+        error( "%s :: Bad ELF file", filename );
+
+    is64 = data[EI_CLASS] == ELFCLASS64;
+    msb  = data[EI_DATA] == ELFDATA2MSB;
+
+    phoff     = ELF_WORD( 0x1C, 0x20 );
+    phentsize = (unsigned int)( is64 ? ELF_GET( 0x36, 2 ) : ELF_GET( 0x2A, 2 ) );
+    phnum     = (unsigned int)( is64 ? ELF_GET( 0x38, 2 ) : ELF_GET( 0x2C, 2 ) );
+
+    if ( phnum && ( phentsize < ( is64 ? 56u : 32u ) || phoff > length
+                    || (unsigned long long)phnum * phentsize > length - phoff ) )
+        error( "%s :: Bad ELF program headers", filename );
+
+    for ( i = 0; i < phnum; i++ )
+    {
+        off = phoff + (unsigned long long)i * phentsize;
+        if ( ELF_GET( off, 4 ) != PT_LOAD )
+            continue;
+
+        offset = ELF_WORD( off + 4,  off + 8 );
+        addr   = ELF_WORD( off + 12, off + 24 );
+        size   = ELF_WORD( off + 16, off + 32 );
+
+        if ( offset > length || size > length - offset )
+            error( "%s :: Bad ELF program headers", filename );
+
+        if ( size )
+            image_add_segment( (ADDR)addr, data + offset, (size_t)size, NULL );
+        nloaded++;
+    }
+
+    if ( nloaded )
+        return;
+
+    shoff     = ELF_WORD( 0x20, 0x28 );
+    shentsize = (unsigned int)( is64 ? ELF_GET( 0x3A, 2 ) : ELF_GET( 0x2E, 2 ) );
+    shnum     = (unsigned int)( is64 ? ELF_GET( 0x3C, 2 ) : ELF_GET( 0x30, 2 ) );
+
+    if ( shnum && ( shentsize < ( is64 ? 64u : 40u ) || shoff > length
+                    || (unsigned long long)shnum * shentsize > length - shoff ) )
+        error( "%s :: Bad ELF section headers", filename );
+
+    for ( i = 0; i < shnum; i++ )
+    {
+        off = shoff + (unsigned long long)i * shentsize;
+        if ( ELF_GET( off + 4, 4 ) != SHT_PROGBITS
+             || !( ELF_WORD( off + 8, off + 8 ) & SHF_ALLOC ) )
+            continue;
+
+        addr   = ELF_WORD( off + 12, off + 16 );
+        offset = ELF_WORD( off + 16, off + 24 );
+        size   = ELF_WORD( off + 20, off + 32 );
+
+        if ( offset > length || size > length - offset )
+            error( "%s :: Bad ELF section headers", filename );
+
+        if ( size )
+            image_add_segment( (ADDR)addr, data + offset, (size_t)size, NULL );
+    }
+}
+
+#undef ELF_WORD
+#undef ELF_GET
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      elf_get
+ *
+ * DESCRIPTION
+ *      Reads an n-byte value in an ELF file's byte order.
+ *
+ * RETURNS
+ *      the value
+ *
+ ************************************************************/
+
+unsigned long long elf_get( const UBYTE *p, int n, int msb )
+{
+    unsigned long long v = 0;
+    int i;
+
+    for ( i = 0; i < n; i++ )
+        v = ( v << 8 ) | p[msb ? i : n - 1 - i];
+
+    return v;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      loader_is_elf
+ *
+ * DESCRIPTION
+ *      Tests whether the named file is a regular file that
+ *       starts with the ELF magic number.  Anything else,
+ *       such as a pipe, is left unread.
+ *
+ * RETURNS
+ *      non-zero if it is
+ *
+ ************************************************************/
+
+int loader_is_elf( const char *filename )
+{
+    struct stat st;
+    char  magic[4];
+    FILE *f;
+    int   elf;
+
+    if ( stat( filename, &st ) != 0 || !S_ISREG( st.st_mode ) )
+        return 0;
+
+    if ( ( f = fopen( filename, "rb" ) ) == NULL )
+        return 0;
+
+    elf = fread( magic, 1, 4, f ) == 4 && memcmp( magic, "\177ELF", 4 ) == 0;
+    fclose( f );
+
+    return elf;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      loader_elf_entry
+ *
+ * DESCRIPTION
+ *      Tests whether a file's contents are an ELF file and
+ *       reads its entry point address.
+ *
+ * RETURNS
+ *      non-zero if it is ELF, the entry point in *entry
+ *
+ ************************************************************/
+
+int loader_elf_entry( const UBYTE *data, size_t length, ADDR *entry )
+{
+    int msb;
+
+    if ( length < 0x34 || memcmp( data, "\177ELF", 4 ) != 0 )
+        return 0;
+
+    msb = data[EI_DATA] == ELFDATA2MSB;
+
+    if ( data[EI_CLASS] == ELFCLASS64 && length >= 0x40 )
+        *entry = (ADDR)elf_get( data + 0x18, 8, msb );
+    else if ( data[EI_CLASS] == ELFCLASS32 )
+        *entry = (ADDR)elf_get( data + 0x18, 4, msb );
+    else
+        return 0;
+
+    return 1;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      loader_load
+ *
+ * DESCRIPTION
+ *      Loads the named file into the input image if it is in
+ *       one of the formats above.
+ *
+ * RETURNS
+ *      non-zero if it was loaded, 0 if it is not in one of
+ *       these formats
+ *
+ ************************************************************/
+
+int loader_load( const char *filename )
+{
+    cmdfile_t cf;
+    int srec;
+
+    if ( cmdfile_has_ext( filename, ".hex" )
+         || cmdfile_has_ext( filename, ".ihx" )
+         || cmdfile_has_ext( filename, ".ihex" ) )
+        srec = 0;
+    else if ( cmdfile_has_ext( filename, ".s19" )
+              || cmdfile_has_ext( filename, ".s28" )
+              || cmdfile_has_ext( filename, ".s37" )
+              || cmdfile_has_ext( filename, ".srec" )
+              || cmdfile_has_ext( filename, ".mot" ) )
+        srec = 1;
+    else if ( loader_is_elf( filename ) )
+    {
+        load_elf( filename );
+        return 1;
+    }
+    else
+        return 0;
+
+    if ( cmdfile_open( &cf, filename ) != 0 )
+        error( "Failed to open input file \"%s\"", filename );
+
+    if ( srec )
+        load_srec( &cf );
+    else
+        load_ihex( &cf );
+
+    cmdfile_close( &cf );
+
+    return 1;
+}
+
+/******************************************************************************/
+/******************************************************************************/
@@ -34,6 +34,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <pthread.h>
 
 #include "dasmxx.h"
 #include "optab.h"
@@ -46,30 +47,29 @@
 #define INSN_FOUND              ( 1 )
 #define INSN_NOT_FOUND          ( 0 )
 
-/*****************************************************************************
- * External data.
- *****************************************************************************/
+/* Maximum number of op tables (base table plus sub-tables) per decoder */
+#define MAX_DISPATCH            ( 32 )
 
-extern optab_t base_optab[];
+/* Opcodes examined by MEMMOD entries */
+#define IS_MEMMOD_OPC(M_opc)    ( (M_opc) == 0x16 || (M_opc) == 0x17 \
+                                  || (M_opc) == 0x06 || (M_opc) == 0x0A )
 
 /*****************************************************************************
- * Global data. Delcare as extern in header file.
+ * External data.
  *****************************************************************************/
 
-/* Start address of each instruction as it is decoded. */
-ADDR g_insn_addr = 0;
+extern optab_t base_optab[];
 
 /*****************************************************************************
  * Private data.
  *****************************************************************************/
 
-/* Global output buffer into which the decoded output is written. */
-static char * output_buffer = NULL;
-
-/* Stack for PUSHTBL */
-#define STACK_DEPTH	( 16 )
-static OPC opcstack[STACK_DEPTH];
-static int tos = -1;
+/* Compiled op tables, base_optab first.  Set up once, by whichever
+ * decoder thread gets there first.
+ */
+static optab_dispatch_t dispatch[MAX_DISPATCH];
+static int              n_dispatch = 0;
+static pthread_once_t   dispatch_once = PTHREAD_ONCE_INIT;
 
 /*****************************************************************************
  *        Private Functions
@@ -81,17 +81,23 @@ static int tos = -1;
  *      opcode
  *
  * DESCRIPTION
- *      Writes the given opcode string into the output buffer.
+ *      Writes the given opcode string into the context's
+ *      output buffer, if there is one.
  *
  * RETURNS
  *      none
  *
  ************************************************************/
  
-static void opcode( const char *opcode )
+static void opcode( dasm_ctx_t *ctx, const char *opcode )
 {
-    int n = sprintf( output_buffer, "%-*s", dasm_max_opcode_width, opcode );
-    output_buffer += n;
+    int n;
+
+    if ( !ctx->outbuf )
+        return;
+
+    n = sprintf( ctx->outbuf, "%-*s", dasm_max_opcode_width, opcode );
+    ctx->outbuf += n;
 }
 
 /***********************************************************
@@ -108,17 +114,171 @@ static void opcode( const char *opcode )
  *
  ************************************************************/
 
-static OPC next_insn( FILE* fp, ADDR *addr  )
+static OPC next_insn( dasm_ctx_t *ctx, ADDR *addr  )
 {
     if ( dasm_insn_width_bytes == 1 )
-        return (OPC)next( fp, addr );
+        return (OPC)next( ctx, addr );
     else if ( dasm_insn_width_bytes == 2 )
-        return (OPC)nextw( fp, addr );
+        return (OPC)nextw( ctx, addr );
     else
         error( "INTERNAL ERROR: unsupported instruction size.\n" );
     return 0; /* unreachable, error() exits */
 }
 
+/***********************************************************
+ *
+ * FUNCTION
+ *      entry_may_match
+ *
+ * DESCRIPTION
+ *      Tests whether an op table entry can match the given
+ *       opcode, ignoring any condition on the following byte.
+ *
+ * RETURNS
+ *      0 - never matches
+ *      1 - matches unconditionally
+ *      2 - matches depending on the following byte
+ *
+ ************************************************************/
+
+static int entry_may_match( const optab_t * optab, OPC opc )
+{
+    switch ( optab->type )
+    {
+    case OPTAB_TABLE:
+    case OPTAB_UNDEF:
+    case OPTAB_INSN:
+    case OPTAB_PUSHTBL:
+    case OPTAB_PREFIX:
+        return optab->opc == opc;
+
+    case OPTAB_RANGE:
+        return opc >= optab->u.range.min && opc <= optab->u.range.max;
+
+    case OPTAB_MASK:
+        return ( opc & optab->u.mask.mask ) == optab->u.mask.val;
+
+    case OPTAB_MASK2:
+        return optab->opc == opc ? 2 : 0;
+
+    case OPTAB_MEMMOD:
+        return IS_MEMMOD_OPC( opc ) ? 2 : 0;
+    }
+
+    return 0;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      compile_table
+ *
+ * DESCRIPTION
+ *      Expands an op table into a dispatch array covering
+ *       every opcode value, then compiles any sub-tables it
+ *       refers to.  Tables already compiled are reused.
+ *      optab  - op table to compile
+ *      parent - dispatch number of the referring table
+ *      entry  - referring entry in the parent table
+ *
+ * RETURNS
+ *      dispatch number of the compiled table, or -1 if
+ *       optab is NULL.
+ *
+ ************************************************************/
+
+static int compile_table( optab_t * optab, int parent, int entry )
+{
+    optab_dispatch_t *d;
+    ULWORD *index;
+    WORD *cand, *link;
+    size_t n_cand = 0, cand_size, prev = 0;
+    int n_entries, i, num;
+    unsigned int opc;
+
+    if ( optab == NULL )
+        return -1;
+
+    for ( num = 0; num < n_dispatch; num++ )
+        if ( dispatch[num].table == optab )
+            return num;
+
+    if ( n_dispatch >= MAX_DISPATCH )
+        error( "INTERNAL ERROR: too many op tables.\n" );
+
+    num = n_dispatch++;
+    d = &dispatch[num];
+
+    for ( n_entries = 0; optab[n_entries].opcode != NULL; n_entries++ )
+        ;
+
+    d->table  = optab;
+    d->nopc   = 1u << ( 8 * dasm_insn_width_bytes );
+    d->parent = parent;
+    d->entry  = entry;
+
+    index     = zalloc( d->nopc * sizeof( ULWORD ) );
+    cand_size = 1024;
+    cand      = zalloc( cand_size * sizeof( WORD ) );
+    link      = zalloc( ( n_entries + 1 ) * sizeof( WORD ) );
+
+    for ( opc = 0; opc < d->nopc; opc++ )
+    {
+        size_t start = n_cand;
+
+        for ( i = 0; i < n_entries; i++ )
+        {
+            int m = entry_may_match( &optab[i], (OPC)opc );
+
+            if ( m == 0 )
+                continue;
+
+            if ( n_cand + 2 > cand_size )
+            {
+                cand_size *= 2;
+                cand = realloc( cand, cand_size * sizeof( WORD ) );
+                if ( !cand )
+                    error( "Out of memory" );
+            }
+            cand[n_cand++] = (WORD)i;
+
+            if ( m == 1 )
+                break;
+        }
+        cand[n_cand++] = -1;
+
+        /* Share the previous opcode's list if it is the same */
+        if ( opc > 0
+             && n_cand - start == start - prev
+             && !memcmp( &cand[prev], &cand[start], ( n_cand - start ) * sizeof( WORD ) ) )
+            n_cand = start;
+        else
+            prev = start;
+
+        index[opc] = (ULWORD)prev;
+    }
+
+    d->index = index;
+    d->cand  = cand;
+    d->link  = link;
+    d->ncand = (ULWORD)n_cand;
+
+    /* Now the sub-tables.  Each one is compiled into a later slot of
+     * dispatch[], so this table's own link[] can be filled in as we go.
+     */
+    for ( i = 0; i < n_entries; i++ )
+    {
+        if ( optab[i].type == OPTAB_TABLE )
+            link[i] = (WORD)compile_table( optab[i].u.table, num, i );
+        else if ( optab[i].type == OPTAB_PUSHTBL )
+            link[i] = (WORD)compile_table( optab[i].u.pushtbl.table, num, i );
+        else
+            link[i] = -1;
+    }
+
+    return num;
+}
+
 /***********************************************************
  *
  * FUNCTION
@@ -126,103 +286,173 @@ static OPC next_insn( FILE* fp, ADDR *addr  )
  *
  * DESCRIPTION
  *      Disassembles the next instruction in the input stream.
- *      f     - file stream to read (pass to calls to next() )
+ *      ctx   - decoder context (pass to calls to next() )
  *      addr  - address of first input byte for this insn
- *      optab - table to use to decode this instruction
+ *      num   - compiled table to use to decode this instruction
  *      opc   - opcode to decode
  *
+ *      Only the candidate entries listed for opc in the
+ *       compiled table are examined, in table order, so the
+ *       first entry that matches still wins.
+ *
  * RETURNS
  *      INSN_FOUND if a valid instruction found.
  *      INSN_NOT_FOUND otherwise.
  *
  ************************************************************/
 
-static int walk_table( FILE * f, ADDR * addr, optab_t * optab, OPC opc )
+static int walk_table( dasm_ctx_t * ctx, ADDR * addr, int num, OPC opc )
 {
     UBYTE peek_byte;
     int have_peeked = 0;
-    optab_t * origin = optab;
+    const optab_dispatch_t * d;
+    const WORD * c;
+    optab_t * optab;
     
-    if ( optab == NULL )
+    if ( num < 0 )
         return 0;
+
+    d = &dispatch[num];
+    c = d->cand + d->index[opc];
         
-    while ( optab->opcode != NULL )
+    while ( *c >= 0 )
     {
-        /* printf("type:%d  ", optab->type); */
-        if ( optab->type == OPTAB_TABLE && optab->opc == opc )
+        optab = d->table + *c++;
+
+        if ( optab->type == OPTAB_TABLE )
         {
-            opc = next_insn( f, addr );
-            return walk_table( f, addr, optab->u.table, opc );
+            opc = next_insn( ctx, addr );
+            return walk_table( ctx, addr, d->link[optab - d->table], opc );
         }
-        else if ( optab->type == OPTAB_UNDEF && opc == optab->opc )
+        else if ( optab->type == OPTAB_UNDEF )
         {
             return INSN_NOT_FOUND;
         }
-        else if ( ( optab->type == OPTAB_INSN && opc == optab->opc )
-                    ||
-                    ( optab->type == OPTAB_RANGE 
-                      && opc >= optab->u.range.min 
-                      && opc <= optab->u.range.max )
-                    ||
-                    ( optab->type == OPTAB_MASK 
-                      && ( ( opc & optab->u.mask.mask ) == optab->u.mask.val ) ) )
+        else if ( optab->type == OPTAB_INSN
+                  || optab->type == OPTAB_RANGE
+                  || optab->type == OPTAB_MASK )
         {
-            opcode( optab->opcode );
-            optab->operands( f, addr, opc, optab->xtype );
+            ctx->flow_stop = optab->flow_stop;
+            opcode( ctx, optab->opcode );
+            optab->operands( ctx, addr, opc, optab->xtype );
             return INSN_FOUND;
         }
-        else if ( optab->type == OPTAB_MASK2 && opc == optab->opc )
+        else if ( optab->type == OPTAB_MASK2 )
         {
             if ( !have_peeked )
             {
-                peek_byte = peek( f );
+                peek_byte = peek( ctx );
                 have_peeked = 1;
             }
             
             if ( ( peek_byte & optab->u.mask.mask ) == optab->u.mask.val )
             {
-                opcode( optab->opcode );
-                optab->operands( f, addr, opc, optab->xtype );
+                ctx->flow_stop = optab->flow_stop;
+                opcode( ctx, optab->opcode );
+                optab->operands( ctx, addr, opc, optab->xtype );
                 return INSN_FOUND;
             }
         }
-        else if ( optab->type == OPTAB_MEMMOD 
-                  && ( opc == 0x16 || opc == 0x17 || opc == 0x06 || opc == 0x0A ) )
+        else if ( optab->type == OPTAB_MEMMOD )
         {
             if ( !have_peeked )
             {
-                peek_byte = peek( f );
+                peek_byte = peek( ctx );
                 have_peeked = 1;
             }
             
             if ( ( peek_byte & 0x8F ) == optab->opc )
             {
-                opcode( optab->opcode );
-                optab->operands( f, addr, opc, optab->xtype );
+                ctx->flow_stop = optab->flow_stop;
+                opcode( ctx, optab->opcode );
+                optab->operands( ctx, addr, opc, optab->xtype );
                 return INSN_FOUND;
             }        
         }
-        else if ( optab->type == OPTAB_PUSHTBL && optab->opc == opc )
+        else if ( optab->type == OPTAB_PUSHTBL )
         {
             int n = optab->u.pushtbl.n;
             while (n--)
-                stack_push( next_insn( f, addr ) );
-            opc = next_insn( f, addr );
-            return walk_table( f, addr, optab->u.pushtbl.table, opc );
+                stack_push( ctx, next_insn( ctx, addr ) );
+            opc = next_insn( ctx, addr );
+            return walk_table( ctx, addr, d->link[optab - d->table], opc );
         }
-        else if ( optab->type == OPTAB_PREFIX && optab->opc == opc )
+        else if ( optab->type == OPTAB_PREFIX )
         {
-            optab->operands( f, addr, opc, optab->xtype );
-            opc = next_insn( f, addr );
-            optab = origin - 1;
+            optab->operands( ctx, addr, opc, optab->xtype );
+            opc = next_insn( ctx, addr );
+            c = d->cand + d->index[opc];
         }
-        
-        optab++;
     }
     
     return INSN_NOT_FOUND;
 }
 
+/***********************************************************
+ *
+ * FUNCTION
+ *      bind_static_tables
+ *
+ * DESCRIPTION
+ *      Loads the dispatch tables generated at build time and
+ *       binds each one to its op table, following the chain of
+ *       referring entries from base_optab.
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+static void bind_static_tables( void )
+{
+    int i;
+
+    if ( optab_static_count > MAX_DISPATCH )
+        error( "INTERNAL ERROR: too many op tables.\n" );
+
+    for ( i = 0; i < optab_static_count; i++ )
+    {
+        optab_t *parent;
+
+        dispatch[i] = optab_static_dispatch[i];
+
+        if ( dispatch[i].parent < 0 )
+        {
+            dispatch[i].table = base_optab;
+            continue;
+        }
+
+        parent = &dispatch[dispatch[i].parent].table[dispatch[i].entry];
+        dispatch[i].table = parent->type == OPTAB_PUSHTBL
+                            ? parent->u.pushtbl.table
+                            : parent->u.table;
+    }
+
+    n_dispatch = optab_static_count;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      prepare_tables
+ *
+ * DESCRIPTION
+ *      Sets up the dispatch tables, from those generated at
+ *       build time if present.  Run once only.
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+static void prepare_tables( void )
+{
+    if ( optab_static_count > 0 )
+        bind_static_tables();
+    else
+        compile_table( base_optab, -1, -1 );
+}
+
 /*****************************************************************************
  *        Public Functions
  *****************************************************************************/
@@ -233,19 +463,19 @@ static int walk_table( FILE * f, ADDR * addr, optab_t * optab, OPC opc )
  *      stack_push
  *
  * DESCRIPTION
- *      Push a single opcode onto an internal stack
+ *      Push a single opcode onto the context's opcode stack
  *
  * RETURNS
  *      none
  *
  ************************************************************/
  
-void stack_push( OPC opc )
+void stack_push( dasm_ctx_t *ctx, OPC opc )
 {
-    if ( tos >= STACK_DEPTH )
+    if ( ctx->tos >= DASM_STACK_DEPTH - 1 )
         error( "Internal disassembler error" );
 	
-    opcstack[++tos] = opc;
+    ctx->opcstack[++ctx->tos] = opc;
 }
 
 /***********************************************************
@@ -254,49 +484,76 @@ void stack_push( OPC opc )
  *      stack_pop
  *
  * DESCRIPTION
- *      Pop a single opcode off an internal stack
+ *      Pop a single opcode off the context's opcode stack
  *
  * RETURNS
  *      The opcode byte from the top of stack.
  *
  ************************************************************/
  
-OPC stack_pop( void )
+OPC stack_pop( dasm_ctx_t *ctx )
 {
-    if ( tos < 0 )
+    if ( ctx->tos < 0 )
     {
         error( "Internal disassembler error" );
         return 0;
     }
         
-    return opcstack[tos--];
+    return ctx->opcstack[ctx->tos--];
 }
 
 /***********************************************************
  *
  * FUNCTION
- *      operand
+ *      operand_text
  *
  * DESCRIPTION
  *      Writes the given operand string and any arguments
- *      into the output buffer.  The string is processed with
- *      the usual printf() conversions.
+ *      into the context's output buffer.  The string is
+ *      processed with the usual printf() conversions.
+ *      Decoders call it through the operand() macro.
  *
  * RETURNS
  *      none
  *
  ************************************************************/
  
-void operand( const char *operand, ... )
+void operand_text( dasm_ctx_t *ctx, const char *operand, ... )
 {
     va_list ap;
     int n;
     
     va_start( ap, operand );
-    n = vsprintf( output_buffer, operand, ap );
+    n = vsprintf( ctx->outbuf, operand, ap );
     va_end( ap );
     
-    output_buffer += n;
+    ctx->outbuf += n;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      optab_compile
+ *
+ * DESCRIPTION
+ *      Prepares the dispatch tables for base_optab and all of its
+ *       sub-tables.  Tables generated at build time are used if
+ *       they were linked in, otherwise they are compiled here.
+ *      tables - if not NULL, set to point to the first table
+ *
+ * RETURNS
+ *      number of dispatch tables
+ *
+ ************************************************************/
+
+int optab_compile( const optab_dispatch_t ** tables )
+{
+    pthread_once( &dispatch_once, prepare_tables );
+
+    if ( tables )
+        *tables = dispatch;
+
+    return n_dispatch;
 }
 
 /***********************************************************
@@ -306,8 +563,10 @@ void operand( const char *operand, ... )
  *
  * DESCRIPTION
  *      Disassembles the next instruction in the input stream.
- *      f      - file stream to read (pass to calls to next() )
- *      outbuf - pointer to output buffer
+ *      ctx    - decoder context (pass to calls to next() )
+ *      outbuf - pointer to output buffer, or NULL to decode
+ *               only: the length and xrefs are worked out
+ *               but no text is written
  *      addr   - address of first input byte for this insn
  *
  * RETURNS
@@ -315,26 +574,34 @@ void operand( const char *operand, ... )
  *
  ************************************************************/
  
-ADDR dasm_insn( FILE *f, char *outbuf, ADDR addr )
+ADDR dasm_insn( dasm_ctx_t *ctx, char *outbuf, ADDR addr )
 {
     OPC opc;
     int found = 0;
 
-    /* Store start address in a global for use in xref calls */    
-    g_insn_addr = addr;
+    /* Set up the op tables on first use */
+    optab_compile( NULL );
+
+    /* Store start address in the context for use in xref calls */    
+    ctx->insn_addr = addr;
     
-    /* Setup g_output_buffer to point to caller's output buffer */
-    output_buffer = outbuf;
+    /* Point the context at the caller's output buffer */
+    ctx->outbuf    = outbuf;
+    ctx->undefined = 0;
+    ctx->flow_stop = 0;
 
     /* Get first opcode byte */
-    opc = next_insn( f, &addr );
+    opc = next_insn( ctx, &addr );
 
     /* Now walk table(s) looking for an instruction match */
-    found = walk_table( f, &addr, base_optab, opc );
+    found = walk_table( ctx, &addr, 0, opc );
     
     /* If we didn't find a match, indicate this to the output */
     if ( found != INSN_FOUND )
-        opcode( "???" );
+    {
+        ctx->undefined = 1;
+        opcode( ctx, "???" );
+    }
     
     return addr;
 }
@@ -41,8 +41,9 @@
 typedef struct optab_s {
     OPC opc;
     const char * opcode;
-    void (*operands)( FILE *, ADDR *, OPC, XREF_TYPE); /* operand function */
+    void (*operands)( dasm_ctx_t *, ADDR *, OPC, XREF_TYPE); /* operand function */
     XREF_TYPE xtype;
+    int flow_stop;      /* execution does not carry on to the next insn */
     enum {
         OPTAB_UNDEF,
         OPTAB_INSN,
@@ -69,6 +70,31 @@ typedef struct optab_s {
     } u;
 } optab_t;
 
+/**
+    The optab_dispatch_t type is the compiled form of an op table.  For
+    every possible opcode value index[] gives the offset into cand[] of
+    a list of the entries which may match that opcode, in table order
+    and terminated by -1.  The list stops at the first entry that matches
+    unconditionally, so only MASK2 and MEMMOD entries (which also depend
+    on the following byte) can be followed by further candidates.
+    For TABLE and PUSHTBL entries link[] gives the number of the compiled
+    sub-table; it is -1 for all other entries.
+
+    Sub-tables are identified by the table and entry which first refer to
+    them, so that statically generated dispatch tables (see optabgen.c)
+    can be bound to the decoder's op tables at run time.
+**/
+typedef struct optab_dispatch_s {
+    optab_t      * table;     /* source op table                      */
+    unsigned int   nopc;      /* number of opcode values              */
+    const ULWORD * index;     /* opcode -> offset into cand[]         */
+    const WORD   * cand;      /* candidate entry lists                */
+    const WORD   * link;      /* entry -> sub-table dispatch, or -1   */
+    ULWORD         ncand;     /* number of elements in cand[]         */
+    int            parent;    /* dispatch referring to this table     */
+    int            entry;     /*  ... and the entry within it         */
+} optab_dispatch_t;
+
 /**
     Macros to construct entries in op tables.
 **/
@@ -162,6 +188,50 @@ typedef struct optab_s {
       .u.mask.val  = M_val                                  \
     },
                                                             
+/**
+    Instructions after which execution does not carry on to the next one
+    (unconditional jumps, returns).  Code discovery stops at these.
+**/
+#define INSN_STOP(M_opcode, M_ops, M_opc, M_xt)  \
+    { .type      = OPTAB_INSN,                   \
+      .opc       = M_opc,                        \
+      .opcode    = M_opcode,                     \
+      .operands  = operand_ ## M_ops,            \
+      .xtype     = M_xt,                         \
+      .flow_stop = 1                             \
+    },
+
+#define RANGE_STOP(M_opcode, M_ops, M_min, M_max, M_xt)  \
+    { .type      = OPTAB_RANGE,                          \
+      .opcode    = M_opcode,                             \
+      .operands  = operand_ ## M_ops,                    \
+      .xtype     = M_xt,                                 \
+      .flow_stop = 1,                                    \
+      .u.range.min = M_min,                              \
+      .u.range.max = M_max                               \
+    },
+
+#define MASK_STOP(M_opcode, M_ops, M_mask, M_val, M_xt)  \
+    { .type      = OPTAB_MASK,                           \
+      .opcode    = M_opcode,                             \
+      .operands  = operand_ ## M_ops,                    \
+      .xtype     = M_xt,                                 \
+      .flow_stop = 1,                                    \
+      .u.mask.mask = M_mask,                             \
+      .u.mask.val  = M_val                               \
+    },
+
+#define MASK2_STOP(M_opcode, M_ops, M_opc, M_mask, M_val, M_xt)  \
+    { .type      = OPTAB_MASK2,                                  \
+      .opcode    = M_opcode,                                     \
+      .opc       = M_opc,                                        \
+      .operands  = operand_ ## M_ops,                            \
+      .xtype     = M_xt,                                         \
+      .flow_stop = 1,                                            \
+      .u.mask.mask = M_mask,                                     \
+      .u.mask.val  = M_val                                       \
+    },
+
 /**
     A MEMMOD describes an instruction with four memory-modifer combinations
     which must be decoded together for a prospective match.
@@ -183,16 +253,16 @@ typedef struct optab_s {
     Create operand function definition given a name.
 **/
 #define OPERAND_FUNC(M_name) \
-    static void operand_ ## M_name (FILE *f, ADDR * addr, OPC opc, XREF_TYPE xtype )
+    static void operand_ ## M_name (dasm_ctx_t *ctx, ADDR * addr, OPC opc, XREF_TYPE xtype )
     
 /**
     Create prefix function definition given a name.
 **/
 #define PREFIX_FUNC(M_name) \
-    static void prefix_ ## M_name (FILE *f, ADDR * addr, OPC opc, XREF_TYPE xtype )
+    static void prefix_ ## M_name (dasm_ctx_t *ctx, ADDR * addr, OPC opc, XREF_TYPE xtype )
 
 /* Neaten up emitting a comma "," within an operand. */
-#define COMMA                   operand( ", " )
+#define COMMA                   operand( ctx, ", " )
 
 /**
     Short-cut macro to generate simple two-operand functions.
@@ -200,9 +270,9 @@ typedef struct optab_s {
 #define TWO_OPERAND(M_a,M_b) \
 OPERAND_FUNC(M_a ## _ ## M_b) \
 { \
-      operand_ ## M_a (f, addr, opc, xtype); \
+      operand_ ## M_a (ctx, addr, opc, xtype); \
       COMMA; \
-      operand_ ## M_b (f, addr, opc, xtype); \
+      operand_ ## M_b (ctx, addr, opc, xtype); \
 }
 
 /**
@@ -218,25 +288,31 @@ TWO_OPERAND(P_b, P_a)
 #define THREE_OPERAND(M_a,M_b,M_c) \
 OPERAND_FUNC(M_a ## _ ## M_b ## _ ## M_c) \
 { \
-      operand_ ## M_a (f, addr, opc, xtype); \
+      operand_ ## M_a (ctx, addr, opc, xtype); \
       COMMA; \
-      operand_ ## M_b (f, addr, opc, xtype); \
+      operand_ ## M_b (ctx, addr, opc, xtype); \
       COMMA; \
-      operand_ ## M_c (f, addr, opc, xtype); \
+      operand_ ## M_c (ctx, addr, opc, xtype); \
 }
 
 /* Create a single-bit mask */
 #define BIT(n)                  ( 1 << (n) )
 
-/* General function for outputting an operand */
-extern void operand( const char * operand, ... );
+/* General function for outputting an operand, called by operand() */
+extern void operand_text( dasm_ctx_t *ctx, const char * operand, ... );
+
+/* Push and pop opcodes to the context's opcode stack */
+extern void stack_push( dasm_ctx_t *ctx, OPC );
+extern OPC  stack_pop( dasm_ctx_t *ctx );
 
-/* Push and pop opcodes to an internal stack */
-extern void stack_push( OPC );
-extern OPC  stack_pop( void );
+/* Compile the op tables, returning the number of tables and a pointer to
+ * the first.  Static tables are used if present.
+ */
+extern int optab_compile( const optab_dispatch_t ** tables );
 
-/* Start address of each instruction as it is decoded. */
-extern ADDR g_insn_addr;
+/* Dispatch tables generated at build time by optabgen, if any. */
+extern const optab_dispatch_t optab_static_dispatch[];
+extern const int              optab_static_count;
 
 #endif /* _OPTAB_H_ */
 
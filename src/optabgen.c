@@ -0,0 +1,254 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * optabgen - generate static dispatch tables for a table-driven decoder
+ *
+ * Usage:
+ *    optabgenXX > dispatchXX.c
+ *
+ * Each optabgen is linked with one decoder.  It compiles that decoder's
+ * base_optab and all of its sub-tables (see optab.c) and writes them out as
+ * C source, which is then compiled into the disassembler in place of the
+ * run-time table compiler.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "dasmxx.h"
+#include "optab.h"
+
+/*****************************************************************************
+ * Private data types, macros, constants.
+ *****************************************************************************/
+
+/* Number of array elements emitted per line */
+#define PER_LINE        ( 12 )
+
+/*****************************************************************************
+ * Global data.
+ *****************************************************************************/
+
+/* No static tables here, so optab_compile() builds them at run time. */
+const optab_dispatch_t optab_static_dispatch[1] = { { .table = NULL } };
+const int              optab_static_count = 0;
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      emit_ulwords
+ *      emit_words
+ *
+ * DESCRIPTION
+ *      Writes out a named static const array.
+ *
+ * RETURNS
+ *      none
+ *
+ ************************************************************/
+
+static void emit_ulwords( const char *name, int num, const ULWORD *v, size_t n )
+{
+    size_t i;
+
+    printf( "static const ULWORD %s_%d[%lu] = {", name, num, (unsigned long)n );
+    for ( i = 0; i < n; i++ )
+        printf( "%s%lu,", i % PER_LINE ? " " : "\n    ", (unsigned long)v[i] );
+    printf( "\n};\n\n" );
+}
+
+static void emit_words( const char *name, int num, const WORD *v, size_t n )
+{
+    size_t i;
+
+    printf( "static const WORD %s_%d[%lu] = {", name, num, (unsigned long)n );
+    for ( i = 0; i < n; i++ )
+        printf( "%s%d,", i % PER_LINE ? " " : "\n    ", v[i] );
+    printf( "\n};\n\n" );
+}
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      error
+ *      warning
+ *      zalloc
+ *      dupstr
+ *      next
+ *      nextw
+ *      peek
+ *      dasm_addxref
+ *
+ * DESCRIPTION
+ *      Minimal versions of the dasmxx.c support functions needed
+ *       to link the decoder.  No input is ever decoded here.
+ *
+ ************************************************************/
+
+void error( char *fmt, ... )
+{
+    va_list ap;
+
+    va_start( ap, fmt );
+    fprintf ( stderr, "optabgen :: Error :: " );
+    vfprintf( stderr, fmt, ap );
+    fprintf ( stderr, "\n" );
+    va_end( ap );
+
+    exit( EXIT_FAILURE );
+}
+
+void warning( char *fmt, ... )
+{
+    va_list ap;
+
+    va_start( ap, fmt );
+    fprintf ( stderr, "optabgen :: Warning :: " );
+    vfprintf( stderr, fmt, ap );
+    fprintf ( stderr, "\n" );
+    va_end( ap );
+}
+
+void *zalloc( size_t n )
+{
+    void *p = calloc( 1, n );
+
+    if ( !p )
+        error( "Out of memory" );
+
+    return p;
+}
+
+char * dupstr( const char *s )
+{
+    char *p = strdup( s );
+
+    if ( !p )
+        error( "Out of memory" );
+
+    return p;
+}
+
+UBYTE next( dasm_ctx_t *ctx, ADDR *addr )
+{
+    error( "INTERNAL ERROR: no input to decode" );
+    return 0;
+}
+
+UWORD nextw( dasm_ctx_t *ctx, ADDR *addr )
+{
+    error( "INTERNAL ERROR: no input to decode" );
+    return 0;
+}
+
+UBYTE peek( dasm_ctx_t *ctx )
+{
+    error( "INTERNAL ERROR: no input to decode" );
+    return 0;
+}
+
+void dasm_addxref( dasm_ctx_t *ctx, XREF_TYPE type, ADDR addr, ADDR ref )
+{
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      main
+ *
+ * DESCRIPTION
+ *      Compiles the op tables and writes them to stdout.
+ *
+ * RETURNS
+ *      EXIT_SUCCESS
+ *
+ ************************************************************/
+
+int main( int argc, char *argv[] )
+{
+    const optab_dispatch_t *d;
+    int n, i, n_entries;
+
+    n = optab_compile( &d );
+
+    printf( "/* Dispatch tables for %s -- generated by optabgen, do not edit. */\n\n",
+            dasm_name );
+    printf( "#include <stdio.h>\n\n" );
+    printf( "#include \"dasmxx.h\"\n" );
+    printf( "#include \"optab.h\"\n\n" );
+
+    for ( i = 0; i < n; i++ )
+    {
+        for ( n_entries = 0; d[i].table[n_entries].opcode != NULL; n_entries++ )
+            ;
+
+        emit_ulwords( "dispatch_index", i, d[i].index, d[i].nopc );
+        emit_words  ( "dispatch_cand",  i, d[i].cand,  d[i].ncand );
+        emit_words  ( "dispatch_link",  i, d[i].link,  n_entries + 1 );
+    }
+
+    printf( "const optab_dispatch_t optab_static_dispatch[%d] = {\n", n );
+    for ( i = 0; i < n; i++ )
+    {
+        printf( "    { .table  = NULL,\n" );
+        printf( "      .nopc   = %u,\n", d[i].nopc );
+        printf( "      .index  = dispatch_index_%d,\n", i );
+        printf( "      .cand   = dispatch_cand_%d,\n", i );
+        printf( "      .link   = dispatch_link_%d,\n", i );
+        printf( "      .ncand  = %lu,\n", (unsigned long)d[i].ncand );
+        printf( "      .parent = %d,\n", d[i].parent );
+        printf( "      .entry  = %d\n", d[i].entry );
+        printf( "    },\n" );
+    }
+    printf( "};\n\n" );
+
+    printf( "const int optab_static_count = %d;\n", n );
+
+    return EXIT_SUCCESS;
+}
+
+/*****************************************************************************/
+/*****************************************************************************/
+/*****************************************************************************/
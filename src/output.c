@@ -0,0 +1,694 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Listing output
+ *
+ * All listing text is appended to a large private buffer by the out_*()
+ *  functions below and handed to stdout in one write when the buffer
+ *  fills or is explicitly flushed.  Numeric fields are formatted by hand
+ *  rather than through printf().
+ *
+ * Pagination is handled here too: out_newline() counts lines and emits
+ *  a form feed and page header when a page fills.
+ *
+ * A thread can instead capture its output into a growing memory buffer
+ *  (out_capture_begin()).  Captured text records where each counted
+ *  newline fell so that out_capture_write() can later replay it into the
+ *  listing with the pagination it would have had.
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Data Types, Macros, Constants
+ *****************************************************************************/
+
+#define OUT_BUF_SIZE        ( 256 * 1024 )
+
+/* Initial size of a capture buffer */
+#define CAPTURE_INIT_SIZE   ( 64 * 1024 )
+
+/* Make sure there are at least M_n bytes free in the buffer */
+#define OUT_ROOM(M_n)       do {\
+                                if ( (size_t)( outend - outp ) < (size_t)(M_n) )\
+                                    make_room( (size_t)(M_n) );\
+                            } while(0)
+
+/*****************************************************************************
+ *        Private Data
+ *****************************************************************************/
+
+static char  outbuf[OUT_BUF_SIZE];
+
+/* Where the current thread's output goes: the listing buffer, or the
+ * text of its capture.
+ */
+static THREAD_LOCAL char *outbase = outbuf;
+static THREAD_LOCAL char *outp    = outbuf;
+static THREAD_LOCAL char *outend  = outbuf + OUT_BUF_SIZE;
+static THREAD_LOCAL out_capture_t *capture = NULL;
+
+/* Bytes handed to stdout by previous flushes */
+static THREAD_LOCAL unsigned long out_flushed = 0;
+
+static const char hexdigits[] = "0123456789ABCDEF";
+
+/* Pagination */
+static int          lines_per_page = 0;
+static int          line_no        = 0;
+static int          page_no        = 1;
+static const char * page_title     = NULL;
+
+/* Addresses are written with their bank, set by out_setbanked() */
+static int          banked_addrs   = 0;
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      make_room
+ *
+ * DESCRIPTION
+ *      Makes at least n bytes free in the output buffer, by
+ *       flushing the listing buffer or by growing the capture
+ *       buffer.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void make_room( size_t n )
+{
+    size_t used, size;
+
+    if ( !capture )
+    {
+        out_flush();
+        return;
+    }
+
+    used = outp - outbase;
+    size = outend - outbase;
+    while ( size - used < n )
+        size *= 2;
+
+    outbase = realloc( outbase, size );
+    if ( !outbase )
+        error( "Out of memory" );
+
+    capture->text = outbase;
+    outp   = outbase + used;
+    outend = outbase + size;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      count_line
+ *
+ * DESCRIPTION
+ *      Counts a newline just written and starts a new page
+ *       when the current one is full.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void count_line( void )
+{
+    if ( lines_per_page && ++line_no >= lines_per_page )
+    {
+        line_no = 0;
+        out_char( '\f' );
+        out_page_header();
+    }
+}
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_flush
+ *
+ * DESCRIPTION
+ *      Writes the contents of the output buffer to stdout.
+ *      Captured output is kept until out_capture_write().
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_flush( void )
+{
+    size_t n;
+
+    if ( capture )
+        return;
+
+    n = outp - outbuf;
+
+    outp = outbuf;
+    out_flushed += n;
+
+    if ( n && fwrite( outbuf, 1, n, stdout ) != n )
+        error( "Failed to write output" );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_count
+ *
+ * DESCRIPTION
+ *      Total number of characters output so far.  The
+ *       difference between two calls gives the width of
+ *       whatever was emitted in between.
+ *
+ * RETURNS
+ *      character count
+ *
+ ************************************************************/
+
+unsigned long out_count( void )
+{
+    return out_flushed + ( outp - outbase );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_char
+ *
+ * DESCRIPTION
+ *      Output a single character.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_char( int c )
+{
+    OUT_ROOM( 1 );
+    *outp++ = (char)c;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_strn
+ *
+ * DESCRIPTION
+ *      Output n characters of a string.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_strn( const char *s, size_t n )
+{
+    while ( n )
+    {
+        size_t room;
+
+        OUT_ROOM( 1 );
+        room = MIN( n, (size_t)( outend - outp ) );
+        memcpy( outp, s, room );
+        outp += room;
+        s    += room;
+        n    -= room;
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_str
+ *
+ * DESCRIPTION
+ *      Output a nul-terminated string.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_str( const char *s )
+{
+    out_strn( s, strlen( s ) );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_spaces
+ *
+ * DESCRIPTION
+ *      Output n spaces.  Does nothing if n <= 0.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_spaces( int n )
+{
+    while ( n > 0 )
+    {
+        int room;
+
+        OUT_ROOM( 1 );
+        room = (int)MIN( (size_t)n, (size_t)( outend - outp ) );
+        memset( outp, ' ', room );
+        outp += room;
+        n    -= room;
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_padstr
+ *
+ * DESCRIPTION
+ *      Output a string padded with spaces to the given field
+ *       width, as for printf( "%*s" ).  A positive width
+ *       right-justifies, a negative width left-justifies.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_padstr( const char *s, int width )
+{
+    int len = (int)strlen( s );
+
+    if ( width >= 0 )
+    {
+        out_spaces( width - len );
+        out_strn( s, len );
+    }
+    else
+    {
+        out_strn( s, len );
+        out_spaces( -width - len );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_hex
+ *
+ * DESCRIPTION
+ *      Output an unsigned value in upper-case hex, zero-padded
+ *       to at least the given number of digits, as for
+ *       printf( "%0*X" ).
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_hex( unsigned long v, int digits )
+{
+    char tmp[sizeof(v) * 2];
+    int  n = 0;
+
+    do {
+        tmp[n++] = hexdigits[v & 0xF];
+        v >>= 4;
+    } while ( v );
+
+    OUT_ROOM( MAX( n, digits ) );
+
+    for ( ; digits > n; digits-- )
+        *outp++ = '0';
+
+    while ( n )
+        *outp++ = tmp[--n];
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_addr
+ *
+ * DESCRIPTION
+ *      Output an address in the universal address format, or
+ *       as BB:XXXX in a banked address space.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_addr( ADDR addr )
+{
+    if ( banked_addrs )
+    {
+        out_hex( BANK_OF( addr ), 2 );
+        out_char( ':' );
+        addr = BANK_CPU( addr );
+    }
+    out_hex( addr, dasm_addr_digits );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_addrstr
+ *
+ * DESCRIPTION
+ *      Formats an address as out_addr() writes it, for a
+ *       message, into buf, which is size bytes long.
+ *       OUT_ADDRSTR() supplies the buffer.
+ *
+ * RETURNS
+ *      buf
+ *
+ ************************************************************/
+
+char *out_addrstr( char *buf, size_t size, ADDR addr )
+{
+    if ( banked_addrs )
+        snprintf( buf, size, "%02X:" FORMAT_ADDR,
+                  BANK_OF( addr ), ADDR_DIGITS, BANK_CPU( addr ) );
+    else
+        snprintf( buf, size, FORMAT_ADDR, ADDR_DIGITS, addr );
+
+    return buf;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_setbanked
+ *
+ * DESCRIPTION
+ *      Sets whether out_addr() writes the bank of addresses.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_setbanked( int banked )
+{
+    banked_addrs = banked;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_printf
+ *
+ * DESCRIPTION
+ *      Formatted output for the occasional field that the
+ *       functions above do not cover.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_printf( const char *fmt, ... )
+{
+    va_list ap;
+    int n;
+
+    OUT_ROOM( 256 );
+
+    va_start( ap, fmt );
+    n = vsnprintf( outp, outend - outp, fmt, ap );
+    va_end( ap );
+
+    if ( n < 0 )
+        error( "Failed to format output" );
+
+    if ( (size_t)n < (size_t)( outend - outp ) )
+    {
+        outp += n;
+        return;
+    }
+
+    /* Did not fit: a capture grows to fit, otherwise flush and go
+     * straight to stdout.
+     */
+    if ( capture )
+    {
+        make_room( (size_t)n + 1 );
+        va_start( ap, fmt );
+        vsnprintf( outp, outend - outp, fmt, ap );
+        va_end( ap );
+        outp += n;
+        return;
+    }
+
+    out_flush();
+    va_start( ap, fmt );
+    n = vfprintf( stdout, fmt, ap );
+    va_end( ap );
+
+    if ( n < 0 )
+        error( "Failed to write output" );
+    out_flushed += n;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_paginate
+ *
+ * DESCRIPTION
+ *      Enable pagination with the given number of lines per
+ *       page (0 disables) and optional page title.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_paginate( int lines, const char *title )
+{
+    lines_per_page = lines;
+    page_title     = title;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_page_header
+ *
+ * DESCRIPTION
+ *      Output page header, comprising a page number and an
+ *      optional title.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_page_header( void )
+{
+    if ( lines_per_page )
+    {
+        out_str( COMMENT_DELIM " Page " );
+        out_printf( "%d", page_no++ );
+        if ( page_title )
+        {
+            out_str( " -- " );
+            out_str( page_title );
+        }
+        out_str( "\n\n" );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_newline
+ *
+ * DESCRIPTION
+ *      Output a newline.  Also do pagination if required.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_newline( void )
+{
+    out_char( '\n' );
+
+    if ( capture )
+    {
+        if ( capture->nlines == capture->lines_size )
+        {
+            capture->lines_size = capture->lines_size ? 2 * capture->lines_size : 1024;
+            capture->lines = realloc( capture->lines,
+                                      capture->lines_size * sizeof( size_t ) );
+            if ( !capture->lines )
+                error( "Out of memory" );
+        }
+        capture->lines[capture->nlines++] = outp - outbase;
+    }
+    else
+        count_line();
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_capture_begin
+ *
+ * DESCRIPTION
+ *      Starts capturing the calling thread's output into cap.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_capture_begin( out_capture_t *cap )
+{
+    memset( cap, 0, sizeof( *cap ) );
+    cap->text = zalloc( CAPTURE_INIT_SIZE );
+
+    capture     = cap;
+    outbase     = cap->text;
+    outp        = outbase;
+    outend      = outbase + CAPTURE_INIT_SIZE;
+    out_flushed = 0;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_capture_end
+ *
+ * DESCRIPTION
+ *      Stops capturing output.  The calling thread's output
+ *       goes to the listing again.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_capture_end( void )
+{
+    if ( !capture )
+        return;
+
+    capture->len = outp - outbase;
+    capture      = NULL;
+
+    outbase     = outbuf;
+    outp        = outbuf;
+    outend      = outbuf + OUT_BUF_SIZE;
+    out_flushed = 0;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_capture_write
+ *
+ * DESCRIPTION
+ *      Appends captured output to the listing, paginating
+ *       at each counted newline as out_newline() would have.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_capture_write( const out_capture_t *cap )
+{
+    size_t pos = 0, i;
+
+    if ( lines_per_page )
+    {
+        for ( i = 0; i < cap->nlines; i++ )
+        {
+            out_strn( cap->text + pos, cap->lines[i] - pos );
+            pos = cap->lines[i];
+            count_line();
+        }
+    }
+
+    out_strn( cap->text + pos, cap->len - pos );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      out_capture_free
+ *
+ * DESCRIPTION
+ *      Releases the memory held by a capture.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void out_capture_free( out_capture_t *cap )
+{
+    free( cap->text );
+    free( cap->lines );
+    memset( cap, 0, sizeof( *cap ) );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
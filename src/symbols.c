@@ -0,0 +1,492 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026, Neil Johnson
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms,
+ * with or without modification,
+ * are permitted provided that the following conditions are met:
+ * 
+ * * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * * Neither the name of Neil Johnson nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *****************************************************************************/
+
+/*****************************************************************************
+ *
+ * Symbol file import
+ *
+ * Reads the symbols from a linker map or symbol table so that they can be
+ *  added to the xref database in one batch by xref_addlabels().  The file
+ *  is mapped with the command file reader and the names are taken from it
+ *  in place; xref_addlabels() copies the ones it keeps.
+ *
+ * The formats understood are:
+ *
+ *      ELF         .symtab (or .dynsym) of a 32- or 64-bit ELF file of
+ *                   either byte order, found by its magic number
+ *      GNU ld map  *.map: "0x<value>  <symbol>" lines of the memory map
+ *      NoICE       *.sym, *.noi: "DEF <symbol> <value>" lines
+ *      CSV         *.csv: "<symbol>,<value>" lines; other columns, and
+ *                   lines without a value (such as a header), are ignored
+ *
+ * Values are in hex, with or without a leading "0x".
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "dasmxx.h"
+
+/*****************************************************************************
+ *        Data Types, Macros, Constants
+ *****************************************************************************/
+
+/* Symbols read so far */
+struct symtab {
+    xref_label_t   *item;
+    size_t          n;
+    size_t          size;
+};
+
+/* Initial size of a symbol table */
+#define SYMTAB_INIT     ( 1024 )
+
+/* ELF constants (see also dasmxx.h) */
+#define SHT_SYMTAB      2
+#define SHT_DYNSYM      11
+#define STT_SECTION     3
+#define STT_FILE        4
+#define SHN_UNDEF       0
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      sym_add
+ *
+ * DESCRIPTION
+ *      Adds a symbol to the table.  The name is not copied.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void sym_add( struct symtab *st, unsigned long value, char *name )
+{
+    if ( st->n == st->size )
+    {
+        st->size = st->size ? st->size * 2 : SYMTAB_INIT;
+        st->item = realloc( st->item, st->size * sizeof( xref_label_t ) );
+        if ( !st->item )
+            error( "Out of memory for symbol table" );
+    }
+
+    st->item[st->n].ref   = (ADDR)value;
+    st->item[st->n].label = name;
+    st->n++;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      skip_space
+ *
+ * DESCRIPTION
+ *      Moves past blanks.
+ *
+ * RETURNS
+ *      pointer to first non-blank character
+ *
+ ************************************************************/
+
+static char *skip_space( char *p )
+{
+    while ( *p == ' ' || *p == '\t' || *p == '\r' )
+        p++;
+    return p;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      scan_symbol
+ *
+ * DESCRIPTION
+ *      Moves past a symbol name: a letter, '_', '.' or '$'
+ *       followed by any of those or digits.
+ *
+ * RETURNS
+ *      pointer to first character after the name, which is
+ *       p itself if there is no name there
+ *
+ ************************************************************/
+
+static char *scan_symbol( char *p )
+{
+    if ( !isalpha( (unsigned char)*p ) && *p != '_' && *p != '.' && *p != '$' )
+        return p;
+
+    while ( isalnum( (unsigned char)*p ) || *p == '_' || *p == '.' || *p == '$' )
+        p++;
+
+    return p;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      read_ldmap
+ *
+ * DESCRIPTION
+ *      Reads the symbols from a GNU ld map file.  These are
+ *       the lines made up of just an indented hex value
+ *       and a name; section lines and assignments are
+ *       skipped.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void read_ldmap( cmdfile_t *cf, struct symtab *st )
+{
+    char *line, *p, *name, *end;
+    unsigned long value;
+
+    while ( ( line = cmdfile_getline( cf ) ) != NULL )
+    {
+        if ( *line != ' ' && *line != '\t' )
+            continue;
+
+        p = skip_space( line );
+        if ( p[0] != '0' || ( p[1] != 'x' && p[1] != 'X' ) || !cmdfile_hex( &p, &value ) )
+            continue;
+
+        name = skip_space( p );
+        end  = scan_symbol( name );
+        if ( name == p || end == name || ( end == name + 1 && *name == '.' ) )
+            continue;
+        if ( *skip_space( end ) )
+            continue;
+
+        *end = '\0';
+        sym_add( st, value, name );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      read_noice
+ *
+ * DESCRIPTION
+ *      Reads the DEF lines from a NoICE symbol file.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void read_noice( cmdfile_t *cf, struct symtab *st )
+{
+    char *line, *p, *name, *end;
+    unsigned long value;
+
+    while ( ( line = cmdfile_getline( cf ) ) != NULL )
+    {
+        p = skip_space( line );
+        if ( strncasecmp( p, "DEF", 3 ) || ( p[3] != ' ' && p[3] != '\t' ) )
+            continue;
+
+        name = skip_space( p + 3 );
+        for ( end = name; *end && *end != ' ' && *end != '\t'; end++ )
+            ;
+        if ( end == name || !*end )
+            continue;
+
+        p = end;
+        if ( !cmdfile_hex( &p, &value ) )
+            error( "%s(%u) :: Missing value for symbol \"%.*s\"",
+                   cf->name, cf->lineno, (int)( end - name ), name );
+
+        *end = '\0';
+        sym_add( st, value, name );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      csv_field
+ *
+ * DESCRIPTION
+ *      Splits the next field off a CSV line, dropping the
+ *       blanks and any double quotes around it.
+ *
+ * RETURNS
+ *      pointer to field, NUL-terminated in place; *p is
+ *       moved to the start of the next field, or NULL if
+ *       there are no more
+ *
+ ************************************************************/
+
+static char *csv_field( char **p )
+{
+    char *s = skip_space( *p ), *field, *end, *next;
+
+    if ( *s == '"' )
+    {
+        field = ++s;
+        end   = strchr( s, '"' );
+        if ( !end )
+            end = s + strlen( s );
+        next  = strchr( end, ',' );
+    }
+    else
+    {
+        field = s;
+        next  = strchr( s, ',' );
+        end   = next ? next : s + strlen( s );
+        while ( end > field && ( end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' ) )
+            end--;
+    }
+
+    *p   = next ? next + 1 : NULL;
+    *end = '\0';
+    return field;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      read_csv
+ *
+ * DESCRIPTION
+ *      Reads "symbol,value" lines from a CSV file.  Lines
+ *       whose second field is not a hex value are skipped.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void read_csv( cmdfile_t *cf, struct symtab *st )
+{
+    char *line, *p, *name, *field;
+    unsigned long value;
+
+    while ( ( line = cmdfile_getline( cf ) ) != NULL )
+    {
+        p = skip_space( line );
+        if ( *p == '#' || !*p )
+            continue;
+
+        name = csv_field( &p );
+        if ( !p || !*name )
+            continue;
+
+        field = csv_field( &p );
+        if ( !cmdfile_hex( &field, &value ) || *skip_space( field ) )
+            continue;
+
+        sym_add( st, value, name );
+    }
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      read_elf
+ *
+ * DESCRIPTION
+ *      Reads the defined symbols from the symbol table of an
+ *       ELF file, leaving out section and file symbols.
+ *      Uses the dynamic symbol table if there is no other.
+ *      A file with neither is an error if required is set.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+#define ELF_GET(M_off, M_n)     elf_get( data + (M_off), (M_n), msb )
+
+static void read_elf( cmdfile_t *cf, struct symtab *st, int required )
+{
+    const UBYTE *data = (const UBYTE *)cf->data;
+    size_t length = cf->length;
+    int is64, msb;
+    unsigned long long shoff, symoff, symsize, symentsize, stroff, strsize, off, name;
+    unsigned int shentsize, shnum, i, type, link, symsec = 0;
+    unsigned int info, shndx;
+
+    if ( length < 0x34 || ( data[EI_CLASS] != ELFCLASS32 && data[EI_CLASS] != ELFCLASS64 ) )
+        error( "%s :: Bad ELF file", cf->name );
+
+    is64 = data[EI_CLASS] == ELFCLASS64;
+    msb  = data[EI_DATA] == ELFDATA2MSB;
+
+    if ( is64 && length < 0x40 )
+        error( "%s :: Bad ELF file", cf->name );
+
+    shoff     = is64 ? ELF_GET( 0x28, 8 ) : ELF_GET( 0x20, 4 );
+    shentsize = (unsigned int)( is64 ? ELF_GET( 0x3A, 2 ) : ELF_GET( 0x2E, 2 ) );
+    shnum     = (unsigned int)( is64 ? ELF_GET( 0x3C, 2 ) : ELF_GET( 0x30, 2 ) );
+
+    if ( shnum == 0 && !required )
+        return;
+
+    if ( shentsize < ( is64 ? 64u : 40u ) || shoff > length
+         || (unsigned long long)shnum * shentsize > length - shoff )
+        error( "%s :: Bad ELF section headers", cf->name );
+
+    /* Find the symbol table, preferring the full one */
+    for ( i = 0; i < shnum; i++ )
+    {
+        type = (unsigned int)ELF_GET( shoff + (unsigned long long)i * shentsize + 4, 4 );
+        if ( type == SHT_SYMTAB || ( type == SHT_DYNSYM && !symsec ) )
+            symsec = i;
+        if ( type == SHT_SYMTAB )
+            break;
+    }
+    if ( !symsec )
+    {
+        if ( required )
+            error( "%s :: No symbol table in ELF file", cf->name );
+        return;
+    }
+
+#define SH_FIELD(M_sec, M_off32, M_off64) \
+    ( is64 ? ELF_GET( shoff + (unsigned long long)(M_sec) * shentsize + (M_off64), 8 ) \
+           : ELF_GET( shoff + (unsigned long long)(M_sec) * shentsize + (M_off32), 4 ) )
+
+    off        = shoff + (unsigned long long)symsec * shentsize;
+    symoff     = SH_FIELD( symsec, 16, 24 );
+    symsize    = SH_FIELD( symsec, 20, 32 );
+    symentsize = SH_FIELD( symsec, 36, 56 );
+    link       = (unsigned int)ELF_GET( off + ( is64 ? 40 : 24 ), 4 );
+
+    if ( link >= shnum )
+        error( "%s :: Bad ELF symbol table", cf->name );
+
+    stroff  = SH_FIELD( link, 16, 24 );
+    strsize = SH_FIELD( link, 20, 32 );
+
+#undef SH_FIELD
+
+    if ( symentsize < ( is64 ? 24u : 16u ) || symoff > length || symsize > length - symoff
+         || stroff > length || strsize > length - stroff || strsize == 0
+         || data[stroff + strsize - 1] != '\0' )
+        error( "%s :: Bad ELF symbol table", cf->name );
+
+    for ( off = symoff; off + symentsize <= symoff + symsize; off += symentsize )
+    {
+        name  = ELF_GET( off, 4 );
+        info  = data[off + ( is64 ? 4 : 12 )];
+        shndx = (unsigned int)ELF_GET( off + ( is64 ? 6 : 14 ), 2 );
+
+        if ( name == 0 || name >= strsize || shndx == SHN_UNDEF
+             || ( info & 0xF ) == STT_SECTION || ( info & 0xF ) == STT_FILE )
+            continue;
+
+        sym_add( st, (unsigned long)( is64 ? ELF_GET( off + 8, 8 ) : ELF_GET( off + 4, 4 ) ),
+                 cf->data + stroff + name );
+    }
+}
+
+#undef ELF_GET
+
+/*****************************************************************************
+ *        Public Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      sym_read
+ *
+ * DESCRIPTION
+ *      Reads the symbols from an open symbol file.  ELF files
+ *       are recognised by their contents, other formats by
+ *       the file name extension.  The names point into the
+ *       file, so are only good until it is closed.
+ *
+ * RETURNS
+ *      array of symbols, to be freed by the caller, and the
+ *       number of them in *n
+ *
+ ************************************************************/
+
+xref_label_t * sym_read( cmdfile_t *cf, size_t *n )
+{
+    struct symtab st = { NULL, 0, 0 };
+
+    if ( cf->length >= 4 && memcmp( cf->data, "\177ELF", 4 ) == 0 )
+        read_elf( cf, &st, 1 );
+    else if ( cmdfile_has_ext( cf->name, ".map" ) )
+        read_ldmap( cf, &st );
+    else if ( cmdfile_has_ext( cf->name, ".sym" ) || cmdfile_has_ext( cf->name, ".noi" ) )
+        read_noice( cf, &st );
+    else if ( cmdfile_has_ext( cf->name, ".csv" ) )
+        read_csv( cf, &st );
+    else
+        error( "%s :: Unknown symbol file format", cf->name );
+
+    *n = st.n;
+    return st.item;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      sym_read_elf
+ *
+ * DESCRIPTION
+ *      Reads the symbols from an open ELF file, as sym_read(),
+ *       but finds none rather than failing if it is stripped.
+ *
+ * RETURNS
+ *      array of symbols, to be freed by the caller, and the
+ *       number of them in *n
+ *
+ ************************************************************/
+
+xref_label_t * sym_read_elf( cmdfile_t *cf, size_t *n )
+{
+    struct symtab st = { NULL, 0, 0 };
+
+    read_elf( cf, &st, 0 );
+
+    *n = st.n;
+    return st.item;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+/******************************************************************************/
@@ -34,6 +34,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <ctype.h>
 
 #include "dasmxx.h"
 
@@ -48,17 +49,543 @@ struct addrlist {
 };
 
 struct xref {
-    struct xref     *n;
     ADDR            ref;
     char            *label;
     struct addrlist *list;
+    int             imported;   /* label came from xref_addlabels() */
 };
 
+/* One reference, for the reverse (source to target) index */
+struct xref_rev {
+    ADDR             source;
+    ADDR             target;
+    XREF_TYPE        type;
+    struct xref     *p;
+};
+
+/* Initial number of slots in the address index (must be a power of 2) */
+#define INDEX_INIT_SIZE     ( 1024 )
+
+/* Multiplicative hash of an address into the index.  The slot is taken
+ * from the top bits of the product, to which every bit of the address
+ * contributes, so addresses that differ only in their upper bits (wide
+ * address spaces, banks) do not all land in the same slot.
+ */
+#define INDEX_HASH(M_a)     ( (size_t)( ( (ULWORD)(M_a) * 2654435761u ) >> index_shift ) )
+
+
 /*****************************************************************************
- *        Global Data
+ *        Private Data
  *****************************************************************************/
 
-struct xref *xref = NULL;
+/* Open-addressed hash table holding every xref entry, keyed on the
+ * referenced address.  Entries are unordered; xref_dump() sorts them.
+ */
+static struct xref **xref_index = NULL;
+static size_t        index_size = 0;
+static size_t        index_used = 0;
+static unsigned int  index_shift = 32;  /* 32 - log2( index_size ) */
+
+/* Indexes for xref_query(), built by its first call: the entries in
+ * target address order, and every reference in source address order.
+ */
+static struct xref    **fwd_index = NULL;
+static size_t           fwd_used  = 0;
+static struct xref_rev *rev_index = NULL;
+static size_t           rev_used  = 0;
+
+/* The banked window, inclusive CPU addresses, set by xref_setbanks() */
+static int  banked  = 0;
+static ADDR bank_lo = 0;
+static ADDR bank_hi = 0;
+
+/*****************************************************************************
+ *        Private Functions
+ *****************************************************************************/
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      index_find
+ *
+ * DESCRIPTION
+ *      Looks up the xref entry for the given address.
+ *
+ * RETURNS
+ *      Pointer to entry if found, else NULL.
+ *
+ ************************************************************/
+
+static struct xref * index_find( ADDR ref )
+{
+    size_t i;
+
+    if ( !xref_index )
+        return NULL;
+
+    for ( i = INDEX_HASH( ref );
+          xref_index[i] != NULL;
+          i = ( i + 1 ) & ( index_size - 1 ) )
+        if ( xref_index[i]->ref == ref )
+            return xref_index[i];
+
+    return NULL;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      index_grow
+ *
+ * DESCRIPTION
+ *      Rebuilds the address index with the given number of
+ *       slots (a power of 2).
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void index_insert( struct xref *p );
+
+static void index_grow( size_t size )
+{
+    struct xref **old = xref_index;
+    size_t oldsize = index_size;
+    size_t i;
+
+    index_size = size;
+    xref_index = zalloc( index_size * sizeof( struct xref * ) );
+    for ( index_shift = 32; ( (size_t)1 << ( 32 - index_shift ) ) < size; index_shift-- )
+        ;
+    index_used = 0;
+
+    for ( i = 0; i < oldsize; i++ )
+        if ( old[i] )
+            index_insert( old[i] );
+
+    free( old );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      index_insert
+ *
+ * DESCRIPTION
+ *      Adds a new xref entry to the address index, growing
+ *       the index to keep it no more than half full.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void index_insert( struct xref *p )
+{
+    size_t i;
+
+    if ( ( index_used + 1 ) * 2 > index_size )
+        index_grow( index_size ? index_size * 2 : INDEX_INIT_SIZE );
+
+    for ( i = INDEX_HASH( p->ref );
+          xref_index[i] != NULL;
+          i = ( i + 1 ) & ( index_size - 1 ) )
+        ;
+
+    xref_index[i] = p;
+    index_used++;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      new_xref
+ *
+ * DESCRIPTION
+ *      Creates a new, empty xref entry for the given address
+ *       and adds it to the index.
+ *
+ * RETURNS
+ *      Pointer to new entry.
+ *
+ ************************************************************/
+
+static struct xref * new_xref( ADDR ref )
+{
+    struct xref *p = arena_alloc( sizeof( struct xref ) );
+
+    p->ref = ref;
+    index_insert( p );
+
+    return p;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      new_addrlist
+ *
+ * DESCRIPTION
+ *      Allocates an address list node from the arena.
+ *
+ * RETURNS
+ *      Pointer to new node.
+ *
+ ************************************************************/
+
+static struct addrlist * new_addrlist( void )
+{
+    return arena_alloc( sizeof( struct addrlist ) );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmp_xref
+ *
+ * DESCRIPTION
+ *      qsort() comparison of two xref entry pointers by
+ *       referenced address.
+ *
+ * RETURNS
+ *      <0, 0, >0
+ *
+ ************************************************************/
+
+static int cmp_xref( const void *a, const void *b )
+{
+    ADDR ra = (*(struct xref * const *)a)->ref;
+    ADDR rb = (*(struct xref * const *)b)->ref;
+
+    return ( ra > rb ) - ( ra < rb );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      sorted_entries
+ *
+ * DESCRIPTION
+ *      Gathers pointers to the xref entries from the index
+ *       in address order.  The entries themselves are not
+ *       copied.  The caller frees the array.
+ *
+ * RETURNS
+ *      Array of entry pointers, number of entries in *n
+ *
+ ************************************************************/
+
+static struct xref ** sorted_entries( size_t *n )
+{
+    struct xref **sorted;
+    size_t k;
+
+    *n = 0;
+    sorted = zalloc( ( index_used + 1 ) * sizeof( struct xref * ) );
+    for ( k = 0; k < index_size; k++ )
+        if ( xref_index[k] )
+            sorted[(*n)++] = xref_index[k];
+    qsort( sorted, *n, sizeof( struct xref * ), cmp_xref );
+
+    return sorted;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      type_name
+ *
+ * DESCRIPTION
+ *      Names an xref type for export.
+ *
+ * RETURNS
+ *      Name of type, or NULL if not a valid type
+ *
+ ************************************************************/
+
+static const char * type_name( XREF_TYPE type )
+{
+    static const char * const names[] = {
+        "jump", "call", "imm", "table", "direct", "data", "ptr", "reg", "io"
+    };
+
+    if ( type < X_JMP || type > X_IO )
+        return NULL;
+
+    return names[type];
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      put_u32
+ *
+ * DESCRIPTION
+ *      Writes a 32-bit value, least significant byte first.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void put_u32( FILE *fp, ULWORD v )
+{
+    putc( v & 0xFF, fp );
+    putc( ( v >> 8 ) & 0xFF, fp );
+    putc( ( v >> 16 ) & 0xFF, fp );
+    putc( ( v >> 24 ) & 0xFF, fp );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      put_quoted
+ *
+ * DESCRIPTION
+ *      Writes a label as a JSON string, or as a CSV field
+ *       quoted if it needs to be.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void put_quoted( FILE *fp, const char *s, XREF_FORMAT format )
+{
+    if ( format == XREF_CSV )
+    {
+        if ( !strpbrk( s, ",\"\r\n" ) )
+        {
+            fputs( s, fp );
+            return;
+        }
+
+        putc( '"', fp );
+        for ( ; *s; s++ )
+        {
+            if ( *s == '"' )
+                putc( '"', fp );
+            putc( *s, fp );
+        }
+        putc( '"', fp );
+        return;
+    }
+
+    putc( '"', fp );
+    for ( ; *s; s++ )
+    {
+        if ( *s == '"' || *s == '\\' )
+            fprintf( fp, "\\%c", *s );
+        else if ( (unsigned char)*s < 0x20 )
+            fprintf( fp, "\\u%04x", (unsigned char)*s );
+        else
+            putc( *s, fp );
+    }
+    putc( '"', fp );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      cmp_rev
+ *
+ * DESCRIPTION
+ *      qsort() comparison of two references by source, then
+ *       by target address, then by type.
+ *
+ * RETURNS
+ *      <0, 0, >0
+ *
+ ************************************************************/
+
+static int cmp_rev( const void *a, const void *b )
+{
+    const struct xref_rev *ra = a, *rb = b;
+
+    if ( ra->source != rb->source )
+        return ( ra->source > rb->source ) - ( ra->source < rb->source );
+    if ( ra->target != rb->target )
+        return ( ra->target > rb->target ) - ( ra->target < rb->target );
+
+    return ( ra->type > rb->type ) - ( ra->type < rb->type );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      build_query_index
+ *
+ * DESCRIPTION
+ *      Builds the forward and reverse indexes for
+ *       xref_query(), once all the xrefs are in.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void build_query_index( void )
+{
+    struct addrlist *q;
+    size_t k, n = 0;
+
+    fwd_index = sorted_entries( &fwd_used );
+
+    for ( k = 0; k < fwd_used; k++ )
+        for ( q = fwd_index[k]->list; q != NULL; q = q->n )
+            n++;
+
+    rev_index = zalloc( ( n + 1 ) * sizeof( struct xref_rev ) );
+    for ( k = 0; k < fwd_used; k++ )
+        for ( q = fwd_index[k]->list; q != NULL; q = q->n )
+        {
+            rev_index[rev_used].source = q->addr;
+            rev_index[rev_used].target = fwd_index[k]->ref;
+            rev_index[rev_used].type   = q->type;
+            rev_index[rev_used].p      = fwd_index[k];
+            rev_used++;
+        }
+
+    qsort( rev_index, rev_used, sizeof( struct xref_rev ), cmp_rev );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      print_ref
+ *
+ * DESCRIPTION
+ *      Writes one reference found by xref_query().
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void print_ref( ADDR source, ADDR target, XREF_TYPE type, const char *label )
+{
+    out_addr( source );
+    out_str( " -> " );
+    out_addr( target );
+    out_str( "  " );
+    if ( label )
+    {
+        out_padstr( type_name( type ), -8 );
+        out_str( label );
+    }
+    else
+        out_str( type_name( type ) );
+    out_newline();
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      is_generated
+ *
+ * DESCRIPTION
+ *      Tests whether a label was generated by dasmxx rather
+ *       than given by the user.
+ *
+ * RETURNS
+ *      non-zero if generated
+ *
+ ************************************************************/
+
+static int is_generated( const char *label )
+{
+    return strncmp( label, GEN_LABEL_PREFIX, strlen( GEN_LABEL_PREFIX ) ) == 0;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      sort_labels
+ *
+ * DESCRIPTION
+ *      Sorts a batch of labels into address order.  The sort
+ *       is a stable merge sort, so labels for the same
+ *       address stay in the order they were given.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+static void sort_labels( xref_label_t *labels, size_t n )
+{
+    xref_label_t *a = labels, *b, *t;
+    size_t width, i, j, k, lo, mid, hi;
+
+    for ( i = 1; i < n && a[i - 1].ref <= a[i].ref; i++ )
+        ;
+    if ( i >= n )
+        return;
+
+    b = zalloc( n * sizeof( xref_label_t ) );
+
+    for ( width = 1; width < n; width *= 2 )
+    {
+        for ( lo = 0; lo < n; lo += 2 * width )
+        {
+            mid = MIN( lo + width, n );
+            hi  = MIN( lo + 2 * width, n );
+
+            for ( i = lo, j = mid, k = lo; k < hi; k++ )
+            {
+                if ( i < mid && ( j >= hi || a[i].ref <= a[j].ref ) )
+                    b[k] = a[i++];
+                else
+                    b[k] = a[j++];
+            }
+        }
+        t = a; a = b; b = t;
+    }
+
+    if ( a != labels )
+    {
+        memcpy( labels, a, n * sizeof( xref_label_t ) );
+        b = a;
+    }
+    free( b );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      query_addr
+ *
+ * DESCRIPTION
+ *      Reads a hex address, which may be banked (BB:XXXX),
+ *       from a query, moving *s past it.
+ *
+ * RETURNS
+ *      1 if there was an address, else 0
+ *
+ ************************************************************/
+
+static int query_addr( const char **s, unsigned long *addr )
+{
+    char *end;
+
+    *addr = strtoul( *s, &end, 16 );
+    if ( end == *s )
+        return 0;
+
+    if ( *end == ':' && isxdigit( (unsigned char)end[1] ) )
+    {
+        unsigned long bank = *addr;
+
+        *addr = strtoul( end + 1, &end, 16 );
+        if ( bank > BANK_MAX || *addr >= ( 1ul << BANK_SHIFT ) )
+            return 0;
+        *addr = BANK_ADDR( bank, *addr );
+    }
+
+    *s = end;
+    return 1;
+}
 
 /*****************************************************************************
  *        Public Functions
@@ -77,56 +604,25 @@ struct xref *xref = NULL;
  *
  ************************************************************/
 
- void xref_addxref( int type, ADDR addr, ADDR ref )
+void xref_addxref( int type, ADDR addr, ADDR ref )
 {
     struct xref     *p;
-    struct xref     *q;
     struct addrlist *new;
     
     if ( type == X_NONE )
         return;
     
     /* Create new address reference entry */
-    new = zalloc( sizeof( struct addrlist ) );
+    new = new_addrlist();
     
     new->addr = addr;
     new->type = type;
 
-    p = xref;
-    q = NULL;
-    
-    /* Find entry in list for xref */
-    
-    while ( p != NULL && ref > p->ref )
-    {
-        q = p;
-        p = p->n;
-    }
+    if ( ( p = index_find( ref ) ) == NULL )
+        p = new_xref( ref );
 
-    if ( p != NULL && ref == p->ref)  /* new addr for ref */
-    {
-        new->n  = p->list;
-        p->list = new;
-    }
-    else /* insert */
-    {
-        new->n = NULL;
-        
-        if ( q == NULL )
-        {
-            q = zalloc( sizeof( struct xref ) );
-            xref = q;
-        }
-        else
-        {
-            q->n = zalloc( sizeof( struct xref ) );
-            q = q->n;
-        }
-        q->n    = p;
-        q->list = new;
-        q->label= NULL;
-        q->ref  = ref;
-    }
+    new->n  = p->list;
+    p->list = new;
 }
 
 /***********************************************************
@@ -136,59 +632,89 @@ struct xref *xref = NULL;
  *
  * DESCRIPTION
  *      Adds the given xref to the xref list with the given
- *       label.
- *      Must make a copy of label string.
+ *       label.  Giving the same label again is harmless.
+ *      The label string is interned, so the caller keeps
+ *       its own copy.
  *
  * RETURNS
- *      void
+ *      The interned copy of label, whether or not it was
+ *       used.
  *
  ************************************************************/
 
-void xref_addxreflabel( ADDR ref, char *label )
+char * xref_addxreflabel( ADDR ref, char *label )
 {
     struct xref     *p;
-    struct xref     *q;
-    struct addrlist *new;
-    
-    p = xref;
-    q = NULL;
-    
-    /* Find entry in list for xref */
-    
-    while ( p != NULL && ref > p->ref )
-    {
-        q = p;
-        p = p->n;
-    }
 
-    if ( p != NULL && ref == p->ref)  /* new label for ref */
+    label = arena_intern( label );
+    
+    if ( ( p = index_find( ref ) ) != NULL )  /* new label for ref */
     {
         if ( p->label )
         {
-            if ( strncmp( p->label, GEN_LABEL_PREFIX, strlen( GEN_LABEL_PREFIX ) ) )
+            if ( p->label == label )
+                return label;
+            if ( p->imported && is_generated( label ) )
+                return label;
+            if ( !p->imported && !is_generated( p->label ) )
                 error( "multiple labels for same address (0x%X) (was: %s, new:%s)", ref, p->label, label );
-            else
-                free( p->label );
         }
-        
-        p->label = dupstr( label );
     }
     else /* insert */
+        p = new_xref( ref );
+
+    p->label    = label;
+    p->imported = 0;
+
+    return label;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_addlabels
+ *
+ * DESCRIPTION
+ *      Adds a batch of imported labels, such as a symbol
+ *       table.  The batch is sorted by address once and
+ *       the index grown once to fit it.  Of several labels
+ *       for one address the first in the batch is used.
+ *      An imported label never replaces a label that is
+ *       already there, other than a generated one, and is
+ *       itself replaced by any later label from the
+ *       command file.  The labels array is sorted in place.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void xref_addlabels( xref_label_t *labels, size_t n )
+{
+    struct xref *p;
+    size_t i, size;
+
+    sort_labels( labels, n );
+
+    for ( size = index_size ? index_size : INDEX_INIT_SIZE;
+          ( index_used + n ) * 2 > size;
+          size *= 2 )
+        ;
+    if ( size != index_size )
+        index_grow( size );
+
+    for ( i = 0; i < n; i++ )
     {
-        if ( q == NULL )
-        {
-            q = zalloc( sizeof( struct xref ) );
-            xref = q;
-        }
-        else
-        {
-            q->n = zalloc( sizeof( struct xref ) );
-            q = q->n;
-        }
-        q->n     = p;
-        q->ref   = ref;
-        q->list  = NULL;
-        q->label = dupstr( label );
+        if ( i > 0 && labels[i].ref == labels[i - 1].ref )
+            continue;
+
+        if ( ( p = index_find( labels[i].ref ) ) == NULL )
+            p = new_xref( labels[i].ref );
+        else if ( p->label && ( p->imported || !is_generated( p->label ) ) )
+            continue;
+
+        p->label    = arena_intern( labels[i].label );
+        p->imported = 1;
     }
 }
 
@@ -208,13 +734,95 @@ void xref_addxreflabel( ADDR ref, char *label )
 
 char * xref_findaddrlabel( ADDR addr )
 {
-    struct xref *p;
+    struct xref *p = index_find( addr );
     
-    for ( p = xref; p != NULL; p = p->n )
-        if ( p->ref == addr && p->label != NULL )
-            return p->label;
+    return p ? p->label : NULL;
+}
 
-    return NULL;
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_setbanks
+ *
+ * DESCRIPTION
+ *      Makes the address space banked, with the CPU addresses
+ *       lo to hi inclusive as the banked window.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void xref_setbanks( ADDR lo, ADDR hi )
+{
+    banked  = 1;
+    bank_lo = lo;
+    bank_hi = hi;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_banked
+ *
+ * DESCRIPTION
+ *      Tests whether the address space is banked.
+ *
+ * RETURNS
+ *      1 if banked, else 0
+ *
+ ************************************************************/
+
+int xref_banked( void )
+{
+    return banked;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_bankref
+ *
+ * DESCRIPTION
+ *      Qualifies a reference with its bank.  Decoders know
+ *       nothing of banks, so a reference made from a bank to
+ *       a bare CPU address in the banked window is taken to
+ *       be to the same bank.  References to common memory and
+ *       those that already have a bank are left alone.
+ *
+ * RETURNS
+ *      the bank-qualified reference
+ *
+ ************************************************************/
+
+ADDR xref_bankref( ADDR from, ADDR ref )
+{
+    if ( banked && BANK_OF( ref ) == 0 && ref >= bank_lo && ref <= bank_hi )
+        return BANK_ADDR( BANK_OF( from ), ref );
+
+    return ref;
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_crossbank
+ *
+ * DESCRIPTION
+ *      Tests whether a reference goes from outside the banked
+ *       window into it, so that its target depends on which
+ *       bank is mapped in when it is made.
+ *
+ * RETURNS
+ *      1 if so, else 0
+ *
+ ************************************************************/
+
+int xref_crossbank( ADDR from, ADDR ref )
+{
+    ADDR f = BANK_CPU( from ), r = BANK_CPU( ref );
+
+    return banked && ( f < bank_lo || f > bank_hi ) && r >= bank_lo && r <= bank_hi;
 }
 
 /***********************************************************
@@ -225,29 +833,27 @@ char * xref_findaddrlabel( ADDR addr )
  * DESCRIPTION
  *      Generates a word address, either as hex or, if in
  *       the xref list and is labelled, then the label.
+ *      The address is referred to from the byte address from,
+ *       which gives the bank of an address in the banked
+ *       window (see xref_bankref()).
+ *      Nothing is allocated: the hex is written into buf,
+ *       which is size bytes long.  XREF_WORDADDR() supplies
+ *       a buffer that lasts until the end of the block.
  *
  * RETURNS
- *      ptr to allocated string buffer
+ *      ptr to the label or to buf
  *
  ************************************************************/
 
-char * xref_genwordaddr( char * buf, const char * format, ADDR addr )
+char * xref_genwordaddr( char * buf, size_t size, const char * format, ADDR addr, ADDR from )
 {
-    char * label = xref_findaddrlabel( addr * dasm_word_width_bytes );
+    char * label = xref_findaddrlabel( xref_bankref( from, addr * dasm_word_width_bytes ) );
 
     if ( label )
         return label;
     
     /* Either xref not found or not labelled */
- 
-    if ( buf )
-        sprintf( buf, format, addr );
-    else
-    {
-        char local[256];
-        sprintf( local, format, addr );
-        buf = dupstr(local);	
-    }
+    snprintf( buf, size, format, banked ? BANK_CPU( addr ) : addr );
     
     return buf;
 }
@@ -267,50 +873,306 @@ char * xref_genwordaddr( char * buf, const char * format, ADDR addr )
 
 void xref_dump( void )
 {
-    struct xref *p;
+    struct xref **sorted, *p;
     struct addrlist *q;
+    size_t k, n;
 
-    printf( "\n\nXREFS :\n\n---------------------------\n" );
-    for ( p = xref; p != NULL; p = p->n )
+    sorted = sorted_entries( &n );
+
+    out_str( "\n\nXREFS :\n\n---------------------------\n" );
+    for ( k = 0; k < n; k++ )
     {
 	int i = 0;
 
+	p = sorted[k];
+
 	if ( !p->list )
 	    continue;
 
 	for (q = p->list; q != NULL; q = q->n )
 	{
 	    if ( i++ == 0 )
-	        printf( FORMAT_ADDR ": ", p->ref );
+	    {
+	        out_addr( p->ref );
+	        out_str( ": " );
+	    }
 	    else
-	        printf( "      " );
+	        out_spaces( 6 );
 
 	    switch( q->type )
 	    {
-		case X_JMP    : printf( "Jump   @ " ); break;
-		case X_CALL   : printf( "Call   @ " ); break;
-		case X_IMM    : printf( "Imm    @ " ); break;
-		case X_TABLE  : printf( "Table  @ " ); break;
-		case X_DIRECT : printf( "Direct @ " ); break;
-		case X_DATA   : printf( "Data   @ " ); break;
-		case X_PTR    : printf( "Ptr    @ " ); break;
-		case X_REG    : printf( "Reg    @ " ); break;
-		case X_IO     : printf( "IO     @ " ); break;
+		case X_JMP    : out_str( "Jump   @ " ); break;
+		case X_CALL   : out_str( "Call   @ " ); break;
+		case X_IMM    : out_str( "Imm    @ " ); break;
+		case X_TABLE  : out_str( "Table  @ " ); break;
+		case X_DIRECT : out_str( "Direct @ " ); break;
+		case X_DATA   : out_str( "Data   @ " ); break;
+		case X_PTR    : out_str( "Ptr    @ " ); break;
+		case X_REG    : out_str( "Reg    @ " ); break;
+		case X_IO     : out_str( "IO     @ " ); break;
 		default:
-		    printf( "\nILLEGAL XREF TYPE %d, addr=" FORMAT_ADDR ". Aborting..\n",
-		    q->type, q->addr );
+		    out_printf( "\nILLEGAL XREF TYPE %d, addr=" FORMAT_ADDR ". Aborting..\n",
+		    q->type, ADDR_DIGITS, q->addr );
+		    free( sorted );
 		    return;
 	    }
-	    printf( FORMAT_ADDR, q->addr );
+	    out_addr( q->addr );
 	    if ( p->label && i == 1 )
-	        printf( "   (%s)", p->label );
-	    putchar( '\n' );
+	    {
+	        out_str( "   (" );
+	        out_str( p->label );
+	        out_char( ')' );
+	    }
+	    out_char( '\n' );
 	}
-	putchar( '\n' );
+	out_char( '\n' );
+    }
+    out_str( "---------------------------\n\n" );
+    free( sorted );
+}
+
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_export
+ *
+ * DESCRIPTION
+ *      Writes the xref database to the named file ("-" for
+ *       stdout) as JSON Lines, CSV or fixed-size binary
+ *       records, one record per reference, in target
+ *       address order.  Records are written straight out
+ *       as the lists are walked; only an array of entry
+ *       pointers is built, to sort the targets.
+ *      Addresses are written as the CPU address and its bank,
+ *       which is 0 unless the address space is banked.  JSON
+ *       Lines leaves the banks out unless it is banked.
+ *      The binary format is a 16-byte header ("DASMXREF",
+ *       then the version and record size as 32-bit values)
+ *       followed by records of five 32-bit values: target,
+ *       source, type, target bank and source bank.  All
+ *       values are little-endian.  Labels are not included
+ *       in the binary format.
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+#define XREF_BIN_VERSION    ( 2 )
+#define XREF_BIN_RECSIZE    ( 20 )
+
+void xref_export( XREF_FORMAT format, const char *filename )
+{
+    static char fbuf[65536];
+    struct xref **sorted, *p;
+    struct addrlist *q;
+    size_t k, n;
+    ADDR tcpu, tbank, scpu, sbank;
+    FILE *fp;
+
+    if ( strcmp( filename, "-" ) == 0 )
+    {
+        out_flush();
+        fp = stdout;
+    }
+    else
+    {
+        if ( ( fp = fopen( filename, format == XREF_BIN ? "wb" : "w" ) ) == NULL )
+            error( "Failed to open xref export file \"%s\"", filename );
+        setvbuf( fp, fbuf, _IOFBF, sizeof( fbuf ) );
+    }
+
+    if ( format == XREF_CSV )
+        fputs( "target,source,type,label,target_bank,source_bank\n", fp );
+    else if ( format == XREF_BIN )
+    {
+        fwrite( "DASMXREF", 1, 8, fp );
+        put_u32( fp, XREF_BIN_VERSION );
+        put_u32( fp, XREF_BIN_RECSIZE );
+    }
+
+    sorted = sorted_entries( &n );
+
+    for ( k = 0; k < n; k++ )
+    {
+        p     = sorted[k];
+        tcpu  = banked ? BANK_CPU( p->ref ) : p->ref;
+        tbank = banked ? BANK_OF( p->ref ) : 0;
+
+        for ( q = p->list; q != NULL; q = q->n )
+        {
+            const char *type = type_name( q->type );
+
+            if ( !type )
+                error( "Illegal xref type %d, addr=" FORMAT_ADDR, q->type, ADDR_DIGITS, q->addr );
+
+            scpu  = banked ? BANK_CPU( q->addr ) : q->addr;
+            sbank = banked ? BANK_OF( q->addr ) : 0;
+
+            switch ( format )
+            {
+            case XREF_JSONL:
+                fprintf( fp, "{\"target\":%u,\"source\":%u,\"type\":\"%s\"",
+                         tcpu, scpu, type );
+                if ( p->label )
+                {
+                    fputs( ",\"label\":", fp );
+                    put_quoted( fp, p->label, format );
+                }
+                if ( banked )
+                    fprintf( fp, ",\"target_bank\":%u,\"source_bank\":%u", tbank, sbank );
+                fputs( "}\n", fp );
+                break;
+
+            case XREF_CSV:
+                fprintf( fp, "%u,%u,%s,", tcpu, scpu, type );
+                if ( p->label )
+                    put_quoted( fp, p->label, format );
+                fprintf( fp, ",%u,%u\n", tbank, sbank );
+                break;
+
+            case XREF_BIN:
+                put_u32( fp, tcpu );
+                put_u32( fp, scpu );
+                put_u32( fp, q->type );
+                put_u32( fp, tbank );
+                put_u32( fp, sbank );
+                break;
+            }
+        }
     }
-    puts( "---------------------------\n" );
+
+    free( sorted );
+
+    if ( fp == stdout )
+        fflush( fp );
+    else if ( fclose( fp ) != 0 )
+        error( "Failed to write xref export file \"%s\"", filename );
 }
  
+/***********************************************************
+ *
+ * FUNCTION
+ *      xref_query
+ *
+ * DESCRIPTION
+ *      Answers a query on the xref database, writing each
+ *       matching reference as "source -> target type label".
+ *      The query is
+ *          [type:][from:]lo[-hi]
+ *       with hex addresses, which may be banked (BB:XXXX).  Without "from:" it finds the
+ *       references to targets in lo..hi, in target order;
+ *       with it, the references made from sources in lo..hi,
+ *       in source order.  type limits the references to one
+ *       type (jump, call, imm, table, direct, data, ptr, reg
+ *       or io).
+ *
+ * RETURNS
+ *      void
+ *
+ ************************************************************/
+
+void xref_query( const char *spec )
+{
+    const char *s = spec;
+    char *end;
+    XREF_TYPE type = X_NONE;
+    int from = 0;
+    unsigned long lo, hi;
+    size_t i, n;
+
+    /* Prefixes */
+    while ( ( end = strchr( s, ':' ) ) != NULL )
+    {
+        size_t len = (size_t)( end - s );
+        int t;
+
+        if ( len == 4 && strncmp( s, "from", 4 ) == 0 )
+            from = 1;
+        else
+        {
+            for ( t = X_JMP; t <= X_IO; t++ )
+                if ( strlen( type_name( t ) ) == len && strncmp( s, type_name( t ), len ) == 0 )
+                    break;
+            if ( t > X_IO && strspn( s, "0123456789abcdefABCDEF" ) == len )
+                break;  /* Bank of a banked address */
+            if ( t > X_IO )
+                error( "Unknown xref type in query `%s'", spec );
+            type = (XREF_TYPE)t;
+        }
+        s = end + 1;
+    }
+
+    /* Address range */
+    if ( !query_addr( &s, &lo ) )
+        error( "Missing address in query `%s'", spec );
+    hi = lo;
+    if ( *s == '-' )
+    {
+        s++;
+        if ( !query_addr( &s, &hi ) )
+            error( "Missing end address in query `%s'", spec );
+    }
+    end = (char *)s;
+    if ( *end || hi < lo )
+        error( "Bad address range in query `%s'", spec );
+
+    if ( !fwd_index )
+        build_query_index();
+
+    out_printf( "%s query %s", COMMENT_DELIM, spec );
+    out_newline();
+
+    if ( from )
+    {
+        /* First reference from lo or above */
+        for ( i = 0, n = rev_used; n > 0; )
+        {
+            size_t half = n / 2;
+
+            if ( rev_index[i + half].source < lo )
+            {
+                i += half + 1;
+                n -= half + 1;
+            }
+            else
+                n = half;
+        }
+
+        for ( ; i < rev_used && rev_index[i].source <= hi; i++ )
+            if ( type == X_NONE || rev_index[i].type == type )
+                print_ref( rev_index[i].source, rev_index[i].target,
+                           rev_index[i].type, rev_index[i].p->label );
+    }
+    else
+    {
+        /* First target at lo or above */
+        for ( i = 0, n = fwd_used; n > 0; )
+        {
+            size_t half = n / 2;
+
+            if ( fwd_index[i + half]->ref < lo )
+            {
+                i += half + 1;
+                n -= half + 1;
+            }
+            else
+                n = half;
+        }
+
+        for ( ; i < fwd_used && fwd_index[i]->ref <= hi; i++ )
+        {
+            struct addrlist *q;
+
+            for ( q = fwd_index[i]->list; q != NULL; q = q->n )
+                if ( type == X_NONE || q->type == type )
+                    print_ref( q->addr, fwd_index[i]->ref, q->type, fwd_index[i]->label );
+        }
+    }
+
+    out_newline();
+}
+
 /******************************************************************************/
 /******************************************************************************/
 /******************************************************************************/
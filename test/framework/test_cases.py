@@ -33,6 +33,7 @@ class TestCase:
         golden_file: Optional path to golden/expected output file
         expected_patterns: Optional list of regex patterns to check in output
         flags: Optional list of command-line flags to pass to disassembler
+        capture_stderr: Append the disassembler's warnings to the output
         verification_mode: How to verify the output
         description: Optional test description
         metadata: Optional metadata for the test
@@ -44,6 +45,7 @@ class TestCase:
     golden_file: Optional[Path] = None
     expected_patterns: Optional[List[str]] = None
     flags: List[str] = field(default_factory=list)
+    capture_stderr: bool = False
     verification_mode: VerificationMode = VerificationMode.EXACT
     description: Optional[str] = None
     metadata: Dict[str, Any] = field(default_factory=dict)
@@ -112,7 +114,8 @@ class TestSuiteBuilder:
                  expected_patterns: Optional[List[str]] = None,
                  flags: Optional[List[str]] = None,
                  verification_mode: VerificationMode = VerificationMode.EXACT,
-                 description: Optional[str] = None) -> 'TestSuiteBuilder':
+                 description: Optional[str] = None,
+                 capture_stderr: bool = False) -> 'TestSuiteBuilder':
         """
         Add a test to the suite.
 
@@ -133,6 +136,7 @@ class TestSuiteBuilder:
             golden_file=golden_path,
             expected_patterns=expected_patterns,
             flags=flags or [],
+            capture_stderr=capture_stderr,
             verification_mode=verification_mode,
             description=description
         )
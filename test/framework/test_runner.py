@@ -67,9 +67,11 @@ class TestRunner:
                         processor: str,
                         command_file: Path,
                         output_file: Path,
-                        flags: List[str] = None) -> Tuple[bool, str]:
+                        flags: List[str] = None,
+                        capture_stderr: bool = False) -> Tuple[bool, str]:
         """
         Run a disassembler with the given command file and flags.
+        With capture_stderr the warnings follow the listing in the output.
 
         Returns (success, error_message)
         """
@@ -96,7 +98,7 @@ class TestRunner:
             )
 
             # Write stdout to output file
-            output_file.write_text(result.stdout)
+            output_file.write_text(result.stdout + (result.stderr if capture_stderr else ""))
 
             if result.returncode != 0:
                 return False, f"Disassembler failed with code {result.returncode}: {result.stderr}"
@@ -120,7 +122,8 @@ class TestRunner:
             test.processor,
             test.command_file,
             test.output_file,
-            test.flags
+            test.flags,
+            test.capture_stderr
         )
 
         if not success:
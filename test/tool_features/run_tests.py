@@ -122,6 +122,189 @@ def create_tool_feature_tests():
         description="Test -s flag for stripped output"
     )
 
+    builder.add_test(
+        name="Parallel rendering",
+        processor="z80",
+        command_file="data_dumps/test_mixed.dz80",
+        golden_file="golden/test_mixed.golden",
+        flags=["-j", "4"],
+        description="Test -j flag gives the same listing as a serial run"
+    )
+
+    builder.add_test(
+        name="Duplicate command addresses",
+        processor="z80",
+        command_file="code_commands/test_duplicate.dz80",
+        golden_file="golden/test_duplicate.golden",
+        capture_stderr=True,
+        description="Test the last of several commands for one address is used, with a warning"
+    )
+
+    builder.add_test(
+        name="Duplicate banked command addresses",
+        processor="z80",
+        command_file="code_commands/test_duplicate_banked.dz80",
+        golden_file="golden/test_duplicate_banked.golden",
+        capture_stderr=True,
+        description="Test the duplicate command warning gives a banked address as BB:XXXX"
+    )
+
+    builder.add_test(
+        name="Banked xref export",
+        processor="z80",
+        command_file="code_commands/test_banked.dz80",
+        golden_file="golden/test_banked_export.golden",
+        flags=["-X", "jsonl:-"],
+        description="Test -X gives the bank of each address separately from the CPU address"
+    )
+
+    builder.add_test(
+        name="Code discovery",
+        processor="z80",
+        command_file="code_commands/test_discover.dz80",
+        golden_file="golden/test_discover.golden",
+        flags=["-d"],
+        description="Test -d flag writes a command list of the reachable code"
+    )
+
+    builder.add_test(
+        name="Code discovery on the 68000",
+        processor="68k",
+        command_file="code_commands/test_discover_68k.d68k",
+        golden_file="golden/test_discover_68k.golden",
+        flags=["-d"],
+        description="Test -d follows both arms of a BEQ and stops at BRA and RTS on a second CPU"
+    )
+
+    builder.add_test(
+        name="Parallel code discovery",
+        processor="z80",
+        command_file="code_commands/test_discover.dz80",
+        golden_file="golden/test_discover.golden",
+        flags=["-d", "-j", "4"],
+        description="Test -d with -j finds the same code as a serial run"
+    )
+
+    builder.add_test(
+        name="Parallel discovery from several roots",
+        processor="z80",
+        command_file="code_commands/test_discover_roots.dz80",
+        golden_file="golden/test_discover_roots.golden",
+        flags=["-d", "-j", "8"],
+        description="Test -d with -j shares several entry points between threads"
+    )
+
+    builder.add_test(
+        name="Command cache",
+        processor="z80",
+        command_file="data_dumps/test_mixed.dz80",
+        golden_file="golden/test_mixed.golden",
+        flags=["-c", "../output/test_mixed.cache"],
+        description="Test -c flag writes a cache of the command file"
+    )
+
+    builder.add_test(
+        name="Command cache reuse",
+        processor="z80",
+        command_file="data_dumps/test_mixed.dz80",
+        golden_file="golden/test_mixed.golden",
+        flags=["-c", "../output/test_mixed.cache"],
+        description="Test -c flag gives the same listing from the cache"
+    )
+
+    builder.add_test(
+        name="Symbol import",
+        processor="z80",
+        command_file="code_commands/test_symbols.dz80",
+        golden_file="golden/test_symbols.golden",
+        description="Test y command imports labels, command file labels win"
+    )
+
+    builder.add_test(
+        name="Xref export",
+        processor="z80",
+        command_file="code_commands/test_symbols.dz80",
+        golden_file="golden/test_xref_export.golden",
+        flags=["-X", "jsonl:-"],
+        description="Test -X flag writes the xrefs as JSON Lines after the listing"
+    )
+
+    builder.add_test(
+        name="Xref query",
+        processor="z80",
+        command_file="code_commands/test_symbols.dz80",
+        golden_file="golden/test_xref_query.golden",
+        flags=["-q", "10", "-q", "call:0-FFFF", "-q", "from:0-5"],
+        description="Test -q flag answers target, type and source queries"
+    )
+
+    builder.add_test(
+        name="Xref query of an overrun procedure",
+        processor="z80",
+        command_file="code_commands/test_query_overrun.dz80",
+        golden_file="golden/test_query_overrun.golden",
+        flags=["-q", "from:0-F"],
+        description="Test -q decodes a p entry inside the previous insn as the listing does"
+    )
+
+    builder.add_test(
+        name="Intel HEX input",
+        processor="z80",
+        command_file="code_commands/test_hex.dz80",
+        golden_file="golden/test_hex.golden",
+        description="Test loading an Intel HEX file with gaps between records"
+    )
+
+    builder.add_test(
+        name="ELF input",
+        processor="z80",
+        command_file="code_commands/test_elf.dz80",
+        golden_file="golden/test_elf.golden",
+        description="Test loading ELF segments, symbols and entry point"
+    )
+
+    builder.add_test(
+        name="Multiple input files",
+        processor="z80",
+        command_file="code_commands/test_multi_input.dz80",
+        golden_file="golden/test_multi_input.golden",
+        description="Test input files at load addresses and in byte lanes"
+    )
+
+    builder.add_test(
+        name="Banked address space",
+        processor="z80",
+        command_file="code_commands/test_banked.dz80",
+        golden_file="golden/test_banked.golden",
+        flags=["-x"],
+        description="Test bank-qualified addresses, labels and xrefs"
+    )
+
+    builder.add_test(
+        name="68000 branch targets",
+        processor="68k",
+        command_file="code_commands/test_branch_68k.d68k",
+        golden_file="golden/test_branch_68k.golden",
+        description="Test 68000 branch targets are word addresses, or their labels"
+    )
+
+    builder.add_test(
+        name="68000 JMP and JSR",
+        processor="68k",
+        command_file="code_commands/test_jump_68k.d68k",
+        golden_file="golden/test_jump_68k.golden",
+        description="Test 68000 JMP and JSR in each control addressing mode"
+    )
+
+    builder.add_test(
+        name="Wide addresses",
+        processor="68k",
+        command_file="data_dumps/test_wide_addr.d68k",
+        golden_file="golden/test_wide_addr.golden",
+        flags=["-x"],
+        description="Test 24-bit listing addresses and 32-bit vectors"
+    )
+
     return builder.build()
 
 